@@ -2,6 +2,8 @@
 #include "globals.h"
 #include "opengl.h"
 #include "ecs-entity.h"
+#include "transform.h"
+#include "materials.h"
 
 void setTransformData(Entity* entity,vec3 position,vec3 scale,vec3 rotation){
     entity->transformComponent->active = 1;
@@ -11,10 +13,47 @@ void setTransformData(Entity* entity,vec3 position,vec3 scale,vec3 rotation){
     entity->transformComponent->scale[0] = scale[0];
     entity->transformComponent->scale[1] = scale[1];
     entity->transformComponent->scale[2] = scale[2];
-    entity->transformComponent->rotation[0] = rotation[0] * M_PI / 180.0f; // convert to radians
-    entity->transformComponent->rotation[1] = rotation[1] * M_PI / 180.0f;
-    entity->transformComponent->rotation[2] = rotation[2] * M_PI / 180.0f;
-    entity->transformComponent->modelNeedsUpdate = 1;
+    transform_setEulerRotation(entity->transformComponent, DEG_TO_RAD(rotation[0]), DEG_TO_RAD(rotation[1]), DEG_TO_RAD(rotation[2]));
+    transform_markDirty(entity->transformComponent);
+}
+/**
+ * @brief Point the entity's material component at a material, saveMaterial first adds it to globals.materials.
+ * Without saveMaterial the caller sets materialComponent->materialIndex.
+ */
+static void setMeshMaterial(Entity* entity,Material* material,bool saveMaterial){
+    entity->materialComponent->active = 1;
+    entity->materialComponent->diffuse = material->diffuse;
+    entity->materialComponent->diffuseMapOpacity = material->diffuseMapOpacity;
+    // TODO: Implement these when we need them.
+   /*  if(!material->ambientMap){
+        // Clear flag
+        material->material_flags &= ~MATERIAL_AMBIENTMAP_ENABLED;
+        // ALT: Toggle the flag: flags ^= FLAG_ENABLED;
+    }
+    if(!material->shininessMap){
+        material->material_flags &= ~MATERIAL_SHININESSMAP_ENABLED;
+    }
+    if(!material->specularMap){
+        material->material_flags &= ~MATERIAL_SPECULARMAP_ENABLED;
+    } */
+    if(material->diffuseMap == 0){ //|| material->diffuseMapOpacity == 0.0
+        material->material_flags &= ~MATERIAL_DIFFUSEMAP_ENABLED; 
+    }
+    if(saveMaterial){
+        entity->materialComponent->materialIndex = addMaterial(*material);
+    }
+}
+
+/**
+ * @brief Registry handle for a UI material. UI elements are built from a few named materials (see assets.c),
+ * each name is added once and later elements reuse its handle. Unnamed materials get an entry of their own.
+ */
+static int ui_materialHandle(Material* material){
+    if(material->diffuseMap == 0){
+        material->material_flags &= ~MATERIAL_DIFFUSEMAP_ENABLED;
+    }
+    int index = getMaterialByName(material->name);
+    return index >= 0 ? index : addMaterial(*material);
 }
 //----------------------------------------------------------------------------------------------//
 /**
@@ -131,6 +170,7 @@ void createMesh(
         entity->meshComponent->indices[i] = indices[i];
     }
     entity->meshComponent->indexCount = numIndicies;
+    entity->meshComponent->drawIndexed = numIndicies > 0;
 
    /*  if(numIndicies == 0){
         printf("not using indicies\n");
@@ -139,54 +179,39 @@ void createMesh(
     // transform data
     setTransformData(entity,position,scale,rotation);
 
-    // material data
-    entity->materialComponent->active = 1;
-    entity->materialComponent->ambient = material->ambient;
-    entity->materialComponent->diffuse = material->diffuse;
-    entity->materialComponent->specular = material->specular;
-    entity->materialComponent->shininess = material->shininess;
-    entity->materialComponent->diffuseMap = material->diffuseMap;
-    entity->materialComponent->diffuseMapOpacity = material->diffuseMapOpacity;
-    entity->materialComponent->specularMap = material->specularMap;
-    if(material->isPostProcessMaterial){
-        entity->materialComponent->isPostProcessMaterial = true;
-    }
-    if(saveMaterial){
-        entity->materialComponent->materialIndex = addMaterial(*material);
-    }else {
-        // TODO: temp fix for createObjects. The do not set shininess correctly atm.
-        entity->materialComponent->shininess = 32.0f;
-    }
-    // TODO: Implement these when we need them.
-   /*  if(!material->ambientMap){
-        // Clear flag
-        material->material_flags &= ~MATERIAL_AMBIENTMAP_ENABLED;
-        // ALT: Toggle the flag: flags ^= FLAG_ENABLED;
-    }
-    if(!material->shininessMap){
-        material->material_flags &= ~MATERIAL_SHININESSMAP_ENABLED;
-    }
-    if(!material->specularMap){
-        material->material_flags &= ~MATERIAL_SPECULARMAP_ENABLED;
-    } */
-    if(material->diffuseMap == 0){ //|| material->diffuseMapOpacity == 0.0
-        material->material_flags &= ~MATERIAL_DIFFUSEMAP_ENABLED; 
-    }
-    
-    entity->materialComponent->material_flags = material->material_flags;
+    setMeshMaterial(entity,material,saveMaterial);
  
     entity->meshComponent->gpuData->drawMode = drawMode;
     
-    setupMesh(  entity->meshComponent->vertices, 
-                entity->meshComponent->vertexCount, 
-                entity->meshComponent->indices, 
-                entity->meshComponent->indexCount,
-                entity->meshComponent->gpuData
-                );
+    uploadMesh(entity);
+}
+
+/**
+ * @brief Upload the mesh component's vertices/indices and pick the shader from the entity's other components.
+ * Expects meshComponent data and gpuData->drawMode to be set.
+ */
+void uploadMesh(Entity* entity){
+    MeshComponent* meshComponent = entity->meshComponent;
+    if(meshComponent->packedMesh != NULL){
+        setupPackedMesh(meshComponent->packedMesh, meshComponent->gpuData);
+    }else {
+        setupMesh(  meshComponent->vertices, 
+                    meshComponent->vertexCount, 
+                    meshComponent->indices, 
+                    meshComponent->indexCount,
+                    meshComponent->gpuData
+                    );
+    }
+    // Texture streaming sizes textures from these
+    if(meshComponent->vertices != NULL){
+        meshBounds(meshComponent->vertices, (int)meshComponent->vertexCount, &meshComponent->bounds, &meshComponent->texcoordExtent);
+    }else if(meshComponent->packedMesh != NULL){
+        packedMeshBounds(meshComponent->packedMesh, &meshComponent->bounds, &meshComponent->texcoordExtent);
+    }
     
     if(entity->lightComponent->active == 1){
         setupMaterial( entity->meshComponent->gpuData,"shaders/light_vertex.glsl", "shaders/light_fragment.glsl" );
-    }else if(entity->materialComponent->isPostProcessMaterial) {
+    }else if(getEntityMaterial(entity) != NULL && getEntityMaterial(entity)->isPostProcessMaterial) {
         //setupMaterial( entity->meshComponent->gpuData,"shaders/mesh_vertex.glsl", "shaders/mesh_fragment.glsl" );
         setupMaterial( entity->meshComponent->gpuData,"shaders/ui_vertex.glsl", "shaders/ui_fragment.glsl" );
         printf("post process mesh quad material id %d \n",entity->meshComponent->gpuData->shaderProgram);
@@ -207,20 +232,49 @@ void createMesh(
  * Create a object mesh
  * @param diffuse - color of the rectangle
 */
-void createObject(ObjData* obj,vec3 position,vec3 scale,vec3 rotation){
+Entity* createObject(ObjData* obj,vec3 position,vec3 scale,vec3 rotation){
     
-   // vertex data
-  //  int stride = 11;
-  
-    // NOT USED
-    GLuint indices[] = {
-        0, 1, 2,  // first triangle
-        1, 2, 3   // second triangle
-    }; 
-
     Entity* entity = addEntity(MODEL);
     
-    createMesh((GLfloat*)obj->vertexData,obj->num_of_vertices,indices,0,position,scale,rotation,&globals.materials[obj->materialIndex],GL_TRIANGLES,VERTS_COLOR_ONEUV,entity,false);
+    if(obj->packed.vertices != NULL){
+        // Already packed, by the mesh cache (gpu buffers are filled straight from the cache file, no cpu copy)
+        // or on a job thread by the loader (keeps the cpu copy for snapshots).
+        MeshComponent* meshComponent = entity->meshComponent;
+        meshComponent->active = 1;
+        meshComponent->packedMesh = &obj->packed;
+        meshComponent->vertices = obj->vertexData;
+        meshComponent->indices = obj->indices;
+        meshComponent->vertexCount = obj->num_of_vertices;
+        meshComponent->indexCount = obj->num_of_indices;
+        meshComponent->drawIndexed = true;
+        meshComponent->gpuData->vertexCount = obj->num_of_vertices;
+        meshComponent->gpuData->drawMode = GL_TRIANGLES;
+        setTransformData(entity,position,scale,rotation);
+        setMeshMaterial(entity,getMaterial(obj->materialIndex),false);
+        entity->materialComponent->materialIndex = obj->materialIndex;
+        uploadMesh(entity);
+        return entity;
+    }
+
+    // Deduplicated vertices from the obj loader, drawn indexed from compact vertices.
+    entity->meshComponent->gpuData->vertexLayout = VERTEX_LAYOUT_COMPACT;
+    entity->materialComponent->materialIndex = obj->materialIndex; // shared with every object using it
+    createMesh((GLfloat*)obj->vertexData,obj->num_of_vertices,obj->indices,obj->num_of_indices,position,scale,rotation,getMaterial(obj->materialIndex),GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,false);
+    return entity;
+}
+/**
+ * @brief Create a model from all objects in an obj-file.
+ * The objects become children of one root entity, so the whole model is moved/rotated/scaled through the returned root.
+ */
+Entity* createModel(ObjGroup* group,vec3 position,vec3 scale,vec3 rotation){
+    Entity* root = addEntity(MODEL);
+    setTransformData(root,position,scale,rotation);
+
+    for(int i = 0; i < group->objectCount; i++){
+        Entity* child = createObject(&group->objData[i],(vec3){0.0f, 0.0f, 0.0f}, (vec3){1.0f, 1.0f, 1.0f}, (vec3){0.0f, 0.0f, 0.0f});
+        transform_setParent(child,root);
+    }
+    return root;
 }
 /**
  * @brief Create a light
@@ -369,10 +423,8 @@ void createLine(vec3 position, vec3 endPosition,Entity* entity){
     entity->transformComponent->scale[0] = 1.0f;
     entity->transformComponent->scale[1] = 1.0f;
     entity->transformComponent->scale[2] = 1.0f;
-    entity->transformComponent->rotation[0] = 0.0f;
-    entity->transformComponent->rotation[1] = 0.0f;
-    entity->transformComponent->rotation[2] = 0.0f;
-    entity->transformComponent->modelNeedsUpdate = 1;
+    quat_identity(entity->transformComponent->rotation);
+    transform_markDirty(entity->transformComponent);
 
     GLfloat lines[] = {
         position[0], position[1], position[2], 
@@ -523,10 +575,8 @@ void debug_drawFrustum()
     entity->transformComponent->scale[0] = 1.0f;
     entity->transformComponent->scale[1] = 1.0f;
     entity->transformComponent->scale[2] = 1.0f;
-    entity->transformComponent->rotation[0] = rotation[0] * M_PI / 180.0f; // convert to radians
-    entity->transformComponent->rotation[1] = rotation[1] * M_PI / 180.0f;
-    entity->transformComponent->rotation[2] = rotation[2] * M_PI / 180.0f;
-    entity->transformComponent->modelNeedsUpdate = 1;
+    transform_setEulerRotation(entity->transformComponent, DEG_TO_RAD(rotation[0]), DEG_TO_RAD(rotation[1]), DEG_TO_RAD(rotation[2]));
+    transform_markDirty(entity->transformComponent);
   
     vec3 startt;
     vec3 endt;
@@ -546,10 +596,8 @@ void debug_drawFrustum()
     entity4->transformComponent->scale[0] = 1.0f;
     entity4->transformComponent->scale[1] = 1.0f;
     entity4->transformComponent->scale[2] = 1.0f;
-    entity4->transformComponent->rotation[0] = rotation[0] * M_PI / 180.0f; // convert to radians
-    entity4->transformComponent->rotation[1] = rotation[1] * M_PI / 180.0f;
-    entity4->transformComponent->rotation[2] = rotation[2] * M_PI / 180.0f;
-    entity4->transformComponent->modelNeedsUpdate = 1;
+    transform_setEulerRotation(entity4->transformComponent, DEG_TO_RAD(rotation[0]), DEG_TO_RAD(rotation[1]), DEG_TO_RAD(rotation[2]));
+    transform_markDirty(entity4->transformComponent);
   
     vec3 startb;
     vec3 endb;
@@ -569,10 +617,8 @@ void debug_drawFrustum()
     entity2->transformComponent->scale[0]    = 1.0f;
     entity2->transformComponent->scale[1]    = 1.0f;
     entity2->transformComponent->scale[2]    = 1.0f;
-    entity2->transformComponent->rotation[0] = rotation[0] * M_PI / 180.0f; // convert to radians
-    entity2->transformComponent->rotation[1] = rotation[1] * M_PI / 180.0f;
-    entity2->transformComponent->rotation[2] = rotation[2] * M_PI / 180.0f;
-    entity2->transformComponent->modelNeedsUpdate = 1;
+    transform_setEulerRotation(entity2->transformComponent, DEG_TO_RAD(rotation[0]), DEG_TO_RAD(rotation[1]), DEG_TO_RAD(rotation[2]));
+    transform_markDirty(entity2->transformComponent);
     vec3 startr;
     vec3 endr;
     startr[0] = 1.0f;
@@ -591,10 +637,8 @@ void debug_drawFrustum()
     entity3->transformComponent->scale[0]    = 1.0f;
     entity3->transformComponent->scale[1]    = 1.0f;
     entity3->transformComponent->scale[2]    = 1.0f;
-    entity3->transformComponent->rotation[0] = rotation[0] * M_PI / 180.0f; // convert to radians
-    entity3->transformComponent->rotation[1] = rotation[1] * M_PI / 180.0f;
-    entity3->transformComponent->rotation[2] = rotation[2] * M_PI / 180.0f;
-    entity3->transformComponent->modelNeedsUpdate = 1;
+    transform_setEulerRotation(entity3->transformComponent, DEG_TO_RAD(rotation[0]), DEG_TO_RAD(rotation[1]), DEG_TO_RAD(rotation[2]));
+    transform_markDirty(entity3->transformComponent);
     vec3 startl;
     vec3 endl;
     startl[0] = 0.0f;
@@ -643,10 +687,15 @@ Entity* ui_createPanel(Material material,vec3 position,vec3 scale,vec3 rotation,
     entity->uiComponent->boundingBoxEntityId = boundingBoxEntity->id;
     ASSERT(entity->uiComponent->boundingBoxEntityId != -1, "Failed to set bounding box entity id");
 
-    createMesh(vertices,4,bbIndices,8,position,scale,rotation,&material,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,true);
+    boundingBoxEntity->materialComponent->materialIndex = ui_materialHandle(&material);
+    createMesh(vertices,4,bbIndices,8,position,scale,rotation,&material,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,false);
     return entity;
 }
-int ui_createRectangle(Material material,vec3 position,vec3 scale,vec3 rotation,Entity* parent){
+/**
+ * @brief Make an entity a ui rectangle drawn with a registered material.
+ * For entities that already exist, e.g. ones made through ecs_cmdCreateEntity.
+ */
+void ui_setupRectangle(Entity* entity,int materialIndex,vec3 position,vec3 scale,vec3 rotation,Entity* parent){
     // vertex data
     GLfloat vertices[] = {
     // Positions          // Colors           // Texture Coords    // Normals
@@ -662,7 +711,6 @@ int ui_createRectangle(Material material,vec3 position,vec3 scale,vec3 rotation,
         1, 2, 3  // second triangle
     };
 
-    Entity* entity = addEntity(MODEL);
     entity->uiComponent->active = 1;
     if(parent != NULL){
         entity->uiComponent->parent = parent;
@@ -679,8 +727,12 @@ int ui_createRectangle(Material material,vec3 position,vec3 scale,vec3 rotation,
     entity->boundingBoxComponent->boundingBox.max[2] = position[2] + scale[2];
     entity->uiComponent->uiNeedsUpdate = 1;
     
-    createMesh(vertices,4,indices,6,position,scale,rotation,&material,GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,true);
-
+    entity->materialComponent->materialIndex = materialIndex;
+    createMesh(vertices,4,indices,6,position,scale,rotation,getMaterial(materialIndex),GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,false);
+}
+int ui_createRectangle(Material material,vec3 position,vec3 scale,vec3 rotation,Entity* parent){
+    Entity* entity = addEntity(MODEL);
+    ui_setupRectangle(entity,ui_materialHandle(&material),position,scale,rotation,parent);
     return entity->id;
 }
 /**
@@ -727,7 +779,8 @@ void ui_createButton(Material material,vec3 position,vec3 scale,vec3 rotation, c
         
     }
     
-    createMesh(vertices,4,indices,6,position,scale,rotation,&material,GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,true);
+    entity->materialComponent->materialIndex = ui_materialHandle(&material);
+    createMesh(vertices,4,indices,6,position,scale,rotation,&material,GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,false);
 
     // Bounding box, reuses the vertices from the rectangle
     GLuint bbIndices[] = {
@@ -739,7 +792,8 @@ void ui_createButton(Material material,vec3 position,vec3 scale,vec3 rotation, c
     entity->uiComponent->boundingBoxEntityId = boundingBoxEntity->id;
     ASSERT(entity->uiComponent->boundingBoxEntityId != -1, "Failed to set bounding box entity id");
 
-    createMesh(vertices,4,bbIndices,8,position,scale,rotation,&material,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,true); 
+    boundingBoxEntity->materialComponent->materialIndex = ui_materialHandle(&material);
+    createMesh(vertices,4,bbIndices,8,position,scale,rotation,&material,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,false); 
 }
 
 /**
@@ -784,7 +838,8 @@ void ui_createTextInput(Material material,vec3 position,vec3 scale,vec3 rotation
         parent->uiComponent->children[parent->uiComponent->childCount - 1] = entity->id;
     }
 
-    createMesh(vertices,4,indices,6,position,scale,rotation,&material,GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,true);
+    entity->materialComponent->materialIndex = ui_materialHandle(&material);
+    createMesh(vertices,4,indices,6,position,scale,rotation,&material,GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,false);
 
     // Bounding box, reuses the vertices from the rectangle
     GLuint bbIndices[] = {
@@ -796,7 +851,8 @@ void ui_createTextInput(Material material,vec3 position,vec3 scale,vec3 rotation
     entity->uiComponent->boundingBoxEntityId = boundingBoxEntity->id;
     ASSERT(entity->uiComponent->boundingBoxEntityId != -1, "Failed to set bounding box entity id");
 
-    createMesh(vertices,4,bbIndices,8,position,scale,rotation,&material,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,true); 
+    boundingBoxEntity->materialComponent->materialIndex = ui_materialHandle(&material);
+    createMesh(vertices,4,bbIndices,8,position,scale,rotation,&material,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,false); 
 }
 
 /**
@@ -840,7 +896,8 @@ void ui_createTextField(Material material,vec3 position,vec3 scale,vec3 rotation
         parent->uiComponent->children[parent->uiComponent->childCount - 1] = entity->id;
     }
 
-    createMesh(vertices,4,indices,6,position,scale,rotation,&material,GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,true);
+    entity->materialComponent->materialIndex = ui_materialHandle(&material);
+    createMesh(vertices,4,indices,6,position,scale,rotation,&material,GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,false);
 
     // Bounding box, reuses the vertices from the rectangle
     GLuint bbIndices[] = {
@@ -852,7 +909,8 @@ void ui_createTextField(Material material,vec3 position,vec3 scale,vec3 rotation
     entity->uiComponent->boundingBoxEntityId = boundingBoxEntity->id;
     ASSERT(entity->uiComponent->boundingBoxEntityId != -1, "Failed to set bounding box entity id");
 
-    createMesh(vertices,4,bbIndices,8,position,scale,rotation,&material,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,true); 
+    boundingBoxEntity->materialComponent->materialIndex = ui_materialHandle(&material);
+    createMesh(vertices,4,bbIndices,8,position,scale,rotation,&material,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,false); 
 }
 
 /**
@@ -910,7 +968,8 @@ void ui_createSlider(Material mat1,Material mat2, vec3 position,vec3 scale,vec3
         parent->uiComponent->children[parent->uiComponent->childCount - 1] = entity->id;
     }
     
-   createMesh(vertices,4,indices,6,(vec3){position[0],position[1]+5,position[2]},btnRectangleScale,rotation,&mat1,GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,true);
+   entity->materialComponent->materialIndex = ui_materialHandle(&mat1);
+   createMesh(vertices,4,indices,6,(vec3){position[0],position[1]+5,position[2]},btnRectangleScale,rotation,&mat1,GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,false);
 
     // Bounding box, reuses the vertices from the rectangle
     GLuint bbIndices[] = {
@@ -922,7 +981,8 @@ void ui_createSlider(Material mat1,Material mat2, vec3 position,vec3 scale,vec3
     entity->uiComponent->boundingBoxEntityId = boundingBoxEntity->id;
     ASSERT(entity->uiComponent->boundingBoxEntityId != -1, "Failed to set bounding box entity id");
 
-    createMesh(vertices,4,bbIndices,8,(vec3){position[0],position[1]+5,position[2]},btnRectangleScale,rotation,&mat2,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,true); 
+    boundingBoxEntity->materialComponent->materialIndex = ui_materialHandle(&mat2);
+    createMesh(vertices,4,bbIndices,8,(vec3){position[0],position[1]+5,position[2]},btnRectangleScale,rotation,&mat2,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,false); 
 }
 /**
  * @brief Create a Checkbox
@@ -972,7 +1032,8 @@ void ui_createCheckbox(Material mat1,Material mat2, vec3 position,vec3 scale,vec
         parent->uiComponent->children[parent->uiComponent->childCount - 1] = entity->id;
     } 
     
-    createMesh(vertices,4,indices,6,position,scale,rotation,&mat1,GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,true);
+    entity->materialComponent->materialIndex = ui_materialHandle(&mat1);
+    createMesh(vertices,4,indices,6,position,scale,rotation,&mat1,GL_TRIANGLES,VERTS_COLOR_ONEUV_INDICIES,entity,false);
 
     // Visual representation of Bounding box, reuses the vertices from the rectangle
     GLuint bbIndices[] = {
@@ -984,5 +1045,6 @@ void ui_createCheckbox(Material mat1,Material mat2, vec3 position,vec3 scale,vec
     entity->uiComponent->boundingBoxEntityId = boundingBoxEntity->id;
     ASSERT(entity->uiComponent->boundingBoxEntityId != -1, "Failed to set bounding box entity id");
 
-    createMesh(vertices,4,bbIndices,8,position,scale,rotation,&mat2,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,true); 
+    boundingBoxEntity->materialComponent->materialIndex = ui_materialHandle(&mat2);
+    createMesh(vertices,4,bbIndices,8,position,scale,rotation,&mat2,GL_LINES,VERTS_COLOR_ONEUV_INDICIES,boundingBoxEntity,false); 
 }
\ No newline at end of file
@@ -3,7 +3,18 @@
 
 #include "types.h"
 
+/**
+ * The create* and ui_create* functions add entities right away (addEntity). They are called at scene setup and
+ * from the loader between systems, never while a system iterates globals.entities, so they stay immediate.
+ * Code that runs inside a system (ui callbacks, hover & click handlers) records the entity with
+ * ecs_cmdCreateEntity instead and builds it in the create callback, e.g. with ui_setupRectangle like the text cursor.
+ */
+
 //------
+/**
+ * @brief Set position, scale & rotation (degrees) of the entity's transform and queue it for a matrix rebuild.
+*/
+void setTransformData(Entity* entity,vec3 position,vec3 scale,vec3 rotation);
 void createPoints(GLfloat* positions,int numPoints, Entity* entity);
 /**
  * @brief Create a mesh
@@ -27,6 +38,10 @@ void createMesh(
     Entity* entity,
     bool saveMaterial // save material to global list
     );
+/**
+ * @brief Upload mesh data to the gpu & setup its shader. Last step of createMesh, also used by scene snapshots.
+*/
+void uploadMesh(Entity* entity);
 //-------
 // 3D API
 //-------
@@ -35,7 +50,12 @@ void createMesh(
  * Create a object mesh
  * @param diffuse - color of the rectangle
 */
-void createObject(ObjData* obj,vec3 position,vec3 scale,vec3 rotation);
+Entity* createObject(ObjData* obj,vec3 position,vec3 scale,vec3 rotation);
+/**
+ * @brief Create a model
+ * All objects of an obj-file parented to one root entity. Transform the root to move the whole model.
+*/
+Entity* createModel(ObjGroup* group,vec3 position,vec3 scale,vec3 rotation);
 /**
  * @brief Create a light
  * Create a light source in the scene.
@@ -72,6 +92,11 @@ Entity* ui_createPanel(Material material,vec3 position,vec3 scale,vec3 rotation,
  * Create a rectangle mesh
 */
 int ui_createRectangle(Material material,vec3 position,vec3 scale,vec3 rotation,Entity* parent);
+/**
+ * @brief Make an existing entity a rectangle
+ * Same mesh as ui_createRectangle, drawn with an already registered material
+*/
+void ui_setupRectangle(Entity* entity,int materialIndex,vec3 position,vec3 scale,vec3 rotation,Entity* parent);
 /**
  * @brief Create a button
  * Create a button mesh in ui
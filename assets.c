@@ -1,4 +1,5 @@
 #include "assets.h"
+#include "texcache.h"
 
 struct Material objectMaterial;
 struct Material lightMaterial;
@@ -9,12 +10,10 @@ struct Material flatColorUiGrayMat;
 struct Material uiBoundingBoxMat;
 
 void initAssets(){
-   TextureData containerTextureData = loadTexture("./Assets/container.jpg");
-   GLuint containerMap = setupTexture(containerTextureData);
-   TextureData containerTwoTextureData = loadTexture("./Assets/container2.png");
-   GLuint containerTwoMap = setupTexture(containerTwoTextureData);
-   TextureData containerTwoSpecTextureData = loadTexture("./Assets/container2_specular.png");
-   GLuint containerTwoSpecularMap = setupTexture(containerTwoSpecTextureData);
+   // Placeholders until the images have decoded, see loader.h
+   GLuint containerMap = texcache_acquire("./Assets/container.jpg", TEXTURE_PARAMS_COLOR);
+   GLuint containerTwoMap = texcache_acquire("./Assets/container2.png", TEXTURE_PARAMS_COLOR);
+   GLuint containerTwoSpecularMap = texcache_acquire("./Assets/container2_specular.png", TEXTURE_PARAMS_DATA);
 
 
     objectMaterial = (struct Material){
@@ -0,0 +1,568 @@
+/**
+ * Synthetic benchmark of the ECS systems & render submission.
+ * Fills the ECS with procedurally generated meshes (in parent/child groups), lights and ui panels with buttons,
+ * then times modelSystem, uiPositionSystem, hoverAndClickSystem and renderListSystem per iteration without any window.
+ * Render submission of the render lists is timed against an offscreen EGL context (see headless.h), no display needed.
+ * A hidden window's GL context is the fallback, submission is skipped when neither can be created.
+ * Results are written as json with percentiles, so two builds can be compared.
+ *
+ * Build from the repo root, with every engine file except main.c:
+ *   gcc -std=c18 -Wall -pedantic bench/bench.c $(ls *.c | grep -v main.c) -I/usr/include/freetype2 -lfreetype -lSDL2 -lGLESv2 -lEGL -lm -o bench.out
+ * Run from the repo root (shaders are loaded from ./shaders):
+ *   ./bench.out --entities 4000 --iterations 500 --out bench.json
+ */
+#include <stdio.h>
+#include <time.h>
+#include <SDL2/SDL.h>
+#include "../opengl_types.h"
+#include "../types.h"
+#include "../globals.h"
+#include "../linmath.h"
+#include "../utils.h"
+#include "../opengl.h"
+#include "../ecs.h"
+#include "../ecs-entity.h"
+#include "../ecs-systems.h"
+#include "../ecs-commands.h"
+#include "../api.h"
+#include "../camera.h"
+#include "../jobs.h"
+#include "../transform.h"
+#include "../profiler.h"
+#include "../headless.h"
+
+// Stb, normally compiled in main.c
+#define STB_IMAGE_IMPLEMENTATION
+#include "../stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../stb_image_write.h"
+
+#define BENCH_DEFAULT_ENTITIES 4000
+#define BENCH_DEFAULT_ITERATIONS 300
+#define BENCH_DEFAULT_WARMUP 20
+#define BENCH_GROUP_SIZE 8     // meshes per parent/child group
+#define BENCH_UI_SHARE 4       // 1/4 of the entities are ui
+
+struct Globals globals = {
+    .running=1,
+    .overideDrawMode=GL_TRIANGLES,
+    .views = {
+        .ui={{0,   0, width, height}, {0.0f, 1.0f, 0.0f, 1.0f},NULL,true},
+        .main={{0, 0, width, height}, {1.0f, 0.0f, 0.0f, 1.0f},NULL,false},
+        .full={{0, 0, width, height}, {0.0f, 0.0f, 0.0f, 1.0f} ,NULL,false},
+    },
+    .firstMouse=1,
+    .charScale=0.5f,
+    .fontSize=26,
+    .unitScale=100.0f,
+    .materialsCapacity=MATERIALS_INITIAL_CAPACITY, // grows
+    .focusedEntityId=-1,
+    .cursorEntityId=-1,
+    .shadowWidth=256,
+    .shadowHeight=256,
+    .showUI=true,
+};
+
+typedef enum BenchMetric {
+    METRIC_UI_POSITION,
+    METRIC_HOVER_AND_CLICK,
+    METRIC_MODEL,
+    METRIC_RENDER_LIST,
+    METRIC_SYSTEMS_TOTAL,
+    METRIC_SUBMIT,          // cpu side of the draw calls
+    METRIC_SUBMIT_FINISH,   // draw calls + glFinish, includes the gpu
+    METRIC_COUNT
+} BenchMetric;
+
+static const char* metricNames[METRIC_COUNT] = {
+    "uiPositionSystem",
+    "hoverAndClickSystem",
+    "modelSystem",
+    "renderListSystem",
+    "systemsTotal",
+    "renderSubmit",
+    "renderSubmitFinish",
+};
+
+typedef struct BenchOptions {
+    int entities;
+    int iterations;
+    int warmup;
+    bool render;
+    const char* outPath; // NULL = stdout
+} BenchOptions;
+
+typedef struct BenchScene {
+    int meshes;
+    int lights;
+    int uiElements;
+    int boundingBoxes;
+    int* movingIds;   // mesh entities moved every iteration
+    int movingCount;
+    int* uiIds;       // ui elements laid out every iteration
+    vec2* uiRequestedPositions;
+    int uiCount;
+} BenchScene;
+
+// Shared mesh data, every entity of a kind points at the same vertices.
+static Vertex cubeVertices[24];
+static unsigned int cubeIndices[36];
+static Vertex quadVertices[4];
+static unsigned int quadIndices[6] = { 0, 1, 3, 1, 2, 3 };
+static unsigned int quadLineIndices[8] = { 0, 1, 1, 2, 2, 3, 3, 0 };
+
+static Material meshMaterial = {
+    .active = 1, .name = "benchMeshMaterial",
+    .ambient = {1.0f, 1.0f, 1.0f, 1.0f}, .diffuse = {0.5f, 0.0f, 0.0f, 1.0f}, .specular = {0.0f, 0.0f, 0.0f, 1.0f},
+    .shininess = 32.0f, .diffuseMapOpacity = 0.0f,
+};
+static Material uiMaterial = {
+    .active = 1, .name = "benchUiMaterial",
+    .ambient = {0.0f, 0.0f, 0.0f, 1.0f}, .diffuse = {0.3f, 0.3f, 0.3f, 1.0f}, .specular = {0.0f, 0.0f, 0.0f, 1.0f},
+    .shininess = 4.0f, .diffuseMapOpacity = 0.0f,
+};
+
+static void printUsage(){
+    printf("usage: bench [--entities N] [--iterations N] [--warmup N] [--no-render] [--out file.json]\n");
+}
+
+static BenchOptions parseOptions(int argc, char** argv){
+    BenchOptions options = { BENCH_DEFAULT_ENTITIES, BENCH_DEFAULT_ITERATIONS, BENCH_DEFAULT_WARMUP, true, NULL };
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--entities") == 0 && i + 1 < argc){
+            options.entities = atoi(argv[++i]);
+        }else if(strcmp(argv[i], "--iterations") == 0 && i + 1 < argc){
+            options.iterations = atoi(argv[++i]);
+        }else if(strcmp(argv[i], "--warmup") == 0 && i + 1 < argc){
+            options.warmup = atoi(argv[++i]);
+        }else if(strcmp(argv[i], "--no-render") == 0){
+            options.render = false;
+        }else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc){
+            options.outPath = argv[++i];
+        }else {
+            printUsage();
+            exit(1);
+        }
+    }
+    if(options.entities < 16 || options.entities > MAX_ENTITIES || options.iterations < 1 || options.warmup < 0){
+        printf(TEXT_COLOR_ERROR "entities must be 16..%d and iterations at least 1\n" TEXT_COLOR_RESET, MAX_ENTITIES);
+        exit(1);
+    }
+    return options;
+}
+
+static void setVertex(Vertex* vertex, float x, float y, float z, float u, float v, float nx, float ny, float nz){
+    vertex->position[0] = x; vertex->position[1] = y; vertex->position[2] = z;
+    vertex->color[0] = 1.0f; vertex->color[1] = 1.0f; vertex->color[2] = 1.0f;
+    vertex->texcoord[0] = u; vertex->texcoord[1] = v;
+    vertex->normal[0] = nx; vertex->normal[1] = ny; vertex->normal[2] = nz;
+}
+
+/**
+ * @brief Unit cube (4 vertices per face) & unit quad.
+ */
+static void buildMeshData(){
+    static const float normals[6][3] = { {0,0,1}, {0,0,-1}, {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0} };
+    for(int face = 0; face < 6; face++){
+        const float* n = normals[face];
+        // Two axes spanning the face.
+        float u[3] = { n[1] != 0.0f ? 1.0f : 0.0f, n[1] != 0.0f ? 0.0f : 1.0f, 0.0f };
+        float v[3] = { n[1]*u[2] - n[2]*u[1], n[2]*u[0] - n[0]*u[2], n[0]*u[1] - n[1]*u[0] };
+        for(int corner = 0; corner < 4; corner++){
+            float su = (corner == 1 || corner == 2) ? 0.5f : -0.5f;
+            float sv = corner >= 2 ? 0.5f : -0.5f;
+            setVertex(&cubeVertices[face * 4 + corner],
+                n[0] * 0.5f + u[0] * su + v[0] * sv,
+                n[1] * 0.5f + u[1] * su + v[1] * sv,
+                n[2] * 0.5f + u[2] * su + v[2] * sv,
+                su + 0.5f, sv + 0.5f, n[0], n[1], n[2]);
+        }
+        unsigned int base = face * 4;
+        unsigned int faceIndices[6] = { base, base + 1, base + 2, base + 2, base + 3, base };
+        memcpy(&cubeIndices[face * 6], faceIndices, sizeof(faceIndices));
+    }
+    setVertex(&quadVertices[0],  0.5f,  0.5f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f); // top right
+    setVertex(&quadVertices[1],  0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f); // bottom right
+    setVertex(&quadVertices[2], -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f); // bottom left
+    setVertex(&quadVertices[3], -0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f); // top left
+}
+
+static float randomRange(float min, float max){
+    return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+/**
+ * @brief Same component setup as createMesh, minus the gpu upload.
+ */
+static void setMesh(Entity* entity, Vertex* vertices, int vertexCount, unsigned int* indices, int indexCount, GLenum drawMode, int materialIndex){
+    Material* material = getMaterial(materialIndex);
+    entity->meshComponent->active = 1;
+    entity->meshComponent->drawIndexed = true;
+    entity->meshComponent->vertices = vertices;
+    entity->meshComponent->vertexCount = vertexCount;
+    entity->meshComponent->indices = indices;
+    entity->meshComponent->indexCount = indexCount;
+    entity->meshComponent->gpuData->vertexCount = vertexCount;
+    entity->meshComponent->gpuData->drawMode = drawMode;
+    entity->materialComponent->active = 1;
+    entity->materialComponent->materialIndex = materialIndex;
+    entity->materialComponent->diffuse = material->diffuse;
+    entity->materialComponent->diffuseMapOpacity = material->diffuseMapOpacity;
+}
+
+static Entity* createUiElement(UiType type, vec3 position, vec3 scale, Entity* parent, int uiMaterialIndex, BenchScene* scene){
+    Entity* entity = addEntity(MODEL);
+    entity->uiComponent->active = 1;
+    entity->uiComponent->type = type;
+    entity->uiComponent->uiNeedsUpdate = 1;
+    if(type == UITYPE_BUTTON){
+        strcpy(entity->uiComponent->text, "Button");
+    }
+    if(parent != NULL){
+        entity->uiComponent->parent = parent;
+        parent->uiComponent->children[parent->uiComponent->childCount++] = entity->id;
+    }
+    entity->boundingBoxComponent->active = 1;
+    entity->boundingBoxComponent->boundingBox.min[0] = position[0];
+    entity->boundingBoxComponent->boundingBox.min[1] = position[1];
+    entity->boundingBoxComponent->boundingBox.max[0] = position[0] + scale[0];
+    entity->boundingBoxComponent->boundingBox.max[1] = position[1] + scale[1];
+    setTransformData(entity, position, scale, (vec3){0.0f, 0.0f, 0.0f});
+    setMesh(entity, quadVertices, 4, quadIndices, 6, GL_TRIANGLES, uiMaterialIndex);
+
+    Entity* boundingBoxEntity = addEntity(BOUNDING_BOX);
+    entity->uiComponent->boundingBoxEntityId = boundingBoxEntity->id;
+    setTransformData(boundingBoxEntity, position, scale, (vec3){0.0f, 0.0f, 0.0f});
+    setMesh(boundingBoxEntity, quadVertices, 4, quadLineIndices, 8, GL_LINES, uiMaterialIndex);
+
+    scene->uiIds[scene->uiCount] = entity->id;
+    scene->uiRequestedPositions[scene->uiCount][0] = position[0];
+    scene->uiRequestedPositions[scene->uiCount][1] = position[1];
+    scene->uiCount++;
+    scene->uiElements++;
+    scene->boundingBoxes++;
+    return entity;
+}
+
+/**
+ * @brief Spend the entity budget on ui panels with buttons, lights & grouped meshes.
+ */
+static BenchScene createScene(int entityBudget){
+    BenchScene scene = {0};
+    scene.movingIds = malloc(MAX_ENTITIES * sizeof(int));
+    scene.uiIds = malloc(MAX_ENTITIES * sizeof(int));
+    scene.uiRequestedPositions = malloc(MAX_ENTITIES * sizeof(vec2));
+    if(scene.movingIds == NULL || scene.uiIds == NULL || scene.uiRequestedPositions == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate bench scene\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    int meshMaterialIndex = addMaterial(meshMaterial);
+    int uiMaterialIndex = addMaterial(uiMaterial);
+
+    // Ui, panels in a grid with a column of buttons each. Every element takes two entities (element + bounding box).
+    int uiBudget = entityBudget / BENCH_UI_SHARE;
+    int buttonsPerPanel = 7;
+    int panelCost = (1 + buttonsPerPanel) * 2;
+    int panels = uiBudget / panelCost;
+    for(int p = 0; p < panels; p++){
+        float x = (float)((p % 6) * 130);
+        float y = (float)(((p / 6) % 4) * 150);
+        Entity* panel = createUiElement(UITYPE_PANEL, (vec3){x, y, 0.0f}, (vec3){120.0f, 140.0f, 1.0f}, NULL, uiMaterialIndex, &scene);
+        for(int b = 0; b < buttonsPerPanel; b++){
+            createUiElement(UITYPE_BUTTON, (vec3){x + 5.0f, y + 5.0f + b * 19.0f, 0.0f}, (vec3){110.0f, 16.0f, 1.0f}, panel, uiMaterialIndex, &scene);
+        }
+    }
+
+    // Lights, registered the way createLight does.
+    int lights = entityBudget / 100 + 1;
+    lights = lights < MAX_LIGHTS ? lights : MAX_LIGHTS;
+    for(int l = 0; l < lights; l++){
+        Entity* entity = addEntity(LIGHT);
+        entity->lightComponent->active = 1;
+        entity->lightComponent->type = l == 0 ? DIRECTIONAL : (l % 2 ? POINT : SPOT);
+        entity->lightComponent->direction[1] = -1.0f;
+        entity->lightComponent->intensity = 1.0f;
+        entity->lightComponent->diffuse = (Color){1.0f, 1.0f, 1.0f, 1.0f};
+        entity->lightComponent->ambient = (Color){0.2f, 0.2f, 0.2f, 1.0f};
+        entity->lightComponent->specular = (Color){1.0f, 1.0f, 1.0f, 1.0f};
+        entity->lightComponent->constant = 1.0f;
+        entity->lightComponent->linear = 0.09f;
+        entity->lightComponent->quadratic = 0.032f;
+        entity->lightComponent->cutOff = cosf(DEG_TO_RAD(12.5f));
+        entity->lightComponent->outerCutOff = cosf(DEG_TO_RAD(17.5f));
+        globals.lights[globals.lightsCount].entityId = entity->id;
+        globals.lights[globals.lightsCount].type = entity->lightComponent->type;
+        globals.lightsCount++;
+        setTransformData(entity, (vec3){randomRange(-50.0f, 50.0f), 20.0f, randomRange(-50.0f, 50.0f)}, (vec3){1.0f, 1.0f, 1.0f}, (vec3){0.0f, 0.0f, 0.0f});
+        setMesh(entity, cubeVertices, 24, cubeIndices, 36, GL_TRIANGLES, meshMaterialIndex);
+        scene.lights++;
+    }
+
+    // Meshes, the rest. Groups of a moving root with children that follow it.
+    int meshBudget = entityBudget - scene.lights - scene.uiElements - scene.boundingBoxes;
+    Entity* root = NULL;
+    for(int m = 0; m < meshBudget; m++){
+        Entity* entity = addEntity(MODEL);
+        vec3 position = { randomRange(-100.0f, 100.0f), randomRange(0.0f, 20.0f), randomRange(-100.0f, 100.0f) };
+        vec3 rotation = { randomRange(0.0f, 360.0f), randomRange(0.0f, 360.0f), randomRange(0.0f, 360.0f) };
+        if(m % BENCH_GROUP_SIZE == 0){
+            root = entity;
+            scene.movingIds[scene.movingCount++] = entity->id;
+        }else {
+            position[0] = randomRange(-3.0f, 3.0f);
+            position[1] = randomRange(-3.0f, 3.0f);
+            position[2] = randomRange(-3.0f, 3.0f);
+        }
+        setTransformData(entity, position, (vec3){1.0f, 1.0f, 1.0f}, rotation);
+        setMesh(entity, cubeVertices, 24, cubeIndices, 36, GL_TRIANGLES, meshMaterialIndex);
+        if(entity != root){
+            transform_setParent(entity, root);
+        }
+        scene.meshes++;
+    }
+    return scene;
+}
+
+/**
+ * @brief GL context for render submission, the headless EGL pbuffer first so CI needs no display.
+ * Falls back to a hidden window, which needs a display server.
+ */
+static bool initOffscreenContext(){
+    HeadlessOptions headlessOptions = { .enabled = true, .frames = 1 };
+    if(headless_init(&headlessOptions, width, height)){
+        globals.headless = true;
+        return true;
+    }
+    printf(TEXT_COLOR_WARNING "No offscreen EGL context, trying a hidden window\n" TEXT_COLOR_RESET);
+    if(SDL_Init(SDL_INIT_VIDEO) != 0){
+        printf(TEXT_COLOR_WARNING "No video (%s), render submission skipped\n" TEXT_COLOR_RESET, SDL_GetError());
+        return false;
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    globals.window = SDL_CreateWindow("FH Engine bench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if(globals.window == NULL){
+        printf(TEXT_COLOR_WARNING "No window (%s), render submission skipped\n" TEXT_COLOR_RESET, SDL_GetError());
+        return false;
+    }
+    globals.gl_context = SDL_GL_CreateContext(globals.window);
+    if(globals.gl_context == NULL){
+        printf(TEXT_COLOR_WARNING "No GL context (%s), render submission skipped\n" TEXT_COLOR_RESET, SDL_GetError());
+        SDL_DestroyWindow(globals.window);
+        globals.window = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Upload one entity per mesh & shader combination and share its buffers with the rest,
+ * draw calls stay one per entity but we don't compile thousands of identical shaders.
+ */
+static void uploadScene(){
+    GpuData* uploaded[4] = { NULL, NULL, NULL, NULL }; // mesh, light, ui, bounding box
+    for(int i = 0; i < MAX_ENTITIES; i++){
+        Entity* entity = &globals.entities[i];
+        if(!entity->alive || !entity->meshComponent->active){
+            continue;
+        }
+        int kind = entity->tag == BOUNDING_BOX ? 3 : entity->uiComponent->active ? 2 : entity->lightComponent->active ? 1 : 0;
+        if(uploaded[kind] == NULL){
+            uploadMesh(entity);
+            uploaded[kind] = entity->meshComponent->gpuData;
+        }else {
+            *entity->meshComponent->gpuData = *uploaded[kind];
+        }
+    }
+}
+
+static void initCameras(){
+    Camera* uiCamera = initCamera();
+    uiCamera->isOrthographic = 1;
+    uiCamera->left = (float)-width/2.0f;
+    uiCamera->right = (float)width/2.0f;
+    uiCamera->bottom = -(float)height/2.0f;
+    uiCamera->top = (float)height/2.0f;
+    uiCamera->near = -10.0f;
+    uiCamera->far = 10.0f;
+    globals.views.ui.camera = uiCamera;
+
+    Camera* mainCamera = initCamera();
+    mainCamera->position[1] = 35.0f;
+    mainCamera->position[2] = 35.0f;
+    globals.views.main.camera = mainCamera;
+    updateCamera(uiCamera);
+    updateCamera(mainCamera);
+}
+
+/**
+ * @brief Draw the render lists the way render does (main, lines & points, ui), text & shadows left out.
+ */
+static void submitRenderLists(){
+    RenderLists* lists = &globals.renderLists;
+    glViewport(0, 0, width, height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    for(int n = 0; n < lists->main.count; n++){
+        Entity* entity = &globals.entities[lists->main.ids[n]];
+        renderMesh(entity->meshComponent->gpuData, entity->transformComponent, globals.views.main.camera, entity->materialComponent);
+    }
+    for(int n = 0; n < lists->linesAndPoints.count; n++){
+        Entity* entity = &globals.entities[lists->linesAndPoints.ids[n]];
+        if(entity->lineComponent->active == 1){
+            renderLine(entity->lineComponent->gpuData, entity->transformComponent, globals.views.main.camera, entity->lineComponent->color);
+        }
+    }
+    for(int n = 0; n < lists->ui.count; n++){
+        Entity* entity = &globals.entities[lists->ui.ids[n]];
+        renderMesh(entity->meshComponent->gpuData, entity->transformComponent, globals.views.ui.camera, entity->materialComponent);
+    }
+}
+
+/**
+ * @brief Per iteration input, not timed: move the group roots, ask for a full ui relayout & move the mouse.
+ */
+static void prepareIteration(BenchScene* scene, int iteration){
+    float offset = sinf(iteration * 0.1f) * 0.5f;
+    for(int i = 0; i < scene->movingCount; i++){
+        TransformComponent* transform = globals.entities[scene->movingIds[i]].transformComponent;
+        transform->position[1] += offset;
+        transform_markDirty(transform);
+    }
+    for(int i = 0; i < scene->uiCount; i++){
+        Entity* entity = &globals.entities[scene->uiIds[i]];
+        entity->transformComponent->position[0] = scene->uiRequestedPositions[i][0];
+        entity->transformComponent->position[1] = scene->uiRequestedPositions[i][1];
+        entity->uiComponent->uiNeedsUpdate = 1;
+    }
+    globals.mouseXpos = (float)((iteration * 37) % width);
+    globals.mouseYpos = (float)((iteration * 53) % height);
+}
+
+static uint64_t timeSystem(void (*system)()){
+    uint64_t start = profiler_now();
+    system();
+    return profiler_now() - start;
+}
+
+static void writeMetric(FILE* fp, const char* name, uint64_t* samples, int count, bool last){
+    profiler_sortSamples(samples, count);
+    double total = 0.0;
+    for(int i = 0; i < count; i++){
+        total += samples[i];
+    }
+    // Microseconds, three decimals keep the nanoseconds.
+    fprintf(fp, "    \"%s\": {\"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}%s\n",
+        name,
+        samples[0] / 1000.0,
+        total / count / 1000.0,
+        profiler_percentile(samples, count, 50.0) / 1000.0,
+        profiler_percentile(samples, count, 90.0) / 1000.0,
+        profiler_percentile(samples, count, 95.0) / 1000.0,
+        profiler_percentile(samples, count, 99.0) / 1000.0,
+        samples[count - 1] / 1000.0,
+        last ? "" : ",");
+}
+
+static void writeResults(BenchOptions* options, BenchScene* scene, uint64_t* samples[METRIC_COUNT], bool rendered){
+    FILE* fp = options->outPath != NULL ? fopen(options->outPath, "w") : stdout;
+    if(fp == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to open %s\n" TEXT_COLOR_RESET, options->outPath);
+        exit(1);
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"unit\": \"us\",\n");
+    fprintf(fp, "  \"iterations\": %d,\n", options->iterations);
+    fprintf(fp, "  \"warmup\": %d,\n", options->warmup);
+    fprintf(fp, "  \"workers\": %d,\n", jobs_workerCount());
+    fprintf(fp, "  \"entities\": {\"total\": %d, \"meshes\": %d, \"lights\": %d, \"ui\": %d, \"boundingBoxes\": %d},\n",
+        scene->meshes + scene->lights + scene->uiElements + scene->boundingBoxes, scene->meshes, scene->lights, scene->uiElements, scene->boundingBoxes);
+    fprintf(fp, "  \"renderLists\": {\"main\": %d, \"linesAndPoints\": %d, \"ui\": %d, \"uiText\": %d},\n",
+        globals.renderLists.main.count, globals.renderLists.linesAndPoints.count, globals.renderLists.ui.count, globals.renderLists.uiText.count);
+    if(rendered){
+        fprintf(fp, "  \"renderer\": \"%s\",\n", (const char*)glGetString(GL_RENDERER));
+    }else {
+        fprintf(fp, "  \"renderer\": null,\n");
+    }
+    fprintf(fp, "  \"results\": {\n");
+    int metricCount = rendered ? METRIC_COUNT : METRIC_SUBMIT;
+    for(int m = 0; m < metricCount; m++){
+        writeMetric(fp, metricNames[m], samples[m], options->iterations, m == metricCount - 1);
+    }
+    fprintf(fp, "  }\n}\n");
+    if(fp != stdout){
+        fclose(fp);
+        printf("Bench results written to %s\n", options->outPath);
+    }
+}
+
+int main(int argc, char** argv){
+    BenchOptions options = parseOptions(argc, argv);
+
+    arena_initMemory(&globals.assetArena, ASSET_MEMORY_SIZE * sizeof(Vertex));
+    arena_initMemory(&globals.uiArena, UI_MEMORY_SIZE * sizeof(char));
+    arena_initScratch(&globals.scratchArena, SCRATCH_MEMORY_SIZE);
+    materials_init(globals.materialsCapacity);
+
+    profiler_init();
+    srand(1234); // same scene every run
+    initECS();
+    ecs_initCommandBuffers();
+    jobs_init(SDL_GetCPUCount() - 1);
+
+    buildMeshData();
+    BenchScene scene = createScene(options.entities);
+    initCameras();
+
+    bool rendered = options.render && initOffscreenContext();
+    if(rendered){
+        uploadScene();
+    }
+
+    uint64_t* samples[METRIC_COUNT];
+    for(int m = 0; m < METRIC_COUNT; m++){
+        samples[m] = malloc(options.iterations * sizeof(uint64_t));
+        if(samples[m] == NULL){
+            printf(TEXT_COLOR_ERROR "Failed to allocate bench samples\n" TEXT_COLOR_RESET);
+            exit(1);
+        }
+    }
+
+    // Same order as update, then render.
+    for(int i = -options.warmup; i < options.iterations; i++){
+        prepareIteration(&scene, i);
+        uint64_t times[METRIC_COUNT] = {0};
+        times[METRIC_UI_POSITION] = timeSystem(uiPositionSystem);
+        times[METRIC_HOVER_AND_CLICK] = timeSystem(hoverAndClickSystem);
+        times[METRIC_MODEL] = timeSystem(modelSystem);
+        times[METRIC_RENDER_LIST] = timeSystem(renderListSystem);
+        times[METRIC_SYSTEMS_TOTAL] = times[METRIC_UI_POSITION] + times[METRIC_HOVER_AND_CLICK] + times[METRIC_MODEL] + times[METRIC_RENDER_LIST];
+        if(rendered){
+            uint64_t start = profiler_now();
+            submitRenderLists();
+            times[METRIC_SUBMIT] = profiler_now() - start;
+            glFinish();
+            times[METRIC_SUBMIT_FINISH] = profiler_now() - start;
+        }
+        ecs_playbackCommands();
+        if(i >= 0){
+            for(int m = 0; m < METRIC_COUNT; m++){
+                samples[m][i] = times[m];
+            }
+        }
+    }
+
+    writeResults(&options, &scene, samples, rendered);
+
+    jobs_shutdown();
+    profiler_shutdown();
+    if(rendered && globals.headless){
+        headless_shutdown();
+    }else if(rendered){
+        SDL_GL_DeleteContext(globals.gl_context);
+        SDL_DestroyWindow(globals.window);
+    }
+    SDL_Quit();
+    return 0;
+}
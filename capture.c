@@ -0,0 +1,253 @@
+#include "capture.h"
+#include "opengl_types.h"
+#include "utils.h"
+#include "globals.h"
+#include "profiler.h"
+#include "jobs.h"
+#include "stb_image_write.h"
+
+typedef struct CaptureSlot {
+    GLuint pbo;
+    GLsizeiptr capacity;
+    GLsync fence;
+    int width;
+    int height;
+    CaptureFormat format;
+    char path[CAPTURE_MAX_PATH];
+} CaptureSlot;
+
+typedef struct CaptureJob {
+    unsigned char* pixels; // rgba, bottom row first, owned by the job
+    int width;
+    int height;
+    CaptureFormat format;
+    char path[CAPTURE_MAX_PATH];
+} CaptureJob;
+
+static bool initialized = false;
+
+// Readback ring, slots are filled & resolved in order so the pending ones are contiguous from oldestSlot.
+static CaptureSlot slots[CAPTURE_PBO_COUNT];
+static int oldestSlot = 0;
+static int pendingCount = 0;
+
+// Bounded queue between the render thread and the encode jobs, one background job per queued capture.
+static CaptureJob queue[CAPTURE_QUEUE_SIZE];
+static int queueHead = 0;
+static int queueTail = 0;
+static SDL_mutex* queueLock = NULL;
+static SDL_sem* queueSpace = NULL;
+static JobCounter encoding; // queued or being encoded
+
+static bool capture_writePpm(CaptureJob* job){
+    FILE* fp = fopen(job->path, "wb");
+    if(fp == NULL){
+        return false;
+    }
+    fprintf(fp, "P6\n%d %d\n255\n", job->width, job->height);
+    bool ok = true;
+    for(int y = job->height - 1; y >= 0 && ok; y--){
+        ok = fwrite(job->pixels + (size_t)y * job->width * 3, 3, job->width, fp) == (size_t)job->width;
+    }
+    return fclose(fp) == 0 && ok;
+}
+
+static void capture_encode(CaptureJob* job){
+    // Drop alpha in place, the default framebuffer's alpha isn't meaningful in an image.
+    size_t pixelCount = (size_t)job->width * job->height;
+    for(size_t i = 0; i < pixelCount; i++){
+        job->pixels[i * 3 + 0] = job->pixels[i * 4 + 0];
+        job->pixels[i * 3 + 1] = job->pixels[i * 4 + 1];
+        job->pixels[i * 3 + 2] = job->pixels[i * 4 + 2];
+    }
+    bool ok;
+    if(job->format == CAPTURE_FORMAT_PNG){
+        ok = stbi_write_png(job->path, job->width, job->height, 3, job->pixels, job->width * 3) != 0;
+    }else {
+        ok = capture_writePpm(job);
+    }
+    if(!ok){
+        printf(TEXT_COLOR_ERROR "Failed to write capture %s\n" TEXT_COLOR_RESET, job->path);
+    }
+    free(job->pixels);
+}
+
+/**
+ * @brief Background job, encodes the oldest queued capture.
+ */
+static void capture_encodeNext(void* data){
+    (void)data;
+    SDL_LockMutex(queueLock);
+    CaptureJob job = queue[queueHead];
+    queueHead = (queueHead + 1) % CAPTURE_QUEUE_SIZE;
+    SDL_UnlockMutex(queueLock);
+    SDL_SemPost(queueSpace);
+    capture_encode(&job);
+}
+
+static void capture_push(CaptureJob job){
+    #ifdef __EMSCRIPTEN__
+    capture_encode(&job);
+    #else
+    if(SDL_SemTryWait(queueSpace) != 0){
+        // Encode jobs are behind, help with them instead of dropping the frame.
+        PROFILE_BEGIN("capture_waitForEncoder");
+        while(SDL_SemTryWait(queueSpace) != 0){
+            if(!jobs_runBackgroundJob()){
+                SDL_Delay(1);
+            }
+        }
+        PROFILE_END();
+    }
+    SDL_LockMutex(queueLock);
+    queue[queueTail] = job;
+    queueTail = (queueTail + 1) % CAPTURE_QUEUE_SIZE;
+    SDL_UnlockMutex(queueLock);
+    jobs_runBackground(capture_encodeNext, NULL, &encoding);
+    #endif
+}
+
+void capture_init(){
+    stbi_flip_vertically_on_write(1); // gl rows start at the bottom
+    #ifndef __EMSCRIPTEN__
+    for(int i = 0; i < CAPTURE_PBO_COUNT; i++){
+        glGenBuffers(1, &slots[i].pbo);
+        slots[i].capacity = 0;
+        slots[i].fence = NULL;
+    }
+    queueLock = SDL_CreateMutex();
+    CHECK_SDL_ERROR(queueLock == NULL, SDL_GetError());
+    queueSpace = SDL_CreateSemaphore(CAPTURE_QUEUE_SIZE);
+    CHECK_SDL_ERROR(queueSpace == NULL, SDL_GetError());
+    #endif
+    SDL_AtomicSet(&encoding.value, 0);
+    initialized = true;
+}
+
+/**
+ * @brief Map the oldest pending buffer, waiting for its fence if needed, and queue its pixels for encoding.
+ */
+static void capture_resolveOldest(){
+    CaptureSlot* slot = &slots[oldestSlot];
+    glClientWaitSync(slot->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(slot->fence);
+    slot->fence = NULL;
+
+    size_t size = (size_t)slot->width * slot->height * 4;
+    CaptureJob job = {0};
+    job.pixels = malloc(size);
+    if(job.pixels == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate capture %s\n" TEXT_COLOR_RESET, slot->path);
+        exit(1);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+    void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if(mapped != NULL){
+        memcpy(job.pixels, mapped, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    oldestSlot = (oldestSlot + 1) % CAPTURE_PBO_COUNT;
+    pendingCount--;
+    if(mapped == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to map capture buffer for %s\n" TEXT_COLOR_RESET, slot->path);
+        free(job.pixels);
+        return;
+    }
+    job.width = slot->width;
+    job.height = slot->height;
+    job.format = slot->format;
+    memcpy(job.path, slot->path, sizeof(job.path));
+    capture_push(job);
+}
+
+/**
+ * @brief Queue a read of the bound read framebuffer, written to path once encoded.
+ */
+void capture_readPixels(int width, int height, const char* path, CaptureFormat format){
+    ASSERT(initialized, "capture_init not called");
+    PROFILE_BEGIN("capture_readPixels");
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    #ifdef __EMSCRIPTEN__
+    CaptureJob job = {0};
+    job.pixels = malloc((size_t)width * height * 4);
+    if(job.pixels == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate capture %s\n" TEXT_COLOR_RESET, path);
+        exit(1);
+    }
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, job.pixels);
+    job.width = width;
+    job.height = height;
+    job.format = format;
+    snprintf(job.path, sizeof(job.path), "%s", path);
+    capture_push(job);
+    #else
+    if(pendingCount == CAPTURE_PBO_COUNT){
+        // Ring wrapped within a few frames (or draw calls), the oldest has to come out first.
+        capture_resolveOldest();
+    }
+    CaptureSlot* slot = &slots[(oldestSlot + pendingCount) % CAPTURE_PBO_COUNT];
+    GLsizeiptr size = (GLsizeiptr)width * height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+    if(slot->capacity < size){
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        slot->capacity = size;
+    }
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot->width = width;
+    slot->height = height;
+    slot->format = format;
+    snprintf(slot->path, sizeof(slot->path), "%s", path);
+    pendingCount++;
+    #endif
+    PROFILE_END();
+}
+
+/**
+ * @brief Hand finished readbacks to the encode jobs. Never waits on the gpu, call once per frame.
+ */
+void capture_frameEnd(){
+    #ifndef __EMSCRIPTEN__
+    while(pendingCount > 0){
+        GLenum status = glClientWaitSync(slots[oldestSlot].fence, 0, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED){
+            break;
+        }
+        capture_resolveOldest();
+    }
+    #endif
+}
+
+/**
+ * @brief Wait until every capture is read back and written to disk.
+ */
+void capture_flush(){
+    #ifndef __EMSCRIPTEN__
+    while(pendingCount > 0){
+        capture_resolveOldest();
+    }
+    #endif
+    while(!jobs_isDone(&encoding)){
+        if(!jobs_runBackgroundJob()){
+            SDL_Delay(1);
+        }
+    }
+}
+
+void capture_shutdown(){
+    if(!initialized){
+        return;
+    }
+    capture_flush();
+    #ifndef __EMSCRIPTEN__
+    SDL_DestroySemaphore(queueSpace);
+    SDL_DestroyMutex(queueLock);
+    for(int i = 0; i < CAPTURE_PBO_COUNT; i++){
+        glDeleteBuffers(1, &slots[i].pbo);
+    }
+    #endif
+    initialized = false;
+}
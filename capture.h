@@ -0,0 +1,34 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+
+/**
+ * Asynchronous framebuffer capture.
+ * glReadPixels goes into a ring of CAPTURE_PBO_COUNT pixel pack buffers, each followed by a fence, so the
+ * call returns right away and the copy happens on the gpu. Buffers whose fence signaled are mapped in
+ * capture_frameEnd(), a few frames later, and their pixels encoded by background jobs (jobs_runBackground) fed
+ * from a bounded queue. The render thread only waits when the ring wraps before the gpu is done or the queue
+ * is full, it runs encode jobs itself meanwhile, frames are never dropped.
+ * capture_flush() waits for everything in flight, call it (or capture_shutdown) before the GL context goes away
+ * and before jobs_shutdown.
+ * Wasm has no threads or buffer mapping, captures are read & encoded right away there.
+ */
+
+#define CAPTURE_PBO_COUNT 4
+#define CAPTURE_QUEUE_SIZE 8
+#define CAPTURE_MAX_PATH 256
+#define CAPTURE_RECORD_PATTERN "record_%05d.ppm"
+
+typedef enum CaptureFormat {
+    CAPTURE_FORMAT_PNG, // small files, slow to encode
+    CAPTURE_FORMAT_PPM  // raw rgb, fast enough for continuous recording, ffmpeg -i record_%05d.ppm out.mp4
+} CaptureFormat;
+
+void capture_init();
+void capture_shutdown();
+void capture_readPixels(int width, int height, const char* path, CaptureFormat format);
+void capture_frameEnd();
+void capture_flush();
+
+#endif
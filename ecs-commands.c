@@ -0,0 +1,139 @@
+#include "ecs-commands.h"
+#include "globals.h"
+#include "utils.h"
+#include "ecs.h"
+#include "ecs-entity.h"
+#include "jobs.h"
+
+// One buffer per job system thread, index 0 is the main thread.
+static EcsCommandBuffer commandBuffers[JOBS_MAX_WORKERS + 1];
+
+void ecs_initCommandBuffers(){
+    for(int i = 0; i < JOBS_MAX_WORKERS + 1; i++){
+        commandBuffers[i].commands = malloc(ECS_COMMANDS_INITIAL_CAPACITY * sizeof(EcsCommand));
+        if(commandBuffers[i].commands == NULL){
+            printf(TEXT_COLOR_ERROR "Failed to allocate ecs command buffer\n" TEXT_COLOR_RESET);
+            exit(1);
+        }
+        commandBuffers[i].count = 0;
+        commandBuffers[i].capacity = ECS_COMMANDS_INITIAL_CAPACITY;
+    }
+}
+
+static void ecs_pushCommand(EcsCommand command){
+    EcsCommandBuffer* buffer = &commandBuffers[jobs_threadIndex()];
+    if(buffer->count == buffer->capacity){
+        int newCapacity = buffer->capacity * 2;
+        EcsCommand* commands = realloc(buffer->commands, newCapacity * sizeof(EcsCommand));
+        if(commands == NULL){
+            printf(TEXT_COLOR_ERROR "Failed to grow ecs command buffer\n" TEXT_COLOR_RESET);
+            exit(1);
+        }
+        buffer->commands = commands;
+        buffer->capacity = newCapacity;
+    }
+    buffer->commands[buffer->count++] = command;
+}
+
+/**
+ * @brief Create entity at next sync point.
+ * @param onCreate optional, called with the new entity when it has been created.
+ */
+void ecs_cmdCreateEntity(enum Tag tag, EcsCreateCallback onCreate, void* userData){
+    EcsCommand command = {0};
+    command.type = ECS_COMMAND_CREATE_ENTITY;
+    command.entityId = -1;
+    command.tag = tag;
+    command.onCreate = onCreate;
+    command.userData = userData;
+    ecs_pushCommand(command);
+}
+
+void ecs_cmdDeleteEntity(int entityId){
+    EcsCommand command = {0};
+    command.type = ECS_COMMAND_DELETE_ENTITY;
+    command.entityId = entityId;
+    ecs_pushCommand(command);
+}
+
+void ecs_cmdSetComponentActive(int entityId, ComponentType component, bool active){
+    EcsCommand command = {0};
+    command.type = ECS_COMMAND_SET_COMPONENT_ACTIVE;
+    command.entityId = entityId;
+    command.component = component;
+    command.value = active;
+    ecs_pushCommand(command);
+}
+
+void ecs_cmdSetVisible(int entityId, bool visible){
+    EcsCommand command = {0};
+    command.type = ECS_COMMAND_SET_VISIBLE;
+    command.entityId = entityId;
+    command.value = visible;
+    ecs_pushCommand(command);
+}
+
+void ecs_cmdToggleVisible(int entityId){
+    EcsCommand command = {0};
+    command.type = ECS_COMMAND_TOGGLE_VISIBLE;
+    command.entityId = entityId;
+    ecs_pushCommand(command);
+}
+
+static void ecs_setComponentActive(Entity* entity, ComponentType component, bool active){
+    switch(component){
+        case COMPONENT_TRANSFORM:    entity->transformComponent->active = active; break;
+        case COMPONENT_GROUP:        entity->groupComponent->active = active; break;
+        case COMPONENT_MESH:         entity->meshComponent->active = active; break;
+        case COMPONENT_MATERIAL:     entity->materialComponent->active = active; break;
+        case COMPONENT_UI:           entity->uiComponent->active = active; break;
+        case COMPONENT_LIGHT:        entity->lightComponent->active = active; break;
+        case COMPONENT_LINE:         entity->lineComponent->active = active; break;
+        case COMPONENT_POINT:        entity->pointComponent->active = active; break;
+        case COMPONENT_BOUNDING_BOX: entity->boundingBoxComponent->active = active; break;
+    }
+}
+
+static void ecs_applyCommand(EcsCommand* command){
+    if(command->type == ECS_COMMAND_CREATE_ENTITY){
+        Entity* entity = addEntity(command->tag);
+        if(command->onCreate != NULL){
+            command->onCreate(entity, command->userData);
+        }
+        return;
+    }
+
+    // Entity might have been deleted by an earlier command in this playback.
+    ASSERT(command->entityId >= 0 && command->entityId < MAX_ENTITIES, "Ecs command entity id out of range");
+    Entity* entity = &globals.entities[command->entityId];
+    if(!entity->alive){
+        return;
+    }
+    switch(command->type){
+        case ECS_COMMAND_DELETE_ENTITY:        deleteEntity(entity); break;
+        case ECS_COMMAND_SET_COMPONENT_ACTIVE: ecs_setComponentActive(entity, command->component, command->value); break;
+        case ECS_COMMAND_SET_VISIBLE:          entity->visible = command->value; break;
+        case ECS_COMMAND_TOGGLE_VISIBLE:       entity->visible = !entity->visible; break;
+        default: break;
+    }
+}
+
+/**
+ * @brief Sync point. Apply all recorded commands, main thread buffer first then workers in order.
+ * Must be called from the main thread while no jobs are recording.
+ * @return number of commands applied.
+ */
+int ecs_playbackCommands(){
+    int applied = 0;
+    for(int i = 0; i < JOBS_MAX_WORKERS + 1; i++){
+        EcsCommandBuffer* buffer = &commandBuffers[i];
+        // Index loop, create callbacks may record new commands into this buffer.
+        for(int j = 0; j < buffer->count; j++){
+            EcsCommand command = buffer->commands[j];
+            ecs_applyCommand(&command);
+            applied++;
+        }
+        buffer->count = 0;
+    }
+    return applied;
+}
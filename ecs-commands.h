@@ -0,0 +1,63 @@
+#ifndef ECS_COMMANDS_H
+#define ECS_COMMANDS_H
+
+#include "types.h"
+
+/**
+ * Deferred structural changes.
+ * Systems & ui callbacks record entity creation/deletion, component add/remove and visibility changes here
+ * instead of mutating entities while other loops are iterating them.
+ * Every thread records into its own buffer (no locks), the main thread plays them back in order at sync points
+ * between systems with ecs_playbackCommands().
+ */
+
+#define ECS_COMMANDS_INITIAL_CAPACITY 256
+
+typedef enum ComponentType {
+    COMPONENT_TRANSFORM,
+    COMPONENT_GROUP,
+    COMPONENT_MESH,
+    COMPONENT_MATERIAL,
+    COMPONENT_UI,
+    COMPONENT_LIGHT,
+    COMPONENT_LINE,
+    COMPONENT_POINT,
+    COMPONENT_BOUNDING_BOX,
+} ComponentType;
+
+typedef enum EcsCommandType {
+    ECS_COMMAND_CREATE_ENTITY,
+    ECS_COMMAND_DELETE_ENTITY,
+    ECS_COMMAND_SET_COMPONENT_ACTIVE,
+    ECS_COMMAND_SET_VISIBLE,
+    ECS_COMMAND_TOGGLE_VISIBLE,
+} EcsCommandType;
+
+// Called at playback with the newly created entity, use it to set up components (createMesh etc).
+typedef void (*EcsCreateCallback)(Entity* entity, void* userData);
+
+typedef struct EcsCommand {
+    EcsCommandType type;
+    int entityId;
+    enum Tag tag;
+    ComponentType component;
+    bool value;
+    EcsCreateCallback onCreate;
+    void* userData;
+} EcsCommand;
+
+typedef struct EcsCommandBuffer {
+    EcsCommand* commands;
+    int count;
+    int capacity;
+} EcsCommandBuffer;
+
+void ecs_initCommandBuffers();
+void ecs_cmdCreateEntity(enum Tag tag, EcsCreateCallback onCreate, void* userData);
+void ecs_cmdDeleteEntity(int entityId);
+void ecs_cmdSetComponentActive(int entityId, ComponentType component, bool active);
+void ecs_cmdSetVisible(int entityId, bool visible);
+void ecs_cmdToggleVisible(int entityId);
+int ecs_playbackCommands();
+
+#endif
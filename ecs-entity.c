@@ -1,5 +1,6 @@
 #include "ecs-entity.h"
 #include "globals.h"
+#include "transform.h"
 
 Entity* addEntity(enum Tag tag){
     for(int i = 0; i < MAX_ENTITIES; i++) {
@@ -7,6 +8,7 @@ Entity* addEntity(enum Tag tag){
             globals.entities[i].alive = 1;
             globals.entities[i].visible = 1;
             globals.entities[i].tag = tag;
+            transform_markDirty(globals.entities[i].transformComponent);
             return &globals.entities[i];
         }
     }
@@ -17,6 +19,7 @@ Entity* addEntity(enum Tag tag){
 }
 
 void deleteEntity(Entity* entity){
+    transform_removeFromHierarchy(entity);
     entity->alive = 0;
     entity->tag = UNINITIALIZED;
     entity->transformComponent->active = 0;
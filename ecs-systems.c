@@ -6,6 +6,8 @@
 #include "utils.h"
 #include "camera.h"
 #include "api.h"
+#include "transform.h"
+#include "ecs-commands.h"
 
 void deleteEntity(Entity* entity);
 
@@ -20,7 +22,8 @@ void toggleChildrenVisibility(int entityId) {
     if(p->uiComponent->active && p->uiComponent->childCount > 0) {
         for(int i = 0; i < p->uiComponent->childCount; i++) {
             if(entityId != p->uiComponent->children[i]){
-                globals.entities[p->uiComponent->children[i]].visible = !globals.entities[p->uiComponent->children[i]].visible;
+                // Deferred, hoverAndClickSystem is still iterating the entities.
+                ecs_cmdToggleVisible(p->uiComponent->children[i]);
             }
         }
     }
@@ -28,7 +31,7 @@ void toggleChildrenVisibility(int entityId) {
 
 void moveCursor(float x){
     globals.entities[globals.cursorEntityId].transformComponent->position[0] = x;
-    globals.entities[globals.cursorEntityId].transformComponent->modelNeedsUpdate = 1;
+    transform_markDirty(globals.entities[globals.cursorEntityId].transformComponent);
 }
 /**
  * @brief UI input system
@@ -148,7 +151,7 @@ void uiInputSystem(){
                     closestLetterSDLpos.y = closestLetter.position.y;
                     UIVector2 uiVec = convertSDLToUI(closestLetterSDLpos,width,height);
                     globals.entities[globals.cursorEntityId].transformComponent->position[0] = uiVec.x;
-                    globals.entities[globals.cursorEntityId].transformComponent->modelNeedsUpdate = 1;
+                    transform_markDirty(globals.entities[globals.cursorEntityId].transformComponent);
                 }
                 return;
             }
@@ -186,7 +189,7 @@ void uiInputSystem(){
             Character ch = globals.characters[(int)keyCopy];
             float advanceCursor = (float)(ch.Advance >> 6) * globals.charScale;
             globals.entities[globals.cursorEntityId].transformComponent->position[0] += advanceCursor;
-            globals.entities[globals.cursorEntityId].transformComponent->modelNeedsUpdate = 1;
+            transform_markDirty(globals.entities[globals.cursorEntityId].transformComponent);
          }
     }
 }
@@ -248,7 +251,7 @@ void movementSystem(){
                         //printf("offset %f\n", offset);
                       /*   globals.entities[i].transformComponent->position[0] = offset * multiplicator;
                         globals.entities[i].transformComponent->position[2] = offset * multiplicator; */
-                        globals.entities[i].transformComponent->modelNeedsUpdate = 1;
+                        transform_markDirty(globals.entities[i].transformComponent);
                     }else {
                       //  printf("no slider action\n");
                     }
@@ -271,86 +274,99 @@ void cameraSystem(){
     updateCamera(globals.views.ui.camera);
 }
 
+/**
+ * @brief Get entity linked by id from a ui component (bounding box, slider range, checkbox mark..)
+ * @return NULL if not set or not alive.
+ */
+static Entity* uiLinkedEntity(int entityId){
+    if(entityId < 0 || entityId >= MAX_ENTITIES || !globals.entities[entityId].alive){
+        return NULL;
+    }
+    return &globals.entities[entityId];
+}
+
+/**
+ * @brief Position one ui element in "UI" space & sync its bounding box entity.
+ * Position of element on spawn is the center of the ui-viewport, we move it to top left corner
+ * and then add the requested position. If position or scale changes, this calculation won't be correct anymore.
+ */
+static void uiPositionElement(Entity* entity){
+    if(
+        !entity->alive 
+    || !entity->uiComponent->active 
+    || !entity->transformComponent->active 
+    || !entity->uiComponent->uiNeedsUpdate 
+    || globals.cursorEntityId == entity->id
+    || !entity->boundingBoxComponent->active
+    ){
+        return;
+    }
+
+    float ui_viewport_half_width  = (float)globals.views.ui.rect.width  / 2; 
+    float ui_viewport_half_height = (float)globals.views.ui.rect.height / 2;
+
+    // Half scale of element
+    float scaleInPixelsX = entity->transformComponent->scale[0]; 
+    float scaleInPixelsY = entity->transformComponent->scale[1];
+
+    // TODO: rotation
+
+    // position of element
+    float requested_pos_x = entity->transformComponent->position[0];
+    float requested_pos_y = entity->transformComponent->position[1];
+
+    // move element to upper left corner and then add requested position.
+    entity->transformComponent->position[0] = (float)(ui_viewport_half_width - (scaleInPixelsX * 0.5) - requested_pos_x) * -1.0; 
+    entity->transformComponent->position[1] = (float)(ui_viewport_half_height - (scaleInPixelsY * 0.5)) - requested_pos_y * 1.0;
+    transform_markDirty(entity->transformComponent);
+
+    // Bounding box entity is addressed directly by its id.
+    Entity* boundingBoxEntity = uiLinkedEntity(entity->uiComponent->boundingBoxEntityId);
+    if(boundingBoxEntity != NULL){
+        boundingBoxEntity->transformComponent->position[0] = entity->transformComponent->position[0];
+        boundingBoxEntity->transformComponent->position[1] = entity->transformComponent->position[1];
+        boundingBoxEntity->transformComponent->scale[0] = entity->transformComponent->scale[0];
+        boundingBoxEntity->transformComponent->scale[1] = entity->transformComponent->scale[1];
+        transform_markDirty(boundingBoxEntity->transformComponent);
+    }
+    entity->uiComponent->uiNeedsUpdate = 0;
+}
+
+/**
+ * @brief Lay out element, its linked helper elements and then its children (top-down).
+ */
+static void uiLayoutTree(Entity* entity){
+    uiPositionElement(entity);
+
+    Entity* sliderRange = uiLinkedEntity(entity->uiComponent->sliderRangeEntityId);
+    if(sliderRange != NULL){
+        uiPositionElement(sliderRange);
+    }
+    Entity* checkedMark = uiLinkedEntity(entity->uiComponent->checkedEntityId);
+    if(checkedMark != NULL){
+        uiPositionElement(checkedMark);
+    }
+
+    for(int i = 0; i < entity->uiComponent->childCount; i++){
+        Entity* child = uiLinkedEntity(entity->uiComponent->children[i]);
+        if(child != NULL){
+            uiLayoutTree(child);
+        }
+    }
+}
+
 /**
  * @brief UI positionSystem
  * Responsible for setting the position of the UI elements in "UI" space. 
  * UI space is top left corner of the screen is [0.0,0.0], bottom right is [width,height].
  * Newly created UI elements is spawned in center of the screen [width/2, height/2] 
- * ¨ystem then is responsible for 
- * setting the position to top left corner + the requested position.
+ * System then is responsible for setting the position to top left corner + the requested position.
+ * Layout runs top-down from every root ui element (no parent) through uiComponent->children.
  */
 void uiPositionSystem(){
     for(int i = 0; i < MAX_ENTITIES; i++) {
-   
-        if(
-            globals.entities[i].alive == 1 
-        && globals.entities[i].uiComponent->active 
-        && globals.entities[i].transformComponent->active 
-        && globals.entities[i].uiComponent->uiNeedsUpdate 
-        && globals.cursorEntityId != i
-        && globals.entities[i].boundingBoxComponent->active
-        ) {
-        
-         
-                // Goal here: Position element in "UI" space, where start 0,0 is the center of the ui-viewport screen. 
-                // We will position the element to top left corner of the screen and treat this as 0,0 instead.
-                // If position or scale changes, this calculation won't be correct anymore.
-                // This calculation only works for elements that are spawned in the center of the screen.
-                
-                // Position of element on spawn:
-                float ui_viewport_half_width  = (float)globals.views.ui.rect.width  / 2; 
-                float ui_viewport_half_height = (float)globals.views.ui.rect.height / 2;
-              //  printf("ui_viewport_half_width %f\n", ui_viewport_half_width);
-              //  printf("ui_viewport_half_height %f\n", ui_viewport_half_height);
-                
-                // Half scale of element
-                float scaleInPixelsX = globals.entities[i].transformComponent->scale[0]; 
-                float scaleInPixelsY = globals.entities[i].transformComponent->scale[1]; /// globals.unitScale;
-              //  printf("scaleInPixelsX %f\n", scaleInPixelsX);
-              //  printf("scaleInPixelsY %f\n", scaleInPixelsY);
-
-                // TODO: rotation
-            
-                // position of element
-                float requested_pos_x = globals.entities[i].transformComponent->position[0];
-                float requested_pos_y = globals.entities[i].transformComponent->position[1];
-
-              //  printf("requested_pos_x %f\n", requested_pos_x);
-              //  printf("requested_pos_y %f\n", requested_pos_y);
-
-              //  printf("before %f %f\n", globals.entities[i].transformComponent->position[0], globals.entities[i].transformComponent->position[1]);
-        
-                // move element to upper left corner and then add requested position.
-               globals.entities[i].transformComponent->position[0] = (float)(ui_viewport_half_width - (scaleInPixelsX * 0.5) - requested_pos_x) * -1.0; 
-               globals.entities[i].transformComponent->position[1] = (float)(ui_viewport_half_height - (scaleInPixelsY * 0.5)) - requested_pos_y * 1.0;
-             //  printf("final pos: %f %f\n", globals.entities[i].transformComponent->position[0], globals.entities[i].transformComponent->position[1]);
-                
-                // Bounding box
-                //globals.entities[i].uiComponent->boundingBox.x = requested_pos_x;
-              /*   globals.entities[i].boundingBoxComponent->boundingBox.min[0] = requested_pos_x;
-                globals.entities[i].boundingBoxComponent->boundingBox.min[1] = requested_pos_y;
-                globals.entities[i].boundingBoxComponent->boundingBox.max[0] = globals.entities[i].transformComponent->scale[0];
-                globals.entities[i].boundingBoxComponent->boundingBox.max[1] = globals.entities[i].transformComponent->scale[1]; */
-                
-               /*  printf("bounding box x %d\n", globals.entities[i].uiComponent->boundingBox.x);
-                printf("bounding box y %d\n", globals.entities[i].uiComponent->boundingBox.y);
-                printf("bounding box width %d\n", globals.entities[i].uiComponent->boundingBox.width);
-                printf("bounding box height %d\n", globals.entities[i].uiComponent->boundingBox.height);  
-                printf("entity id %d\n", globals.entities[i].id);
-                printf("bb entity to update %d\n", globals.entities[i].uiComponent->boundingBoxEntityId); */
-                
-                // TODO: I dont think this is necessary, we should be able to direct access with i.
-                // Find the bounding box entity and update with new values
-                for(int j = 0; j < MAX_ENTITIES; j++) {
-                    if(globals.entities[j].alive == 1 && globals.entities[i].uiComponent->boundingBoxEntityId == globals.entities[j].id) { 
-                        globals.entities[j].transformComponent->position[0] = globals.entities[i].transformComponent->position[0];
-                        globals.entities[j].transformComponent->position[1] = globals.entities[i].transformComponent->position[1];
-                        globals.entities[j].transformComponent->scale[0] = globals.entities[i].transformComponent->scale[0];
-                        globals.entities[j].transformComponent->scale[1] = globals.entities[i].transformComponent->scale[1];
-                        globals.entities[j].transformComponent->modelNeedsUpdate = 1;
-                    }
-                }
-                globals.entities[i].uiComponent->uiNeedsUpdate = 0;
+        if(globals.entities[i].alive == 1 && globals.entities[i].uiComponent->active && globals.entities[i].uiComponent->parent == NULL) {
+            uiLayoutTree(&globals.entities[i]);
         }
     }
 }
@@ -478,10 +494,10 @@ void uiSliderSystem(){
                float newPosX = absValue(newMouseX) - (width / 2);
          
                focusedEntity->transformComponent->position[0] = newPosX;
-               focusedEntity->transformComponent->modelNeedsUpdate = 1;
+               transform_markDirty(focusedEntity->transformComponent);
 
                globals.entities[focusedEntity->uiComponent->boundingBoxEntityId].transformComponent->position[0] = newPosX;
-               globals.entities[focusedEntity->uiComponent->boundingBoxEntityId].transformComponent->modelNeedsUpdate = 1;
+               transform_markDirty(globals.entities[focusedEntity->uiComponent->boundingBoxEntityId].transformComponent);
 
                focusedEntity->boundingBoxComponent->boundingBox.min[0] = newMouseX - 10;
                focusedEntity->boundingBoxComponent->boundingBox.max[0] = newMouseX + focusedEntity->transformComponent->scale[0] -10; 
@@ -493,6 +509,18 @@ void uiSliderSystem(){
     }
 }
 
+// The text cursor is created & deleted through the command buffer, played back right after this system.
+// Where the next cursor goes, read when its create command plays back.
+static vec3 cursorSpawnPosition;
+static bool cursorPending = false;
+
+static void textCursor_onCreate(Entity* entity, void* userData){
+    // Drawn with the first material's handle, not a copy of it per focus change.
+    ui_setupRectangle(entity, 0, (float*)userData, (vec3){1.5f, (float)globals.fontSize*0.75f, 5.0f}, (vec3){0.0f, 0.0f, 0.0f}, NULL);
+    globals.cursorEntityId = entity->id;
+    cursorPending = false;
+}
+
 void textCursorSystem(){
     
     if(globals.focusedEntityId != -1){
@@ -544,7 +572,7 @@ void textCursorSystem(){
                     // Set cursor to be a new width & position 
                     globals.entities[globals.cursorEntityId].transformComponent->position[0] = globals.cursorDragStart + (selectionWidth * 0.5);
                     globals.entities[globals.cursorEntityId].transformComponent->scale[0] = selectionWidth;
-                    globals.entities[globals.cursorEntityId].transformComponent->modelNeedsUpdate = 1;
+                    transform_markDirty(globals.entities[globals.cursorEntityId].transformComponent);
 
                 }else if(globals.cursorDragStart){
                     globals.cursorDragStart = -1.0f;
@@ -601,7 +629,7 @@ void textCursorSystem(){
         } 
   
         // Create cursor
-        if(!cursorExist){
+        if(!cursorExist && !cursorPending){
             ClosestLetter closestLetter = getClosestLetterInText(
                 globals.entities[globals.focusedEntityId].uiComponent, 
                 globals.entities[globals.focusedEntityId].boundingBoxComponent, 
@@ -613,58 +641,75 @@ void textCursorSystem(){
             sdlVec.x = closestLetter.position.x;
             sdlVec.y = closestLetter.position.y;         
             UIVector2 uiVec = convertSDLToUI(sdlVec,width,height);
-            globals.cursorEntityId = ui_createRectangle(globals.materials[0], (vec3){uiVec.x, uiVec.y, 2.0f}, (vec3){1.5f, (float)globals.fontSize*0.75f, 5.0f}, (vec3){0.0f, 0.0f, 0.0f},NULL);
+            cursorSpawnPosition[0] = uiVec.x;
+            cursorSpawnPosition[1] = uiVec.y;
+            cursorSpawnPosition[2] = 2.0f;
+            cursorPending = true;
+            ecs_cmdCreateEntity(MODEL, textCursor_onCreate, cursorSpawnPosition);
         }
         
     }else{
 
         // When we are not focused on an input field, we should remove the cursor.
         if(globals.cursorEntityId != -1){
-            deleteEntity(&globals.entities[globals.cursorEntityId]);
+            ecs_cmdDeleteEntity(globals.cursorEntityId);
             globals.cursorEntityId = -1;
         }
     }
 }
 
 /**
- * @brief Model system
- * Handles model update.
- * Atm we are not handling everything about the model here, just the update of model matrix.
- * Movement is handled in the input function, but will eventually be moved here or to a separate movement-system. 
- * Perhaps the model matrix update will move there aswell or maybe be handled in some kind of transform hierarchy system, 
- * since groups & hierarchy of entities should be something we would need when we try to build more complex scenes.
- * NOTE: Atm this is more of a placeholder for model matrix update logic, since we only handle rotation on x-axis and not even handling scale change. 
- * So atm only works with rigid body transforms.
+ * @brief Rebuild model matrices, only for transforms queued with transform_markDirty since last frame.
  */
 void modelSystem(){
-    // Look for transform needs update flag & update/recalc model matrix if needed.
-     for(int i = 0; i < MAX_ENTITIES; i++) {
-        if(globals.entities[i].alive == 1) {
-           if(globals.entities[i].transformComponent->modelNeedsUpdate == 1) {
-                    // create transformations
-                    mat4x4 model;
-                    mat4x4_identity(model);
+    transform_flushDirty(&globals.transforms);
+}
 
-                    // set model position
-                    mat4x4_translate(model, globals.entities[i].transformComponent->position[0],globals.entities[i].transformComponent->position[1],globals.entities[i].transformComponent->position[2]);
+/**
+ * @brief Collect the entities each render pass draws, so render only walks what it submits.
+ * Run after the last structural change of the frame (visibility, alive, components).
+ */
+void renderListSystem(){
+    RenderLists* lists = &globals.renderLists;
+    lists->shadow.count = 0;
+    lists->main.count = 0;
+    lists->linesAndPoints.count = 0;
+    lists->ui.count = 0;
+    lists->uiText.count = 0;
 
-                    // set model scale
-                    mat4x4_scale_aniso(model, (const float (*)[4])model, globals.entities[i].transformComponent->scale[0],globals.entities[i].transformComponent->scale[1],globals.entities[i].transformComponent->scale[2]);
-                
-                    // rotate model on x, y, and z axes
-                    // The cast on model tells the compiler that you're aware of the 
-                    // const requirement and that you're promising not to modify the model matrix.
-                    mat4x4 rotatedModelX, rotatedModelY, rotatedModelZ;
-                    mat4x4_rotate_X(rotatedModelX, (const float (*)[4])model, globals.entities[i].transformComponent->rotation[0]);
-                    mat4x4_rotate_Y(rotatedModelY, (const float (*)[4])rotatedModelX, globals.entities[i].transformComponent->rotation[1]);
-                    mat4x4_rotate_Z(rotatedModelZ, (const float (*)[4])rotatedModelY, globals.entities[i].transformComponent->rotation[2]);
-
-                    // Copy the rotated model matrix to the transform component
-                    memcpy(globals.entities[i].transformComponent->transform, rotatedModelZ, sizeof(mat4x4));
-
-                    globals.entities[i].transformComponent->modelNeedsUpdate = 0;
-           }
-          }}
+    for(int i = 0; i < MAX_ENTITIES; i++){
+        Entity* entity = &globals.entities[i];
+        if(entity->alive != 1){
+            continue;
+        }
+        bool isMesh = entity->meshComponent->active == 1;
+        bool isUi = entity->uiComponent->active == 1;
+        Material* material = getEntityMaterial(entity);
+        bool isPostProcess = material != NULL && material->isPostProcessMaterial;
+
+        // Shadows ignore visibility.
+        if(isMesh && !isUi && !isPostProcess){
+            lists->shadow.ids[lists->shadow.count++] = i;
+        }
+        if(!entity->visible){
+            continue;
+        }
+        if(isMesh && !isUi && !isPostProcess){
+            lists->main.ids[lists->main.count++] = i;
+        }
+        if(entity->lineComponent->active == 1 || entity->pointComponent->active == 1){
+            lists->linesAndPoints.ids[lists->linesAndPoints.count++] = i;
+        }
+        if(isMesh){
+            // Either the bounding boxes or the ui elements are drawn, never both.
+            if(globals.drawBoundingBoxes ? entity->tag == BOUNDING_BOX : (isUi && entity->tag != BOUNDING_BOX)){
+                lists->ui.ids[lists->ui.count++] = i;
+            }
+        }
+        if(isUi && strlen(entity->uiComponent->text) > 0){
+            lists->uiText.ids[lists->uiText.count++] = i;
+        }
+    }
 }
 
 void debugSystem(){
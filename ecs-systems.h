@@ -13,5 +13,6 @@ void modelSystem();
 void debugSystem();
 void uiSliderSystem();
 void uiCheckboxSystem();
+void renderListSystem();
 
 #endif
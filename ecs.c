@@ -1,5 +1,6 @@
 #include "ecs.h"
 #include "globals.h"
+#include "transform.h"
 
 //
 // Every entity get's all components attached to it and memory is allocated for all components.
@@ -17,6 +18,7 @@
 void initECS(){
     // Allocate memory for MAX_ENTITIES Components structs
     TransformComponent* transformComponents = allocateComponentMemory(sizeof(TransformComponent), "transform");
+    transform_initStorage(&globals.transforms, MAX_ENTITIES);
     GroupComponent* groupComponents = allocateComponentMemory(sizeof(GroupComponent), "group");
     MeshComponent* meshComponents = allocateComponentMemory(sizeof(MeshComponent), "mesh");
     MaterialComponent* materialComponents = allocateComponentMemory(sizeof(MaterialComponent), "material");
@@ -25,6 +27,11 @@ void initECS(){
     LineComponent* lineComponents = allocateComponentMemory(sizeof(LineComponent), "line");
     PointComponent* pointComponents = allocateComponentMemory(sizeof(PointComponent), "point");
     BoundingBoxComponent* boundingBoxComponents = allocateComponentMemory(sizeof(BoundingBoxComponent), "boundingBox");
+    globals.renderLists.shadow.ids = allocateComponentMemory(sizeof(int), "shadow render list");
+    globals.renderLists.main.ids = allocateComponentMemory(sizeof(int), "main render list");
+    globals.renderLists.linesAndPoints.ids = allocateComponentMemory(sizeof(int), "lines and points render list");
+    globals.renderLists.ui.ids = allocateComponentMemory(sizeof(int), "ui render list");
+    globals.renderLists.uiText.ids = allocateComponentMemory(sizeof(int), "ui text render list");
 
     // Allocate memory for MAX_ENTITIES Entity structs
     Entity* entities = (Entity*)calloc(MAX_ENTITIES, sizeof(Entity));
@@ -39,6 +46,7 @@ void initECS(){
         entities[i].id = i;
         entities[i].tag = UNINITIALIZED;
         entities[i].transformComponent = &transformComponents[i];
+        transform_bindComponent(entities[i].transformComponent, &globals.transforms, i);
         initializeTransformComponent(entities[i].transformComponent);
         entities[i].groupComponent = &groupComponents[i];
         initializeGroupComponent(entities[i].groupComponent);
@@ -90,10 +98,8 @@ void initializeTransformComponent(TransformComponent* transformComponent){
     transformComponent->scale[0] = 1.0f;
     transformComponent->scale[1] = 1.0f;
     transformComponent->scale[2] = 1.0f;
-    transformComponent->rotation[0] = 0.0f;
-    transformComponent->rotation[1] = 0.0f;
-    transformComponent->rotation[2] = 0.0f;
-    transformComponent->modelNeedsUpdate = 1;
+    quat_identity(transformComponent->rotation);
+    transformComponent->modelNeedsUpdate = 0; // storage starts out with identity matrices, addEntity queues it.
 }
 
 void initializeMatrix4(float (*matrix)[4][4]) {
@@ -102,7 +108,10 @@ void initializeMatrix4(float (*matrix)[4][4]) {
 
 void initializeGroupComponent(GroupComponent* groupComponent){
     groupComponent->active = 0;
-    initializeMatrix4(&groupComponent->transform);
+    groupComponent->parent = -1;
+    groupComponent->firstChild = -1;
+    groupComponent->nextSibling = -1;
+    groupComponent->childCount = 0;
 }
 
 void initializeMeshComponent(MeshComponent* meshComponent){
@@ -111,6 +120,7 @@ void initializeMeshComponent(MeshComponent* meshComponent){
     meshComponent->vertexCount = 5;
     meshComponent->indices = NULL;
     meshComponent->indexCount = 0;
+    meshComponent->packedMesh = NULL;
     meshComponent->gpuData = (GpuData*)malloc(sizeof(GpuData)); // TODO: replace with arena alloc?
     if(meshComponent->gpuData == NULL) {
         printf("Failed to allocate memory for gpuData\n");
@@ -122,32 +132,20 @@ void initializeMeshComponent(MeshComponent* meshComponent){
     meshComponent->gpuData->EBO = 0;
     meshComponent->gpuData->drawMode = GL_TRIANGLES; // Default draw mode
     meshComponent->gpuData->numIndicies = 0;
+    meshComponent->gpuData->indexType = GL_UNSIGNED_INT;
+    meshComponent->gpuData->vertexLayout = VERTEX_LAYOUT_FULL;
+    vec3_dup(meshComponent->gpuData->positionScale, (vec3){1.0f, 1.0f, 1.0f});
+    vec3_dup(meshComponent->gpuData->positionOffset, (vec3){0.0f, 0.0f, 0.0f});
 }
 
 void initializeMaterialComponent(MaterialComponent* materialComponent){
     materialComponent->active = 0;
-    materialComponent->ambient.r = 0.0f;
-    materialComponent->ambient.g = 0.0f;
-    materialComponent->ambient.b = 0.0f;
-    materialComponent->ambient.a = 1.0f;
     materialComponent->diffuse.r = 0.0f;
     materialComponent->diffuse.g = 0.0f;
     materialComponent->diffuse.b = 0.0f;
     materialComponent->diffuse.a = 1.0f;
-    materialComponent->specular.r = 0.0f;
-    materialComponent->specular.g = 0.0f;
-    materialComponent->specular.b = 0.0f;
-    materialComponent->specular.a = 1.0f;
-    materialComponent->shininess = 0.0f;
     materialComponent->diffuseMapOpacity = 0.0f;
-    materialComponent->diffuseMap = 0;
-    materialComponent->specularMap = 0;
     materialComponent->materialIndex = -1;
-    materialComponent->material_flags |= MATERIAL_DIFFUSEMAP_ENABLED;
-    materialComponent->material_flags |= MATERIAL_SPECULARMAP_ENABLED;
-    materialComponent->material_flags |= MATERIAL_AMBIENTMAP_ENABLED;
-    materialComponent->material_flags |= MATERIAL_SHININESSMAP_ENABLED;
-    materialComponent->isPostProcessMaterial = false; //TODO: move to material_flags?
 }
 
 
@@ -29,6 +29,8 @@ struct Globals {
     SDL_GLContext gl_context;
     int running;
     Entity* entities;
+    TransformStorage transforms;
+    RenderLists renderLists;
     int vertex_count;
     float delta_time;
     GLenum overideDrawMode;
@@ -54,17 +56,20 @@ struct Globals {
     bool culling;
     int drawCallsCounter;
     bool debugDrawCalls;
+    bool recordFrames; // every frame is captured to CAPTURE_RECORD_PATTERN while set
+    int recordedFrames;
     Arena assetArena;
     Arena uiArena;
+    Arena scratchArena; // temporary memory, e.g. while parsing. Growable, rewind with arena_mark/arena_rewind
     Material* materials;
     int materialsCount;
     int materialsCapacity;
-    int objDataCapacity;
     int focusedEntityId;
     float charScale;
     bool mouseDoubleClick;
     bool blinnMode;
     bool gamma;
+    bool compressedTextures; // the context takes ETC2 uploads, set once at startup (compressedTexturesSupported)
     GLuint depthMap;
     GLuint depthCubemap;
     mat4x4 lightSpaceMatrix[MAX_LIGHTSPACES];
@@ -88,6 +93,7 @@ struct Globals {
     Uint32 prevTick;
     bool showUI;
     bool shadows;
+    bool headless; // no window, rendering into an EGL pbuffer (see headless.h)
     
 };
 
@@ -97,6 +103,7 @@ extern Camera mainCamera;
 
 #define ASSET_MEMORY_SIZE 5000000
 #define UI_MEMORY_SIZE 5000000
+#define SCRATCH_MEMORY_SIZE (16 * 1024 * 1024)
 
 #ifdef DEV_MODE
     #define ASSERT(Expression,message) if (!(Expression)) { fprintf(stderr, "\x1b[31mAssertion failed: %s\x1b[0m\n", message); *(int *)0 = 0; }
@@ -0,0 +1,254 @@
+#include "gputimer.h"
+#include "opengl_types.h"
+#include "utils.h"
+#include "globals.h"
+#include "headless.h"
+#include "opengl.h"
+
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+typedef void (*GetQueryObjectui64vFunction)(GLuint id, GLenum pname, GLuint64* params);
+
+typedef struct GpuTimerFrame {
+    GLuint queries[GPU_TIMER_MAX_PASSES];
+    const char* names[GPU_TIMER_MAX_PASSES];
+    int count;
+    bool pending; // queries issued, results not read yet
+} GpuTimerFrame;
+
+typedef struct GpuTimerZone {
+    const char* name;
+    uint64_t history[PROFILER_STATS_FRAMES]; // ns per frame
+    int samples;
+} GpuTimerZone;
+
+static bool supported = false;
+static bool checkDisjoint = false; // only the EXT flavour reports disjoint events
+static GetQueryObjectui64vFunction getQueryObjectui64v = NULL;
+static GpuTimerFrame frames[GPU_TIMER_FRAMES_IN_FLIGHT];
+static int frameIndex = 0;
+static bool passOpen = false;
+static GpuTimerZone zones[GPU_TIMER_MAX_ZONES];
+static int zoneCount = 0;
+static int droppedFrames = 0;
+
+/**
+ * @brief GL entry point, from EGL in headless mode where SDL video isn't initialized.
+ */
+static GetQueryObjectui64vFunction gputimer_getProcAddress(const char* name){
+    GetQueryObjectui64vFunction function;
+    if(globals.headless){
+        function = (GetQueryObjectui64vFunction)headless_getProcAddress(name);
+    }else {
+        *(void**)&function = SDL_GL_GetProcAddress(name); // void* -> function pointer without a pedantic warning
+    }
+    return function;
+}
+
+/**
+ * @brief Look for timer query support. Needs a current GL context.
+ */
+void gputimer_init(){
+    const char* version = (const char*)glGetString(GL_VERSION);
+    bool isES = version != NULL && strncmp(version, "OpenGL ES", 9) == 0;
+
+    if(glExtensionSupported("GL_EXT_disjoint_timer_query") || glExtensionSupported("GL_EXT_disjoint_timer_query_webgl2")){
+        getQueryObjectui64v = gputimer_getProcAddress("glGetQueryObjectui64vEXT");
+        checkDisjoint = true;
+    }else if(!isES || glExtensionSupported("GL_ARB_timer_query")){
+        // Core in desktop GL 3.3, which is what we ask for natively.
+        getQueryObjectui64v = gputimer_getProcAddress("glGetQueryObjectui64v");
+    }
+    supported = getQueryObjectui64v != NULL;
+    if(!supported){
+        printf(TEXT_COLOR_WARNING "GPU timer queries not supported (%s), gpu pass timings disabled\n" TEXT_COLOR_RESET, version != NULL ? version : "unknown GL");
+        return;
+    }
+
+    for(int i = 0; i < GPU_TIMER_FRAMES_IN_FLIGHT; i++){
+        glGenQueries(GPU_TIMER_MAX_PASSES, frames[i].queries);
+        frames[i].count = 0;
+        frames[i].pending = false;
+    }
+    // Clear a disjoint flag raised before we started.
+    if(checkDisjoint){
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    }
+}
+
+void gputimer_shutdown(){
+    if(!supported){
+        return;
+    }
+    for(int i = 0; i < GPU_TIMER_FRAMES_IN_FLIGHT; i++){
+        glDeleteQueries(GPU_TIMER_MAX_PASSES, frames[i].queries);
+    }
+    supported = false;
+}
+
+bool gputimer_isSupported(){
+    return supported;
+}
+
+void gputimer_begin(const char* name){
+    if(!supported){
+        return;
+    }
+    GpuTimerFrame* frame = &frames[frameIndex];
+    ASSERT(!passOpen, "gpu timer passes can't nest");
+    if(passOpen || frame->count == GPU_TIMER_MAX_PASSES){
+        return;
+    }
+    frame->names[frame->count] = name;
+    glBeginQuery(GL_TIME_ELAPSED, frame->queries[frame->count]);
+    passOpen = true;
+}
+
+void gputimer_end(){
+    if(!supported || !passOpen){
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    frames[frameIndex].count++;
+    passOpen = false;
+}
+
+static GpuTimerZone* gputimer_findZone(const char* name){
+    for(int i = 0; i < zoneCount; i++){
+        if(zones[i].name == name || strcmp(zones[i].name, name) == 0){
+            return &zones[i];
+        }
+    }
+    if(zoneCount == GPU_TIMER_MAX_ZONES){
+        return NULL;
+    }
+    GpuTimerZone* zone = &zones[zoneCount++];
+    memset(zone, 0, sizeof(GpuTimerZone));
+    zone->name = name;
+    return zone;
+}
+
+/**
+ * @brief Read back results of frames whose queries are done. Never blocks.
+ */
+static void gputimer_collect(){
+    bool disjoint = false;
+    if(checkDisjoint){
+        GLint value = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &value);
+        disjoint = value != 0; // timer results of in flight frames are garbage (power state change etc)
+    }
+    // Oldest first, frameIndex is the slot that was written longest ago.
+    for(int i = 0; i < GPU_TIMER_FRAMES_IN_FLIGHT; i++){
+        GpuTimerFrame* frame = &frames[(frameIndex + i) % GPU_TIMER_FRAMES_IN_FLIGHT];
+        if(!frame->pending){
+            continue;
+        }
+        if(frame->count > 0){
+            // Queries finish in order, last one available means all are.
+            GLuint available = 0;
+            glGetQueryObjectuiv(frame->queries[frame->count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available){
+                break;
+            }
+            if(!disjoint){
+                for(int pass = 0; pass < frame->count; pass++){
+                    GLuint64 elapsed = 0;
+                    getQueryObjectui64v(frame->queries[pass], GL_QUERY_RESULT, &elapsed);
+                    GpuTimerZone* zone = gputimer_findZone(frame->names[pass]);
+                    if(zone != NULL){
+                        zone->history[zone->samples % PROFILER_STATS_FRAMES] = elapsed;
+                        zone->samples++;
+                    }
+                }
+            }
+        }
+        frame->pending = false;
+    }
+}
+
+/**
+ * @brief Close the frame's query set and read back finished frames. Call once per frame after the last pass.
+ */
+void gputimer_frameEnd(){
+    if(!supported){
+        return;
+    }
+    ASSERT(!passOpen, "gpu timer pass still open at frame end");
+    frames[frameIndex].pending = true;
+    frameIndex = (frameIndex + 1) % GPU_TIMER_FRAMES_IN_FLIGHT;
+    gputimer_collect();
+
+    // Still not done after a full ring, drop it rather than wait, its queries get reused now.
+    if(frames[frameIndex].pending){
+        frames[frameIndex].pending = false;
+        droppedFrames++;
+    }
+    frames[frameIndex].count = 0;
+}
+
+static void gputimer_rollingStats(GpuTimerZone* zone, uint64_t* min, double* avg, uint64_t* max){
+    int samples = zone->samples < PROFILER_STATS_FRAMES ? zone->samples : PROFILER_STATS_FRAMES;
+    uint64_t total = 0;
+    *min = UINT64_MAX;
+    *max = 0;
+    for(int i = 0; i < samples; i++){
+        uint64_t value = zone->history[i];
+        *min = value < *min ? value : *min;
+        *max = value > *max ? value : *max;
+        total += value;
+    }
+    *avg = samples > 0 ? total / (double)samples : 0.0;
+}
+
+/**
+ * @brief Rolling average gpu ns of a pass, 0 if unknown.
+ */
+double gputimer_zoneAverage(const char* name){
+    for(int i = 0; i < zoneCount; i++){
+        if(strcmp(zones[i].name, name) == 0){
+            uint64_t min, max;
+            double avg;
+            gputimer_rollingStats(&zones[i], &min, &avg, &max);
+            return avg;
+        }
+    }
+    return 0.0;
+}
+
+/**
+ * @brief Print gpu min/avg/max per pass next to the cpu average of the zone with the same name.
+ * A pass where gpu time is well above cpu time is gpu bound.
+ */
+void gputimer_printStats(){
+    printf("------------------------------------\n");
+    if(!supported){
+        printf("GPU pass timings unavailable, no timer query support\n");
+        printf("------------------------------------\n");
+        return;
+    }
+    printf("GPU passes, last %d frames (ms)\n", PROFILER_STATS_FRAMES);
+    printf("%-28s %9s %9s %9s %9s\n", "pass", "gpu min", "gpu avg", "gpu max", "cpu avg");
+    double gpuTotal = 0.0;
+    double cpuTotal = 0.0;
+    for(int i = 0; i < zoneCount; i++){
+        uint64_t min, max;
+        double avg;
+        gputimer_rollingStats(&zones[i], &min, &avg, &max);
+        double cpuAvg = profiler_zoneAverage(zones[i].name);
+        gpuTotal += avg;
+        cpuTotal += cpuAvg;
+        printf("%-28s %9.3f %9.3f %9.3f %9.3f\n", zones[i].name, min / 1e6, avg / 1e6, max / 1e6, cpuAvg / 1e6);
+    }
+    printf("%-28s %9s %9.3f %9s %9.3f\n", "total", "", gpuTotal / 1e6, "", cpuTotal / 1e6);
+    if(droppedFrames > 0){
+        printf("%d frames dropped, results not ready after %d frames\n", droppedFrames, GPU_TIMER_FRAMES_IN_FLIGHT);
+    }
+    printf("------------------------------------\n");
+}
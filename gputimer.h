@@ -0,0 +1,33 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "profiler.h"
+
+/**
+ * GPU pass timing with GL_TIME_ELAPSED queries (desktop GL 3.3 / ARB_timer_query, EXT_disjoint_timer_query on ES & WebGL2).
+ * Each frame gets its own set of queries in a ring of GPU_TIMER_FRAMES_IN_FLIGHT frames, results are read
+ * back only once available, a few frames later, so the cpu never waits on the gpu.
+ * Without timer query support every call is a no-op and the report says so.
+ * Time elapsed queries can't nest, so passes must not overlap.
+ */
+
+#define GPU_TIMER_FRAMES_IN_FLIGHT 4
+#define GPU_TIMER_MAX_PASSES 8
+#define GPU_TIMER_MAX_ZONES 16
+
+void gputimer_init();
+void gputimer_shutdown();
+bool gputimer_isSupported();
+void gputimer_begin(const char* name);
+void gputimer_end();
+void gputimer_frameEnd();
+double gputimer_zoneAverage(const char* name);
+void gputimer_printStats();
+
+// Cpu zone & gpu pass under the same name, so the report can show them side by side.
+#define RENDER_PASS_BEGIN(name) do { PROFILE_BEGIN(name); gputimer_begin(name); } while(0)
+#define RENDER_PASS_END() do { gputimer_end(); PROFILE_END(); } while(0)
+
+#endif
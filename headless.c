@@ -0,0 +1,293 @@
+#include "headless.h"
+#include "opengl_types.h"
+#include "utils.h"
+#include "globals.h"
+#include "profiler.h"
+#include "capture.h"
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+static EGLSurface surface = EGL_NO_SURFACE;
+#endif
+
+static HeadlessOptions options;
+static int frameWidth = 0;
+static int frameHeight = 0;
+static CameraKeyframe keyframes[HEADLESS_MAX_KEYFRAMES];
+static int keyframeCount = 0;
+static uint64_t* frameTimes = NULL; // ns per frame, update + render + gpu
+static int frameTimesCount = 0;
+
+static bool headless_loadCameraPath(const char* path){
+    FILE* fp = fopen(path, "r");
+    if(fp == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to open camera path %s\n" TEXT_COLOR_RESET, path);
+        return false;
+    }
+    char line[256];
+    int lineNumber = 0;
+    while(fgets(line, sizeof(line), fp) != NULL){
+        lineNumber++;
+        char* start = line;
+        while(*start == ' ' || *start == '\t'){
+            start++;
+        }
+        if(*start == '#' || *start == '\n' || *start == '\r' || *start == '\0'){
+            continue;
+        }
+        if(keyframeCount == HEADLESS_MAX_KEYFRAMES){
+            printf(TEXT_COLOR_ERROR "Camera path %s has more than %d keyframes\n" TEXT_COLOR_RESET, path, HEADLESS_MAX_KEYFRAMES);
+            fclose(fp);
+            return false;
+        }
+        CameraKeyframe* keyframe = &keyframes[keyframeCount];
+        int read = sscanf(start, "%d %f %f %f %f %f %f", &keyframe->frame,
+            &keyframe->position[0], &keyframe->position[1], &keyframe->position[2],
+            &keyframe->target[0], &keyframe->target[1], &keyframe->target[2]);
+        if(read != 7 || (keyframeCount > 0 && keyframe->frame <= keyframes[keyframeCount - 1].frame)){
+            printf(TEXT_COLOR_ERROR "Camera path %s:%d expected \"frame px py pz tx ty tz\" with increasing frames\n" TEXT_COLOR_RESET, path, lineNumber);
+            fclose(fp);
+            return false;
+        }
+        keyframeCount++;
+    }
+    fclose(fp);
+    if(keyframeCount == 0){
+        printf(TEXT_COLOR_ERROR "Camera path %s has no keyframes\n" TEXT_COLOR_RESET, path);
+        return false;
+    }
+    return true;
+}
+
+#ifdef __linux__
+/**
+ * @brief Surfaceless Mesa display if the EGL implementation has it, otherwise the default display.
+ */
+static EGLDisplay headless_getDisplay(){
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if(clientExtensions != NULL && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != NULL){
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if(getPlatformDisplay != NULL){
+            EGLDisplay surfaceless = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+            if(surfaceless != EGL_NO_DISPLAY){
+                return surfaceless;
+            }
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static bool headless_createContext(int width, int height){
+    display = headless_getDisplay();
+    EGLint major, minor;
+    if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)){
+        printf(TEXT_COLOR_ERROR "Failed to initialize EGL display (0x%x)\n" TEXT_COLOR_RESET, eglGetError());
+        return false;
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if(!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0){
+        printf(TEXT_COLOR_ERROR "No EGL config with OpenGL pbuffer support (0x%x)\n" TEXT_COLOR_RESET, eglGetError());
+        return false;
+    }
+    if(!eglBindAPI(EGL_OPENGL_API)){
+        printf(TEXT_COLOR_ERROR "EGL has no desktop OpenGL (0x%x)\n" TEXT_COLOR_RESET, eglGetError());
+        return false;
+    }
+
+    // Same version as the windowed context, the shaders are glsl 330 core.
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if(context == EGL_NO_CONTEXT){
+        printf(TEXT_COLOR_ERROR "Failed to create OpenGL 3.3 context (0x%x)\n" TEXT_COLOR_RESET, eglGetError());
+        return false;
+    }
+
+    const EGLint surfaceAttributes[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    if(surface == EGL_NO_SURFACE){
+        printf(TEXT_COLOR_ERROR "Failed to create %dx%d pbuffer (0x%x)\n" TEXT_COLOR_RESET, width, height, eglGetError());
+        return false;
+    }
+    if(!eglMakeCurrent(display, surface, surface, context)){
+        printf(TEXT_COLOR_ERROR "Failed to make headless context current (0x%x)\n" TEXT_COLOR_RESET, eglGetError());
+        return false;
+    }
+    printf("Headless EGL %d.%d, %s (%s)\n", major, minor, (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+    return true;
+}
+#endif
+
+/**
+ * @brief Create the offscreen context & make it current, load the camera path.
+ */
+bool headless_init(HeadlessOptions* headlessOptions, int width, int height){
+    options = *headlessOptions;
+    frameWidth = width;
+    frameHeight = height;
+
+    if(options.cameraPathFile != NULL && !headless_loadCameraPath(options.cameraPathFile)){
+        return false;
+    }
+    if(options.frames <= 0){
+        options.frames = keyframeCount > 0 ? keyframes[keyframeCount - 1].frame + 1 : 1;
+    }
+
+    #ifdef __linux__
+    if(!headless_createContext(width, height)){
+        headless_shutdown();
+        return false;
+    }
+    #else
+    printf(TEXT_COLOR_ERROR "Headless mode needs EGL, only supported on linux\n" TEXT_COLOR_RESET);
+    return false;
+    #endif
+
+    frameTimes = malloc(options.frames * sizeof(uint64_t));
+    if(frameTimes == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate headless frame buffers\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    return true;
+}
+
+/**
+ * @brief GL entry point from EGL, SDL_GL_GetProcAddress has no context to ask in headless mode.
+ */
+HeadlessProc headless_getProcAddress(const char* name){
+    #ifdef __linux__
+    return (HeadlessProc)eglGetProcAddress(name);
+    #else
+    return NULL;
+    #endif
+}
+
+void headless_shutdown(){
+    #ifdef __linux__
+    if(display != EGL_NO_DISPLAY){
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if(surface != EGL_NO_SURFACE){
+            eglDestroySurface(display, surface);
+        }
+        if(context != EGL_NO_CONTEXT){
+            eglDestroyContext(display, context);
+        }
+        eglTerminate(display);
+    }
+    display = EGL_NO_DISPLAY;
+    context = EGL_NO_CONTEXT;
+    surface = EGL_NO_SURFACE;
+    #endif
+    free(frameTimes);
+    frameTimes = NULL;
+}
+
+int headless_frameCount(){
+    return options.frames;
+}
+
+/**
+ * @brief Put the camera on the path, linear between the surrounding keyframes. Does nothing without a path.
+ */
+void headless_applyCameraPath(Camera* camera, int frame){
+    if(keyframeCount == 0){
+        return;
+    }
+    int next = 0;
+    while(next < keyframeCount && keyframes[next].frame < frame){
+        next++;
+    }
+    CameraKeyframe* a = &keyframes[next == 0 ? 0 : next - 1];
+    CameraKeyframe* b = &keyframes[next == keyframeCount ? keyframeCount - 1 : next];
+    float t = b->frame == a->frame ? 1.0f : (float)(frame - a->frame) / (float)(b->frame - a->frame);
+    t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+
+    vec3 target;
+    for(int i = 0; i < 3; i++){
+        camera->position[i] = a->position[i] + (b->position[i] - a->position[i]) * t;
+        target[i] = a->target[i] + (b->target[i] - a->target[i]) * t;
+    }
+    // Camera looks along front (fps mode), target follows from it.
+    vec3 front;
+    vec3_sub(front, target, camera->position);
+    if(vec3_len(front) > 0.0f){
+        vec3_norm(camera->front, front);
+    }
+    camera->viewMatrixNeedsUpdate = 1;
+}
+
+/**
+ * @brief Wait for the gpu, record the frame time & write the frame as png when an output dir is set.
+ * Call after render, frameStart from profiler_now before update.
+ */
+void headless_frameEnd(int frame, uint64_t frameStart){
+    glFinish(); // no swap paces the frames, wait so frame times include the gpu
+    if(frameTimesCount < options.frames){
+        frameTimes[frameTimesCount++] = profiler_now() - frameStart;
+    }
+    if(options.outputDir == NULL){
+        return;
+    }
+    // Encoded on the capture threads while the next frames render.
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    char path[CAPTURE_MAX_PATH];
+    snprintf(path, sizeof(path), "%s/frame_%05d.png", options.outputDir, frame);
+    capture_readPixels(frameWidth, frameHeight, path, CAPTURE_FORMAT_PNG);
+}
+
+/**
+ * @brief Write frame time stats (ms) of the finished run as json.
+ */
+bool headless_writeStats(){
+    if(options.statsPath == NULL || frameTimesCount == 0){
+        return false;
+    }
+    FILE* fp = fopen(options.statsPath, "w");
+    if(fp == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to open headless stats file %s\n" TEXT_COLOR_RESET, options.statsPath);
+        return false;
+    }
+    profiler_sortSamples(frameTimes, frameTimesCount);
+    double total = 0.0;
+    for(int i = 0; i < frameTimesCount; i++){
+        total += frameTimes[i];
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"frames\": %d,\n", frameTimesCount);
+    fprintf(fp, "  \"width\": %d,\n", frameWidth);
+    fprintf(fp, "  \"height\": %d,\n", frameHeight);
+    fprintf(fp, "  \"renderer\": \"%s\",\n", (const char*)glGetString(GL_RENDERER));
+    fprintf(fp, "  \"unit\": \"ms\",\n");
+    fprintf(fp, "  \"frameTime\": {\"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}\n",
+        frameTimes[0] / 1e6,
+        total / frameTimesCount / 1e6,
+        profiler_percentile(frameTimes, frameTimesCount, 50.0) / 1e6,
+        profiler_percentile(frameTimes, frameTimesCount, 90.0) / 1e6,
+        profiler_percentile(frameTimes, frameTimesCount, 95.0) / 1e6,
+        profiler_percentile(frameTimes, frameTimesCount, 99.0) / 1e6,
+        frameTimes[frameTimesCount - 1] / 1e6);
+    fprintf(fp, "}\n");
+    fclose(fp);
+    printf("Headless stats written to %s\n", options.statsPath);
+    return true;
+}
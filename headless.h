@@ -0,0 +1,47 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "types.h"
+
+/**
+ * Headless rendering, no window, display server or gpu needed (Mesa llvmpipe works).
+ * The GL 3.3 core context lives on an EGL pbuffer, on the Mesa surfaceless platform when available so there is no
+ * X11/Wayland dependency. The pbuffer is framebuffer 0, so render() works unchanged.
+ * Runs a fixed number of frames, optionally moving the main camera along a scripted path, and writes each frame
+ * as png and/or frame time statistics as json. Linux only.
+ *
+ * Camera path file, one keyframe per line, frames in between are interpolated linearly:
+ *   # frame  position x y z  target x y z
+ *   0   0 35 35   0 0 0
+ *   120 35 10 0   0 0 0
+ */
+
+#define HEADLESS_MAX_KEYFRAMES 256
+
+typedef struct HeadlessOptions {
+    bool enabled;
+    int frames;                 // 0 = length of camera path, or 1 without one
+    const char* cameraPathFile; // NULL = camera stays where initScene put it
+    const char* outputDir;      // NULL = don't write frames, directory must exist
+    const char* statsPath;      // NULL = don't write stats
+} HeadlessOptions;
+
+typedef struct CameraKeyframe {
+    int frame;
+    vec3 position;
+    vec3 target;
+} CameraKeyframe;
+
+typedef void (*HeadlessProc)(void);
+
+bool headless_init(HeadlessOptions* options, int width, int height);
+HeadlessProc headless_getProcAddress(const char* name);
+void headless_shutdown();
+int headless_frameCount();
+void headless_applyCameraPath(Camera* camera, int frame);
+void headless_frameEnd(int frame, uint64_t frameStart);
+bool headless_writeStats();
+
+#endif
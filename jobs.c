@@ -0,0 +1,312 @@
+#include "jobs.h"
+#include "utils.h"
+#include "globals.h"
+
+typedef struct JobRange {
+    JobRangeFunction function;
+    void* data;
+    int start;
+    int end;
+} JobRange;
+
+typedef struct JobWorker {
+    SDL_Thread* thread;
+    SDL_threadID threadId;
+    int index;
+} JobWorker;
+
+static JobDeque* deques = NULL; // index 0 is the main thread
+static JobDeque* backgroundDeque = NULL; // long jobs, FIFO, only taken by idle workers
+static JobWorker workers[JOBS_MAX_WORKERS + 1];
+static int threadCount = 1; // workers + main thread
+static SDL_atomic_t running;
+static SDL_sem* wakeSemaphore = NULL;
+
+static bool deque_push(JobDeque* deque, Job job){
+    bool pushed = false;
+    SDL_AtomicLock(&deque->lock);
+    if(deque->bottom - deque->top < JOBS_DEQUE_SIZE){
+        deque->jobs[deque->bottom & (JOBS_DEQUE_SIZE - 1)] = job;
+        deque->bottom++;
+        pushed = true;
+    }
+    SDL_AtomicUnlock(&deque->lock);
+    return pushed;
+}
+
+static bool deque_pop(JobDeque* deque, Job* job){
+    bool popped = false;
+    SDL_AtomicLock(&deque->lock);
+    if(deque->bottom > deque->top){
+        deque->bottom--;
+        *job = deque->jobs[deque->bottom & (JOBS_DEQUE_SIZE - 1)];
+        popped = true;
+    }
+    SDL_AtomicUnlock(&deque->lock);
+    return popped;
+}
+
+static bool deque_steal(JobDeque* deque, Job* job){
+    // Don't fight the owner over the lock, try another victim instead.
+    if(!SDL_AtomicTryLock(&deque->lock)){
+        return false;
+    }
+    bool stolen = false;
+    if(deque->bottom > deque->top){
+        *job = deque->jobs[deque->top & (JOBS_DEQUE_SIZE - 1)];
+        deque->top++;
+        stolen = true;
+    }
+    SDL_AtomicUnlock(&deque->lock);
+    return stolen;
+}
+
+static void jobs_execute(Job* job){
+    job->function(job->data);
+    if(job->counter != NULL){
+        SDL_AtomicAdd(&job->counter->value, -1);
+    }
+}
+
+/**
+ * @brief Get next job for thread, own deque first then steal round robin from the others.
+ */
+static bool jobs_next(int threadIndex, Job* job){
+    if(deque_pop(&deques[threadIndex], job)){
+        return true;
+    }
+    for(int i = 1; i < threadCount; i++){
+        int victim = (threadIndex + i) % threadCount;
+        if(deque_steal(&deques[victim], job)){
+            return true;
+        }
+    }
+    return false;
+}
+
+static int jobs_workerLoop(void* data){
+    JobWorker* worker = (JobWorker*)data;
+    worker->threadId = SDL_ThreadID();
+    Job job;
+    while(SDL_AtomicGet(&running)){
+        if(jobs_next(worker->index, &job) || deque_steal(backgroundDeque, &job)){
+            jobs_execute(&job);
+        }else {
+            // Timeout so a missed wakeup never stalls a worker for long.
+            SDL_SemWaitTimeout(wakeSemaphore, 2);
+        }
+    }
+    return 0;
+}
+
+static void jobs_rangeJob(void* data){
+    JobRange* range = (JobRange*)data;
+    range->function(range->data, range->start, range->end);
+}
+
+/**
+ * @brief Start the job system
+ * @param workerCount number of worker threads besides the main thread. 0 runs every job on the main thread inside jobs_wait.
+ */
+void jobs_init(int workerCount){
+    #ifdef __EMSCRIPTEN__
+    workerCount = 0; // No threads without pthreads build flags.
+    #endif
+    if(workerCount < 0){
+        workerCount = 0;
+    }
+    if(workerCount > JOBS_MAX_WORKERS){
+        workerCount = JOBS_MAX_WORKERS;
+    }
+
+    threadCount = workerCount + 1;
+    deques = calloc(threadCount + 1, sizeof(JobDeque));
+    if(deques == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate job deques\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    backgroundDeque = &deques[threadCount];
+    wakeSemaphore = SDL_CreateSemaphore(0);
+    CHECK_SDL_ERROR(wakeSemaphore == NULL, SDL_GetError());
+    SDL_AtomicSet(&running, 1);
+
+    workers[0].index = 0;
+    workers[0].threadId = SDL_ThreadID();
+    workers[0].thread = NULL;
+    for(int i = 1; i < threadCount; i++){
+        workers[i].index = i;
+        workers[i].threadId = 0;
+        workers[i].thread = SDL_CreateThread(jobs_workerLoop, "JobWorker", &workers[i]);
+        CHECK_SDL_ERROR(workers[i].thread == NULL, SDL_GetError());
+    }
+}
+
+void jobs_shutdown(){
+    if(deques == NULL){
+        return;
+    }
+    SDL_AtomicSet(&running, 0);
+    for(int i = 1; i < threadCount; i++){
+        SDL_SemPost(wakeSemaphore);
+    }
+    for(int i = 1; i < threadCount; i++){
+        SDL_WaitThread(workers[i].thread, NULL);
+    }
+    SDL_DestroySemaphore(wakeSemaphore);
+    free(deques);
+    deques = NULL;
+    backgroundDeque = NULL;
+    threadCount = 1;
+}
+
+int jobs_workerCount(){
+    return threadCount - 1;
+}
+
+/**
+ * @brief Index of calling thread, 0 for main thread (and any thread not owned by the job system).
+ */
+int jobs_threadIndex(){
+    SDL_threadID id = SDL_ThreadID();
+    for(int i = 1; i < threadCount; i++){
+        if(workers[i].threadId == id){
+            return i;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Queue a job on the calling thread's deque.
+ * @param counter optional, incremented now and decremented when the job has finished.
+ */
+void jobs_run(JobFunction function, void* data, JobCounter* counter){
+    ASSERT(deques != NULL, "jobs_run called before jobs_init");
+    Job job = {function, data, counter};
+    if(counter != NULL){
+        SDL_AtomicAdd(&counter->value, 1);
+    }
+    if(!deque_push(&deques[jobs_threadIndex()], job)){
+        // Deque full, run it here instead of dropping it.
+        jobs_execute(&job);
+        return;
+    }
+    SDL_SemPost(wakeSemaphore);
+}
+
+void jobs_runBatch(Job* jobs, int count, JobCounter* counter){
+    ASSERT(deques != NULL, "jobs_runBatch called before jobs_init");
+    if(counter != NULL){
+        SDL_AtomicAdd(&counter->value, count);
+    }
+    JobDeque* deque = &deques[jobs_threadIndex()];
+    for(int i = 0; i < count; i++){
+        jobs[i].counter = counter;
+        if(!deque_push(deque, jobs[i])){
+            jobs_execute(&jobs[i]);
+        }
+    }
+    int wake = count < threadCount - 1 ? count : threadCount - 1;
+    for(int i = 0; i < wake; i++){
+        SDL_SemPost(wakeSemaphore);
+    }
+}
+
+/**
+ * @brief Queue a long running job (file loading, decoding) that must not stall a frame.
+ * Only idle workers take these, never a thread inside jobs_wait, so a frame's fork-join doesn't end up
+ * waiting on one. Without workers they only run through jobs_runBackgroundJob.
+ * @param counter optional, incremented now and decremented when the job has finished.
+ */
+void jobs_runBackground(JobFunction function, void* data, JobCounter* counter){
+    ASSERT(deques != NULL, "jobs_runBackground called before jobs_init");
+    Job job = {function, data, counter};
+    if(counter != NULL){
+        SDL_AtomicAdd(&counter->value, 1);
+    }
+    if(!deque_push(backgroundDeque, job)){
+        jobs_execute(&job);
+        return;
+    }
+    SDL_SemPost(wakeSemaphore);
+}
+
+/**
+ * @brief Run the oldest background job on the calling thread. For the main thread when there are no workers.
+ * @return false if there was none (or a worker held the queue just then).
+ */
+bool jobs_runBackgroundJob(){
+    ASSERT(deques != NULL, "jobs_runBackgroundJob called before jobs_init");
+    Job job;
+    if(!deque_steal(backgroundDeque, &job)){
+        return false;
+    }
+    jobs_execute(&job);
+    return true;
+}
+
+bool jobs_isDone(JobCounter* counter){
+    return SDL_AtomicGet(&counter->value) == 0;
+}
+
+/**
+ * @brief Wait for counter to reach zero, executing queued jobs while waiting.
+ * Safe to call from inside a job (nested fork-join).
+ */
+void jobs_wait(JobCounter* counter){
+    int threadIndex = jobs_threadIndex();
+    Job job;
+    while(SDL_AtomicGet(&counter->value) > 0){
+        if(jobs_next(threadIndex, &job)){
+            jobs_execute(&job);
+        }else {
+            SDL_Delay(0); // yield, remaining jobs are running on other threads
+        }
+    }
+}
+
+/**
+ * @brief Split [0,count) into batches, run them as jobs and wait for all of them.
+ * @param minBatchSize smallest range given to one job, keeps tiny loops from drowning in overhead.
+ */
+void jobs_parallelFor(int count, int minBatchSize, JobRangeFunction function, void* data){
+    if(count <= 0){
+        return;
+    }
+    if(minBatchSize < 1){
+        minBatchSize = 1;
+    }
+
+    // Aim for a few batches per thread so stealing can balance uneven work.
+    int batchCount = threadCount * 4;
+    if(batchCount > JOBS_MAX_PARALLEL_FOR_BATCHES){
+        batchCount = JOBS_MAX_PARALLEL_FOR_BATCHES;
+    }
+    int batchSize = (count + batchCount - 1) / batchCount;
+    if(batchSize < minBatchSize){
+        batchSize = minBatchSize;
+    }
+    batchCount = (count + batchSize - 1) / batchSize;
+
+    if(batchCount == 1 || threadCount == 1){
+        function(data, 0, count);
+        return;
+    }
+
+    // Ranges live on this stack frame, fine since we wait before returning.
+    JobRange ranges[JOBS_MAX_PARALLEL_FOR_BATCHES];
+    Job jobs[JOBS_MAX_PARALLEL_FOR_BATCHES];
+    for(int i = 0; i < batchCount; i++){
+        ranges[i].function = function;
+        ranges[i].data = data;
+        ranges[i].start = i * batchSize;
+        ranges[i].end = (i + 1) * batchSize < count ? (i + 1) * batchSize : count;
+        jobs[i].function = jobs_rangeJob;
+        jobs[i].data = &ranges[i];
+        jobs[i].counter = NULL;
+    }
+
+    JobCounter counter = {{0}};
+    jobs_runBatch(jobs, batchCount, &counter);
+    jobs_wait(&counter);
+}
@@ -0,0 +1,54 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+/**
+ * Job system
+ * Each worker thread owns a deque. Owners push/pop at the bottom (LIFO, cache friendly),
+ * idle workers steal from the top (FIFO, oldest & usually biggest work).
+ * Fork-join is done with JobCounters: every job launched with a counter increments it,
+ * and decrements it when finished. jobs_wait() runs other jobs while the counter is non-zero,
+ * so waiting never blocks a thread that could be doing work.
+ * The main thread is worker 0 and only executes jobs while it is inside jobs_wait().
+ * Background jobs (jobs_runBackground) sit in a separate FIFO that only idle workers take from.
+ */
+
+#define JOBS_MAX_WORKERS 16
+#define JOBS_DEQUE_SIZE 4096 // Must be power of 2
+#define JOBS_MAX_PARALLEL_FOR_BATCHES 256
+
+typedef void (*JobFunction)(void* data);
+typedef void (*JobRangeFunction)(void* data, int start, int end);
+
+typedef struct JobCounter {
+    SDL_atomic_t value;
+} JobCounter;
+
+typedef struct Job {
+    JobFunction function;
+    void* data;
+    JobCounter* counter;
+} Job;
+
+typedef struct JobDeque {
+    SDL_SpinLock lock;
+    int top;    // steal end
+    int bottom; // owner end
+    Job jobs[JOBS_DEQUE_SIZE];
+} JobDeque;
+
+void jobs_init(int workerCount);
+void jobs_shutdown();
+int jobs_workerCount();
+int jobs_threadIndex();
+void jobs_run(JobFunction function, void* data, JobCounter* counter);
+void jobs_runBatch(Job* jobs, int count, JobCounter* counter);
+void jobs_runBackground(JobFunction function, void* data, JobCounter* counter);
+bool jobs_runBackgroundJob();
+void jobs_wait(JobCounter* counter);
+bool jobs_isDone(JobCounter* counter);
+void jobs_parallelFor(int count, int minBatchSize, JobRangeFunction function, void* data);
+
+#endif
@@ -0,0 +1,379 @@
+#include "loader.h"
+#include "utils.h"
+#include "globals.h"
+#include "opengl.h"
+#include "api.h"
+#include "ecs-entity.h"
+#include "transform.h"
+#include "jobs.h"
+#include "profiler.h"
+#include "texcompress.h"
+#include "texstream.h"
+
+typedef enum LoadRequestType {
+    LOAD_TEXTURE,
+    LOAD_MODEL
+} LoadRequestType;
+
+typedef struct LoadRequest {
+    LoadRequestType type;
+    char path[LOADER_MAX_PATH];
+    struct LoadRequest* next; // completion queue, then the loaded models list
+    // Texture
+    GLuint texture;      // handed out as the placeholder, filled in place
+    TextureParams params;
+    CompressedTexture compressed; // mapped .ktx, levelCount is 0 without one
+    TextureData image;   // decoded on a job thread when there's no compressed texture, data is NULL if that failed
+    bool dropped;        // texture deleted before it landed, loader_cancelTexture
+    struct LoadRequest* nextTexture; // in flight textures list
+    // Model
+    Entity* root;
+    ObjGroup* group;
+    Arena arena;         // owns the imported group, lives until loader_shutdown like the asset arena
+    bool materialsBound;
+    int attached;        // objects uploaded & parented to root so far
+    LoaderModelCallback onLoaded;
+    void* userData;
+} LoadRequest;
+
+// Filled by the job threads, drained by the main thread.
+static LoadRequest* completedHead = NULL;
+static LoadRequest* completedTail = NULL;
+static SDL_SpinLock completedLock = 0;
+
+static LoadRequest* loadedModels = NULL;
+static LoadRequest* texturesInFlight = NULL; // main thread only
+static JobCounter decoding = {{0}};
+static SDL_atomic_t cancelled;
+static int pendingCount = 0; // requested but not fully uploaded, main thread only
+static size_t budgetBytes = LOADER_UPLOAD_BUDGET_BYTES;
+static double budgetMs = LOADER_UPLOAD_BUDGET_MS;
+
+static LoadRequest* loader_createRequest(LoadRequestType type, const char* path){
+    LoadRequest* request = (LoadRequest*)calloc(1, sizeof(LoadRequest));
+    if(request == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate load request for %s\n" TEXT_COLOR_RESET, path);
+        exit(1);
+    }
+    request->type = type;
+    snprintf(request->path, sizeof(request->path), "%s", path);
+    return request;
+}
+
+static void loader_complete(LoadRequest* request){
+    SDL_AtomicLock(&completedLock);
+    if(completedTail != NULL){
+        completedTail->next = request;
+    }else {
+        completedHead = request;
+    }
+    completedTail = request;
+    SDL_AtomicUnlock(&completedLock);
+}
+
+static LoadRequest* loader_peekCompleted(){
+    SDL_AtomicLock(&completedLock);
+    LoadRequest* request = completedHead;
+    SDL_AtomicUnlock(&completedLock);
+    return request;
+}
+
+static void loader_popCompleted(){
+    SDL_AtomicLock(&completedLock);
+    completedHead = completedHead->next;
+    if(completedHead == NULL){
+        completedTail = NULL;
+    }
+    SDL_AtomicUnlock(&completedLock);
+}
+
+static void loader_decodeTexture(void* data){
+    LoadRequest* request = (LoadRequest*)data;
+    if(!SDL_AtomicGet(&cancelled)){
+        PROFILE_BEGIN("loader_decodeTexture");
+        if(!globals.compressedTextures || !texcompress_load(request->path, &request->compressed)){
+            TextureData* image = &request->image;
+            image->data = loadImage(request->path, &image->width, &image->height, &image->channels);
+            // Converted once, later runs map the .ktx. Images that can't be compressed upload as they are.
+            if(image->data != NULL && globals.compressedTextures && texcompress_build(request->path, image->data, image->width, image->height, image->channels, &request->compressed)){
+                stbi_image_free(image->data);
+                image->data = NULL;
+            }
+        }
+        PROFILE_END();
+    }
+    loader_complete(request);
+}
+
+static void loader_packObjects(void* data, int start, int end){
+    ObjGroup* group = (ObjGroup*)data;
+    for(int i = start; i < end; i++){
+        ObjData* obj = &group->objData[i];
+        // Mesh cache objects come packed already
+        if(obj->vertexData != NULL){
+            obj->packed = packMesh(obj->vertexData, obj->num_of_vertices, obj->indices, obj->num_of_indices, VERTEX_LAYOUT_COMPACT);
+        }
+    }
+}
+
+static void loader_importModel(void* data){
+    LoadRequest* request = (LoadRequest*)data;
+    if(!SDL_AtomicGet(&cancelled)){
+        PROFILE_BEGIN("loader_importModel");
+        Arena scratch;
+        arena_initScratch(&scratch, LOADER_SCRATCH_SIZE);
+        request->group = obj_importFile(request->path, &request->arena, &scratch);
+        arena_free(&scratch);
+        // Pack here too, so the main thread only copies into gpu buffers.
+        jobs_parallelFor(request->group->objectCount, 1, loader_packObjects, request->group);
+        PROFILE_END();
+    }
+    loader_complete(request);
+}
+
+/**
+ * @brief Queue an image for decoding. Goes around the texture cache, use texcache_acquire for shared textures.
+ * @return texture with a white placeholder pixel, the image is uploaded into it by loader_update.
+ */
+GLuint loader_loadTexture(const char* path, TextureParams params){
+    LoadRequest* request = loader_createRequest(LOAD_TEXTURE, path);
+    request->params = params;
+    request->texture = setupPlaceholderTexture(params);
+    request->nextTexture = texturesInFlight;
+    texturesInFlight = request;
+    pendingCount++;
+    jobs_runBackground(loader_decodeTexture, request, &decoding);
+    return request->texture;
+}
+
+/**
+ * @brief The texture is about to be deleted, skip uploading its image if it hasn't landed yet.
+ */
+void loader_cancelTexture(GLuint texture){
+    for(LoadRequest* request = texturesInFlight; request != NULL; request = request->nextTexture){
+        if(request->texture == texture){
+            request->dropped = true;
+        }
+    }
+}
+
+static void loader_removeInFlight(LoadRequest* request){
+    LoadRequest** link = &texturesInFlight;
+    while(*link != NULL && *link != request){
+        link = &(*link)->nextTexture;
+    }
+    if(*link != NULL){
+        *link = request->nextTexture;
+    }
+}
+
+/**
+ * @brief Queue an obj file for importing, the async createModel.
+ * @param onLoaded optional, called when every object is attached.
+ * @return root entity, the objects become its children as they are uploaded.
+ */
+Entity* loader_loadModel(const char* path, vec3 position, vec3 scale, vec3 rotation, LoaderModelCallback onLoaded, void* userData){
+    LoadRequest* request = loader_createRequest(LOAD_MODEL, path);
+    request->root = addEntity(MODEL);
+    setTransformData(request->root, position, scale, rotation);
+    arena_initScratch(&request->arena, LOADER_MODEL_ARENA_SIZE);
+    request->onLoaded = onLoaded;
+    request->userData = userData;
+    pendingCount++;
+    jobs_runBackground(loader_importModel, request, &decoding);
+    return request->root;
+}
+
+/**
+ * @brief Per frame upload budget. 0 turns that limit off.
+ */
+void loader_setUploadBudget(size_t bytes, double milliseconds){
+    budgetBytes = bytes;
+    budgetMs = milliseconds;
+}
+
+/**
+ * @brief Bytes the next loader_uploadStep of request sends to the gpu.
+ */
+static size_t loader_uploadCost(LoadRequest* request){
+    if(request->type == LOAD_TEXTURE){
+        if(request->dropped){
+            return 0;
+        }
+        if(request->compressed.levelCount > 0){
+            return texcompress_size(&request->compressed);
+        }
+        return request->image.data != NULL ? (size_t)request->image.width * request->image.height * request->image.channels : 0;
+    }
+    PackedMesh* packed = &request->group->objData[request->attached].packed;
+    size_t indexSize = packed->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    return (size_t)packed->vertexCount * packed->stride + (size_t)packed->indexCount * indexSize;
+}
+
+/**
+ * @brief Do the next piece of GL work for a completed request, a whole texture or one object of a model.
+ * @return true when the request is done.
+ */
+static bool loader_uploadStep(LoadRequest* request){
+    if(request->type == LOAD_TEXTURE){
+        if(request->dropped){
+            texcompress_free(&request->compressed);
+            if(request->image.data != NULL){
+                stbi_image_free(request->image.data);
+            }
+            return true;
+        }
+        if(request->compressed.levelCount > 0){
+            // Small mips now, texture streaming brings in the rest when it shows up on screen.
+            if(texstream_register(request->texture, &request->compressed, request->params.colorSpace)){
+                return true;
+            }
+            texcompress_free(&request->compressed);
+            // The driver refused it, decode the source here. Rare, the context was checked at startup.
+            TextureData* image = &request->image;
+            image->data = loadImage(request->path, &image->width, &image->height, &image->channels);
+        }
+        if(request->image.data == NULL || !uploadTexture(request->texture, request->image, request->params.colorSpace)){
+            printf(TEXT_COLOR_WARNING "Texture %s failed to load, keeping its placeholder\n" TEXT_COLOR_RESET, request->path);
+            if(request->image.data != NULL){
+                stbi_image_free(request->image.data);
+            }
+        }
+        return true;
+    }
+
+    if(!request->materialsBound){
+        // Parses the .mtl, its textures are queued like any other.
+        obj_bindMaterials(request->group);
+        request->materialsBound = true;
+    }
+    ObjData* obj = &request->group->objData[request->attached];
+    Entity* child = createObject(obj, (vec3){0.0f, 0.0f, 0.0f}, (vec3){1.0f, 1.0f, 1.0f}, (vec3){0.0f, 0.0f, 0.0f});
+    transform_setParent(child, request->root);
+    if(obj->vertexData != NULL){
+        // Packed by loader_importModel, the gpu has it now. The entity keeps the cpu vertices.
+        freePackedMesh(&obj->packed);
+        child->meshComponent->packedMesh = NULL;
+    }
+    request->attached++;
+    if(request->attached < request->group->objectCount){
+        return false;
+    }
+    printf("Model loaded: %s, %d objects\n", request->path, request->group->objectCount);
+    if(request->onLoaded != NULL){
+        request->onLoaded(request->root, request->userData);
+    }
+    return true;
+}
+
+static void loader_finishStep(LoadRequest* request){
+    if(!loader_uploadStep(request)){
+        return;
+    }
+    loader_popCompleted();
+    pendingCount--;
+    if(request->type == LOAD_MODEL){
+        // Entities point into its arena
+        request->next = loadedModels;
+        loadedModels = request;
+    }else {
+        loader_removeInFlight(request);
+        free(request);
+    }
+}
+
+/**
+ * @brief Upload finished loads until this frame's budget is spent. Call once per frame on the main thread.
+ */
+void loader_update(){
+    if(pendingCount == 0){
+        return;
+    }
+    PROFILE_BEGIN("loader_update");
+    Uint64 start = SDL_GetPerformanceCounter();
+    double ticksPerMs = SDL_GetPerformanceFrequency() / 1000.0;
+    if(jobs_workerCount() == 0){
+        // Nobody else takes background jobs.
+        jobs_runBackgroundJob();
+    }
+    size_t bytes = 0;
+    bool first = true;
+    LoadRequest* request;
+    while((request = loader_peekCompleted()) != NULL){
+        size_t cost = loader_uploadCost(request);
+        double elapsed = (SDL_GetPerformanceCounter() - start) / ticksPerMs;
+        bool overBytes = budgetBytes > 0 && bytes + cost > budgetBytes;
+        bool overTime = budgetMs > 0 && elapsed >= budgetMs;
+        // The first upload always goes, even one bigger than the whole budget.
+        if(!first && (overBytes || overTime)){
+            break;
+        }
+        bytes += cost;
+        first = false;
+        loader_finishStep(request);
+    }
+    PROFILE_END();
+}
+
+/**
+ * @brief Block until every requested asset is uploaded, ignores the budget. Headless runs use it to get the
+ * same frames every run.
+ */
+void loader_finish(){
+    PROFILE_BEGIN("loader_finish");
+    while(pendingCount > 0){
+        // Help with decoding, the workers may be busy.
+        bool decoded = jobs_runBackgroundJob();
+        LoadRequest* request = loader_peekCompleted();
+        if(request != NULL){
+            loader_finishStep(request);
+        }else if(!decoded){
+            SDL_Delay(1);
+        }
+    }
+    PROFILE_END();
+}
+
+int loader_pendingCount(){
+    return pendingCount;
+}
+
+/**
+ * @brief Drop loads that haven't landed & free the model arenas. Call before jobs_shutdown, entities from
+ * loaded models point into the arenas so only at quit.
+ */
+void loader_shutdown(){
+    // Queued jobs skip their work now, running ones finish first since they write into their request.
+    SDL_AtomicSet(&cancelled, 1);
+    while(!jobs_isDone(&decoding)){
+        if(!jobs_runBackgroundJob()){
+            SDL_Delay(1);
+        }
+    }
+    LoadRequest* request;
+    while((request = loader_peekCompleted()) != NULL){
+        loader_popCompleted();
+        if(request->type == LOAD_TEXTURE){
+            texcompress_free(&request->compressed);
+            if(request->image.data != NULL){
+                stbi_image_free(request->image.data);
+            }
+        }else {
+            for(int i = 0; request->group != NULL && i < request->group->objectCount; i++){
+                if(request->group->objData[i].vertexData != NULL){
+                    freePackedMesh(&request->group->objData[i].packed);
+                }
+            }
+            arena_free(&request->arena);
+        }
+        free(request);
+    }
+    texturesInFlight = NULL;
+    while(loadedModels != NULL){
+        request = loadedModels;
+        loadedModels = request->next;
+        arena_free(&request->arena);
+        free(request);
+    }
+    pendingCount = 0;
+}
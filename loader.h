@@ -0,0 +1,44 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stddef.h>
+#include "types.h"
+
+/**
+ * Asynchronous asset loading.
+ * Decoding runs as background jobs (jobs_runBackground): images as prebuilt ETC2 mip chains (texcompress,
+ * converted from the source through stb_image on first load), obj files through
+ * obj_importFile (parse, dedupe & mesh optimization, or the mesh cache) and packMesh. The finished cpu data goes
+ * on a completion queue that loader_update drains on the main thread once per frame, doing the GL work until
+ * the frame's upload budget is spent. At least one upload goes through per frame, so nothing starves.
+ *
+ * Callers get a handle right away, it is filled in place when the load lands:
+ * - textures: a GL texture holding a white pixel, the image is uploaded into the same texture object.
+ *   Compressed ones only get their small mips, texstream streams in the rest.
+ * - models: the root entity, each object becomes a child of it once its mesh is uploaded.
+ *
+ * Without worker threads (wasm, single core) loader_update runs one decode job per frame itself.
+ */
+
+#define LOADER_MAX_PATH 512
+// Default per frame budget, loader_setUploadBudget changes it.
+#define LOADER_UPLOAD_BUDGET_BYTES (8 * 1024 * 1024)
+#define LOADER_UPLOAD_BUDGET_MS 4.0
+#define LOADER_MODEL_ARENA_SIZE (1024 * 1024)   // first block of a model's arena, grows
+#define LOADER_SCRATCH_SIZE (16 * 1024 * 1024)  // first block of an import's scratch arena, grows
+
+/**
+ * @brief Called on the main thread once every object of a model is attached to root.
+ */
+typedef void (*LoaderModelCallback)(Entity* root, void* userData);
+
+GLuint loader_loadTexture(const char* path, TextureParams params);
+void loader_cancelTexture(GLuint texture);
+Entity* loader_loadModel(const char* path, vec3 position, vec3 scale, vec3 rotation, LoaderModelCallback onLoaded, void* userData);
+void loader_setUploadBudget(size_t bytes, double milliseconds);
+void loader_update();
+void loader_finish();
+int loader_pendingCount();
+void loader_shutdown();
+
+#endif
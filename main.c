@@ -13,6 +13,19 @@
 #include "ecs-systems.h"
 #include "api.h"
 #include "assets.h"
+#include "jobs.h"
+#include "transform.h"
+#include "ecs-commands.h"
+#include "snapshot.h"
+#include "meshcache.h"
+#include "loader.h"
+#include "texcache.h"
+#include "texstream.h"
+#include "pack.h"
+#include "profiler.h"
+#include "gputimer.h"
+#include "headless.h"
+#include "capture.h"
 
 
 // Stb
@@ -37,6 +50,9 @@ void lightDirectionChange(void *params);
 Camera* initCamera();
 
 #define ARRAY_COUNT(arr) (sizeof(arr) / sizeof((arr)[0]))
+#define SCENE_OBJ_PATH "./Assets/arbetsrum_FINAL.obj"
+#define SCENE_SNAPSHOT_PATH "./Assets/arbetsrum_FINAL.snap"
+#define PROFILER_TRACE_PATH "profile_trace.json"
 
 //------------------------------------------------------
 // Global variables / Initialization
@@ -81,11 +97,12 @@ struct Globals globals = {
     .culling=false,
     .drawCallsCounter=0,
     .debugDrawCalls=false,
+    .recordFrames=false,
+    .recordedFrames=0,
     //.assetArena=NULL,
     .materials=NULL,
     .materialsCount=0,
-    .materialsCapacity=15,
-    .objDataCapacity=20000,
+    .materialsCapacity=MATERIALS_INITIAL_CAPACITY, // grows
     .lights={{0}},
     .lightsCount=0,
     .focusedEntityId=-1,
@@ -112,6 +129,7 @@ struct Globals globals = {
     .prevTick = 0,
     .showUI = true,
     .shadows = true,
+    .headless = false,
     
 };
 
@@ -124,6 +142,10 @@ Color green = {0.0f, 1.0f, 0.0f, 1.0f};
 #define FPS 60
 #define FRAME_TARGET_TIME (1000 / FPS)
 int last_frame_time = 0;
+const char* profileTracePath = NULL; // set by --profile-trace
+HeadlessOptions headlessOptions = {0}; // set by --headless & friends
+static const char defaultPackPath[] = PACK_DEFAULT_PATH;
+const char* packPath = defaultPackPath; // set by --pack, a missing default pack is fine
 
 //------------------------------------------------------
 // SDL, OpenGL & PROGRAM INITIALIZATION
@@ -328,8 +350,14 @@ void createLightSpace(){
 }
 
 void initProgram(){
-    initWindow();
+    // Headless has no window, its context is created in main.
+    if(!globals.headless){
+        initWindow();
+    }
     initECS();
+    ecs_initCommandBuffers();
+    // Main thread counts as a worker while it waits on jobs, so leave one core for it.
+    jobs_init(SDL_GetCPUCount() - 1);
 }
 
 /*
@@ -384,7 +412,7 @@ void updateUIonViewportChange(float prevWidth, float prevHeight,float ui_percent
             globals.entities[i].boundingBoxComponent->boundingBox.max[0] = globals.entities[i].transformComponent->scale[0];
             globals.entities[i].boundingBoxComponent->boundingBox.max[1] = globals.entities[i].transformComponent->scale[1];
 
-            globals.entities[i].transformComponent->modelNeedsUpdate = 1;
+            transform_markDirty(globals.entities[i].transformComponent);
         }
     }
 }
@@ -487,6 +515,17 @@ void handleKeyInput(){
                 globals.debugDrawCalls = true;
                 printf("Debug drawcalls enabled\n");
             }
+            if(strcmp(key, "F10") == 0) {
+                // Pressing F10 starts/stops writing every frame to disk
+                globals.recordFrames = !globals.recordFrames;
+                printf("Frame recording %s\n", globals.recordFrames ? "started" : "stopped");
+            }
+            if(strcmp(key, "F9") == 0) {
+                // Pressing F9 prints zone timings and writes a chrome://tracing / Perfetto trace of the last frames
+                profiler_printStats();
+                gputimer_printStats();
+                profiler_dumpTrace(PROFILER_TRACE_PATH);
+            }
             if(strcmp(key, "B") == 0) {
                 globals.drawBoundingBoxes = !globals.drawBoundingBoxes;
             }
@@ -725,29 +764,65 @@ void update(){
     // Time 
     Uint32 ticks = SDL_GetTicks();
 
-    // Cap the frame rate
-    int time_to_wait = FRAME_TARGET_TIME - (ticks - last_frame_time);
-    if(time_to_wait > 0 && time_to_wait <= FRAME_TARGET_TIME) {
-        SDL_Delay(time_to_wait);
-    }
+    if(globals.headless){
+        // Fixed step, same frames every run.
+        globals.delta_time = 1.0f / FPS;
+    }else {
+        // Cap the frame rate
+        int time_to_wait = FRAME_TARGET_TIME - (ticks - last_frame_time);
+        if(time_to_wait > 0 && time_to_wait <= FRAME_TARGET_TIME) {
+            SDL_Delay(time_to_wait);
+        }
 
-    // Set delta time in seconds
-    globals.delta_time = (SDL_GetTicks() - last_frame_time) / 1000.0f;
+        // Set delta time in seconds
+        globals.delta_time = (SDL_GetTicks() - last_frame_time) / 1000.0f;
+
+        displayFps(ticks);
+    }
 
-   displayFps(ticks);
+    // Finished asset loads, within the upload budget
+    loader_update();
     
    
 
     // Systems
+    PROFILE_BEGIN("cameraSystem");
     cameraSystem();
+    PROFILE_END();
+    PROFILE_BEGIN("uiPositionSystem");
     uiPositionSystem();
+    PROFILE_END();
+    PROFILE_BEGIN("uiInputSystem");
     uiInputSystem();
+    PROFILE_END();
+    PROFILE_BEGIN("hoverAndClickSystem");
     hoverAndClickSystem();
+    PROFILE_END();
+    PROFILE_BEGIN("uiSliderSystem");
     uiSliderSystem();
+    PROFILE_END();
+    PROFILE_BEGIN("uiCheckboxSystem");
     uiCheckboxSystem();
+    PROFILE_END();
+    PROFILE_BEGIN("textCursorSystem");
     textCursorSystem();
+    PROFILE_END();
+    PROFILE_BEGIN("ecs_playbackCommands");
+    ecs_playbackCommands(); // sync point, apply structural changes recorded by ui systems & callbacks
+    PROFILE_END();
+    PROFILE_BEGIN("movementSystem");
     movementSystem();
+    PROFILE_END();
+    PROFILE_BEGIN("modelSystem");
     modelSystem();
+    PROFILE_END();
+    PROFILE_BEGIN("ecs_playbackCommands");
+    ecs_playbackCommands();
+    PROFILE_END();
+    PROFILE_BEGIN("renderListSystem");
+    renderListSystem();
+    PROFILE_END();
+    texstream_update(); // sizes textures from the main list
     globals.prevMouseLeftDown = globals.mouseLeftButtonPressed;
 }
 
@@ -788,118 +863,96 @@ void render(){
    
    // Render depth map
    // TODO: GL_CULL_FACE to avoid Peter panning?
+   RenderLists* lists = &globals.renderLists;
    if(globals.shadows){
+    RENDER_PASS_BEGIN("shadowPass");
     createLightSpace();
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, globals.depthMapBuffer.FBO);
     
     glEnable(GL_DEPTH_TEST);
-        for(int i = 0; i < MAX_ENTITIES; i++) {
-            if(globals.entities[i].alive == 1) {
-                if(globals.entities[i].meshComponent->active == 1) {
-                    if(globals.entities[i].uiComponent->active != 1){
-                        if(!globals.entities[i].materialComponent->isPostProcessMaterial){
-                            depthshadow_renderToDepthTexture(globals.entities[i].meshComponent->gpuData,globals.entities[i].transformComponent);
-                        }
-                    }
-                }
-            }
+        for(int n = 0; n < lists->shadow.count; n++) {
+            Entity* entity = &globals.entities[lists->shadow.ids[n]];
+            depthshadow_renderToDepthTexture(entity->meshComponent->gpuData,entity->transformComponent);
         }
 
     // Enable color buffer writes again
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    RENDER_PASS_END();
    }
   
    // Render main view & 3d objects
+   RENDER_PASS_BEGIN("mainPass");
    setViewportAndClear(globals.views.full);
    setFontProjection(&globals.gpuFontData,globals.views.full);
-    for(int i = 0; i < MAX_ENTITIES; i++) {
-        if(globals.entities[i].alive == 1 && globals.entities[i].visible) {
-            if(globals.entities[i].meshComponent->active == 1) {
-                if(globals.entities[i].uiComponent->active != 1){
-                   if(!globals.entities[i].materialComponent->isPostProcessMaterial){
-                     renderMesh( globals.entities[i].meshComponent->gpuData, globals.entities[i].transformComponent, globals.views.main.camera,globals.entities[i].materialComponent );
-                   }
-                    
-                }
-            }
-        }
+    for(int n = 0; n < lists->main.count; n++) {
+        Entity* entity = &globals.entities[lists->main.ids[n]];
+        renderMesh(entity->meshComponent->gpuData, entity->transformComponent, globals.views.main.camera, entity->materialComponent);
     }
     
+    RENDER_PASS_END();
+
     // Render GL_LINES & GL_POINTS(particles)
-    for(int i = 0; i < MAX_ENTITIES; i++){
-        if((globals.entities[i].alive == 1 && globals.entities[i].lineComponent->active == 1 && globals.entities[i].visible) 
-        || (globals.entities[i].alive == 1 && globals.entities[i].pointComponent->active == 1 && globals.entities[i].visible)){
-            if(globals.entities[i].lineComponent->active == 1){
-              renderLine(globals.entities[i].lineComponent->gpuData,globals.entities[i].transformComponent,globals.views.main.camera,globals.entities[i].lineComponent->color);
-            }
-            if(globals.entities[i].pointComponent->active == 1){
-                // NOTE: point Size is not drawing anything else than 1.0 in windows/wsl2.
-                // Get point size range ( use this to debug pointSize or later at init to tell support or not of pointsize )
-                //GLfloat    pointSizeRange[2];
-                //glGetFloatv ( GL_ALIASED_POINT_SIZE_RANGE, pointSizeRange );
-                // Print the point size range
-                //printf("Point size range: min = %f, max = %f\n", pointSizeRange[0], pointSizeRange[1]);
-                renderPoints(
-                    globals.entities[i].pointComponent->gpuData,
-                    globals.entities[i].transformComponent, 
-                    globals.views.main.camera, 
-                    globals.entities[i].pointComponent->color,
-                    globals.entities[i].pointComponent->pointSize
-                );
-            }
-             
-               
-            
+    RENDER_PASS_BEGIN("linesAndPointsPass");
+    for(int n = 0; n < lists->linesAndPoints.count; n++){
+        Entity* entity = &globals.entities[lists->linesAndPoints.ids[n]];
+        if(entity->lineComponent->active == 1){
+          renderLine(entity->lineComponent->gpuData,entity->transformComponent,globals.views.main.camera,entity->lineComponent->color);
+        }
+        if(entity->pointComponent->active == 1){
+            // NOTE: point Size is not drawing anything else than 1.0 in windows/wsl2.
+            // Get point size range ( use this to debug pointSize or later at init to tell support or not of pointsize )
+            //GLfloat    pointSizeRange[2];
+            //glGetFloatv ( GL_ALIASED_POINT_SIZE_RANGE, pointSizeRange );
+            // Print the point size range
+            //printf("Point size range: min = %f, max = %f\n", pointSizeRange[0], pointSizeRange[1]);
+            renderPoints(
+                entity->pointComponent->gpuData,
+                entity->transformComponent, 
+                globals.views.main.camera, 
+                entity->pointComponent->color,
+                entity->pointComponent->pointSize
+            );
         }
     }
 
+    RENDER_PASS_END();
+
     // Render ui scene & ui objects
     if(globals.showUI){
-        for(int i = 0; i < MAX_ENTITIES; i++) {
-            if(globals.entities[i].alive == 1 && globals.entities[i].visible) {
-                if(globals.entities[i].meshComponent->active == 1) {
-                            // render ui, could be overhead with switching viewports?. profile.    
-                            if(globals.drawBoundingBoxes){
-                                if(globals.entities[i].tag == BOUNDING_BOX){
-                                    renderMesh(globals.entities[i].meshComponent->gpuData,globals.entities[i].transformComponent,globals.views.ui.camera, globals.entities[i].materialComponent);
-                                }
-                            }else {
-                                if(globals.entities[i].uiComponent->active == 1 && globals.entities[i].tag != BOUNDING_BOX){
-                                    renderMesh(globals.entities[i].meshComponent->gpuData,globals.entities[i].transformComponent,globals.views.ui.camera, globals.entities[i].materialComponent);
-                                }
-                            }
-                }
-            }
+        RENDER_PASS_BEGIN("uiPass");
+        // render ui, could be overhead with switching viewports?. profile.
+        for(int n = 0; n < lists->ui.count; n++) {
+            Entity* entity = &globals.entities[lists->ui.ids[n]];
+            renderMesh(entity->meshComponent->gpuData,entity->transformComponent,globals.views.ui.camera, entity->materialComponent);
         }
         
+        RENDER_PASS_END();
+
         // render ui text
+        RENDER_PASS_BEGIN("uiTextPass");
         setFontProjection(&globals.gpuFontData,globals.views.ui);
         glDisable(GL_DEPTH_TEST);
-        for(int i = 0; i < MAX_ENTITIES; i++) {
-            if(globals.entities[i].alive == 1 && globals.entities[i].visible) {
-                    if(globals.entities[i].uiComponent->active == 1){
-                        if(strlen(globals.entities[i].uiComponent->text) > 0){
-                        
-                            // convert transform position to viewport space
-                            vec2 result;
-                            convertUIcoordinateToWindowcoordinates(
-                                globals.views.ui,
-                                globals.entities[i].transformComponent,
-                                globals.views.full.rect.height,
-                                globals.views.full.rect.width,
-                                result);
-                        
-                                // align text center vertically
-                                result[1] -= (float)globals.characters[0].Size[1] / 4.0;
-                            renderText(
-                                &globals.gpuFontData, 
-                                globals.entities[i].uiComponent->text, 
-                                result[0],result[1],
-                                globals.charScale,globals.textColor);
-                        }
-                    }
-            }
+        for(int n = 0; n < lists->uiText.count; n++) {
+            Entity* entity = &globals.entities[lists->uiText.ids[n]];
+
+            // convert transform position to viewport space
+            vec2 result;
+            convertUIcoordinateToWindowcoordinates(
+                globals.views.ui,
+                entity->transformComponent,
+                globals.views.full.rect.height,
+                globals.views.full.rect.width,
+                result);
+        
+            // align text center vertically
+            result[1] -= (float)globals.characters[0].Size[1] / 4.0;
+            renderText(
+                &globals.gpuFontData, 
+                entity->uiComponent->text, 
+                result[0],result[1],
+                globals.charScale,globals.textColor);
         }  
+        RENDER_PASS_END();
      }
 
    
@@ -907,15 +960,50 @@ void render(){
    
     #endif
 
+    gputimer_frameEnd();
+
+    if(globals.recordFrames){
+        char path[CAPTURE_MAX_PATH];
+        snprintf(path, sizeof(path), CAPTURE_RECORD_PATTERN, globals.recordedFrames++);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        capture_readPixels(globals.views.full.rect.width, globals.views.full.rect.height, path, CAPTURE_FORMAT_PPM);
+    }
+    capture_frameEnd();
+
     // Swap the window buffers to show the new frame
-    SDL_GL_SwapWindow(globals.window); 
+    if(!globals.headless){
+        PROFILE_BEGIN("swapWindow");
+        SDL_GL_SwapWindow(globals.window); 
+        PROFILE_END();
+    }
 }
 
 void quit(){
     // Release resources
-    SDL_GL_DeleteContext(globals.gl_context);
-    SDL_DestroyRenderer(globals.renderer);
-    SDL_DestroyWindow(globals.window);
+    loader_shutdown(); // waits for running load jobs
+    snapshot_unload(); // releases its textures, before texcache_shutdown
+    texstream_shutdown();
+    texcache_shutdown();
+    materials_shutdown();
+    capture_shutdown(); // flushes pending captures, needs the GL context & the job system
+    jobs_shutdown();
+    if(profileTracePath != NULL){
+        profiler_printStats();
+        gputimer_printStats();
+        profiler_dumpTrace(profileTracePath);
+    }
+    gputimer_shutdown();
+    profiler_shutdown();
+    meshcache_unload();
+    pack_close(); // last, anything above may still point into it
+    if(globals.headless){
+        headless_writeStats();
+        headless_shutdown();
+    }else {
+        SDL_GL_DeleteContext(globals.gl_context);
+        SDL_DestroyRenderer(globals.renderer);
+        SDL_DestroyWindow(globals.window);
+    }
     SDL_Quit();
 }
 
@@ -941,6 +1029,28 @@ void initFont(){
     setupMaterial(&globals.gpuFontData,"shaders/text_vertex.glsl", "shaders/text_fragment.glsl");
 }
 
+/**
+ * @brief Run the requested number of frames without input, camera driven by the camera path.
+ */
+void headlessLoop(){
+    int frames = headless_frameCount();
+    for(int frame = 0; frame < frames && globals.running; frame++){
+        PROFILE_BEGIN("frame");
+        uint64_t frameStart = profiler_now();
+        headless_applyCameraPath(globals.views.main.camera, frame);
+        PROFILE_BEGIN("update");
+        update();
+        PROFILE_END();
+        PROFILE_BEGIN("render");
+        render();
+        PROFILE_END();
+        headless_frameEnd(frame, frameStart);
+        debugSystem();
+        PROFILE_END();
+        profiler_frameEnd();
+    }
+}
+
 #ifdef __EMSCRIPTEN__
 void emscriptenLoop() {
     if(!globals.running){
@@ -949,14 +1059,33 @@ void emscriptenLoop() {
         printf("Goodbye!\n");
         emscripten_cancel_main_loop();
     }
+    PROFILE_BEGIN("frame");
+    PROFILE_BEGIN("input");
     input();
+    PROFILE_END();
+    PROFILE_BEGIN("update");
     update();
+    PROFILE_END();
+    PROFILE_BEGIN("render");
     render();
+    PROFILE_END();
+    PROFILE_END();
+    profiler_frameEnd();
 }
 #endif
 
 
 
+/**
+ * @brief Save the scene snapshot once the scene obj has loaded, the next start skips the obj.
+ */
+static void onSceneLoaded(Entity* root, void* userData){
+    (void)userData;
+    // The obj & the .mtl next to it, a change to either rebuilds the snapshot.
+    static const char* const sources[] = { SCENE_OBJ_PATH, "./Assets/arbetsrum_FINAL.mtl" };
+    snapshot_save(SCENE_SNAPSHOT_PATH, sources, sizeof(sources) / sizeof(sources[0]), &root, 1);
+}
+
 /**
  * @brief Initialize the scene
  * Create the 3d and ui scene objects
@@ -1000,7 +1129,6 @@ void initScene(){
     ObjGroup* teapot = obj_loadFile("./Assets/teapot.obj");*/
   //  ObjGroup* dragon = obj_loadFile("./Assets/dragon.obj");   
    // ObjGroup* textured_objects = obj_loadFile("./Assets/textured_objects.obj");
-    ObjGroup* skp_arbetsrum = obj_loadFile("./Assets/arbetsrum_FINAL.obj");
  
   
    
@@ -1024,10 +1152,11 @@ void initScene(){
         createObject(&truck->objData[i],(vec3){0.0f, 0.0f, 0.0f}, (vec3){1.0f, 1.0f, 1.0f}, (vec3){0.0f, 0.0f, 0.0f});
     } */
   
-    createObject(&skp_arbetsrum->objData[0],(vec3){0.0f, 0.0f, 0.0f}, (vec3){1.0f, 1.0f, 1.0f}, (vec3){0.0f, 0.0f, 0.0f});
-    createObject(&skp_arbetsrum->objData[1],(vec3){0.0f, 0.0f, 0.0f}, (vec3){1.0f, 1.0f, 1.0f}, (vec3){0.0f, 0.0f, 0.0f});
-    createObject(&skp_arbetsrum->objData[2],(vec3){0.0f, 0.0f, 0.0f}, (vec3){1.0f, 1.0f, 1.0f}, (vec3){0.0f, 0.0f, 0.0f});
-    createObject(&skp_arbetsrum->objData[3],(vec3){0.0f, 0.0f, 0.0f}, (vec3){1.0f, 1.0f, 1.0f}, (vec3){0.0f, 0.0f, 0.0f}); 
+    // Snapshot of the parsed obj scene. It stores stamps of the obj & mtl, a snapshot from older files is rebuilt.
+    // Without one the obj streams in over the first frames and the snapshot is written once it's all there.
+    if(!snapshot_load(SCENE_SNAPSHOT_PATH)){
+        loader_loadModel(SCENE_OBJ_PATH,(vec3){0.0f, 0.0f, 0.0f}, (vec3){1.0f, 1.0f, 1.0f}, (vec3){0.0f, 0.0f, 0.0f},onSceneLoaded,NULL);
+    }
   
   /*   createObject(&truck->objData[0],(vec3){1.0f, 0.0f, 0.0f}, (vec3){1.0f, 1.0f, 1.0f}, (vec3){0.0f, 0.0f, 0.0f});
     createObject(&truck->objData[1],(vec3){1.0f, 0.0f, 0.0f}, (vec3){1.0f, 1.0f, 1.0f}, (vec3){0.0f, 0.0f, 0.0f});
@@ -1152,6 +1281,12 @@ void initScene(){
  // Textured button
  //ui_createButton(uiMaterial, (vec3){150.0f, 0.0f, 0.0f}, (vec3){150.0f, 50.0f, 100.0f}, (vec3){0.0f, 0.0f, 0.0f}, "Rotate",onButtonClick);
   
+    if(globals.headless){
+        // Loads landing on whatever frame they finish would make every run different.
+        loader_finish();
+        texstream_setBudget(TEXSTREAM_MEMORY_BUDGET_BYTES, 0); // and textures streaming in over several frames
+    }
+
    // TODO: create slider or input for ui using this
   printf("materials-list (%d): \n",globals.materialsCount);
     for(int i = 0; i < globals.materialsCount; i++){
@@ -1187,9 +1322,10 @@ int main(int argc, char **argv) {
     // Initialize Memory Arenas
     arena_initMemory(&globals.assetArena, ASSET_MEMORY_SIZE * sizeof(Vertex));
     arena_initMemory(&globals.uiArena, UI_MEMORY_SIZE * sizeof(char));
+    arena_initScratch(&globals.scratchArena, SCRATCH_MEMORY_SIZE);
 
     // Sub memory allocations
-    globals.materials = arena_Alloc(&globals.assetArena, globals.materialsCapacity * sizeof(Material));
+    materials_init(globals.materialsCapacity); // grows when full
     // BELOW NOT YET IMPLEMENTED
     //globals.textures = arena_Alloc(&globals.assetArena, globals.texturesCapacity * sizeof(Texture));
     //globals.meshes = arena_Alloc(&globals.assetArena, globals.meshCapacity * sizeof(MeshComponent));
@@ -1198,13 +1334,53 @@ int main(int argc, char **argv) {
     //globals.ui_elements = arena_Alloc(&globals.assetArena, globals.uiElementsCapacity * sizeof(UIComponent));
         
     //obj_runTests();
+
+    // --profile-trace <file> writes a profiler trace on exit
+    // --pack <file> reads assets from another asset pack than PACK_DEFAULT_PATH, see pack.h
+    // --headless renders without a window, see headless.h. --frames <n>, --camera-path <file>, --output-dir <dir> & --stats <file> go with it.
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--profile-trace") == 0 && i + 1 < argc){
+            profileTracePath = argv[++i];
+        }else if(strcmp(argv[i], "--headless") == 0){
+            headlessOptions.enabled = true;
+        }else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc){
+            headlessOptions.frames = atoi(argv[++i]);
+        }else if(strcmp(argv[i], "--camera-path") == 0 && i + 1 < argc){
+            headlessOptions.cameraPathFile = argv[++i];
+        }else if(strcmp(argv[i], "--output-dir") == 0 && i + 1 < argc){
+            headlessOptions.outputDir = argv[++i];
+        }else if(strcmp(argv[i], "--stats") == 0 && i + 1 < argc){
+            headlessOptions.statsPath = argv[++i];
+        }else if(strcmp(argv[i], "--pack") == 0 && i + 1 < argc){
+            packPath = argv[++i];
+        }
+    }
+    // Before anything reads an asset, loose files are used for whatever the pack doesn't hold.
+    if(!pack_open(packPath) && packPath != defaultPackPath){
+        printf(TEXT_COLOR_WARNING "Could not open asset pack %s\n" TEXT_COLOR_RESET, packPath);
+    }
+    globals.headless = headlessOptions.enabled;
+    profiler_init();
     
     // Initialize the random number generator
     srand((unsigned int)time(NULL));
     
     initProgram();
    
-    initOpenGLWindow();
+    if(globals.headless){
+        if(!headless_init(&headlessOptions, width, height)){
+            exit(1);
+        }
+    }else {
+        initOpenGLWindow();
+    }
+    gputimer_init();
+    capture_init();
+    // Read by the loader's jobs, textures are decoded & uploaded uncompressed without it.
+    globals.compressedTextures = compressedTexturesSupported();
+    if(TEXCOMPRESS_ENABLED && !globals.compressedTextures){
+        printf(TEXT_COLOR_WARNING "No ETC2 texture support on this context, textures upload uncompressed\n" TEXT_COLOR_RESET);
+    }
     
     // Camera setup
     Camera* uiCamera = initCamera();
@@ -1232,12 +1408,28 @@ int main(int argc, char **argv) {
     #ifdef __EMSCRIPTEN__
     emscripten_set_main_loop(emscriptenLoop, 0, 1);
     #else
+    if(globals.headless){
+        headlessLoop();
+        quit();
+        printf("Headless run complete!\n");
+        return 0;
+    }
+
     // native code
     while(globals.running) {
+        PROFILE_BEGIN("frame");
+        PROFILE_BEGIN("input");
         input();
+        PROFILE_END();
+        PROFILE_BEGIN("update");
         update();
+        PROFILE_END();
+        PROFILE_BEGIN("render");
         render();
+        PROFILE_END();
         debugSystem();
+        PROFILE_END();
+        profiler_frameEnd();
     }
 
     // -----------------------------------------------------
@@ -1269,10 +1461,8 @@ void createPoints(GLfloat* positions,int numPoints, Entity* entity){
     entity->transformComponent->scale[0] = 1.0f;
     entity->transformComponent->scale[1] = 1.0f;
     entity->transformComponent->scale[2] = 1.0f;
-    entity->transformComponent->rotation[0] = 0.0f;
-    entity->transformComponent->rotation[1] = 0.0f;
-    entity->transformComponent->rotation[2] = 0.0f;
-    entity->transformComponent->modelNeedsUpdate = 1;
+    quat_identity(entity->transformComponent->rotation);
+    transform_markDirty(entity->transformComponent);
     setupPoints(positions,numPoints,entity->pointComponent->gpuData);
     setupMaterial(entity->pointComponent->gpuData,"shaders/point_vertex.glsl", "shaders/point_fragment.glsl");
 }
@@ -1288,8 +1478,8 @@ void onButtonClick() {
 
     for(int i = 0; i < MAX_ENTITIES; i++){
        if(globals.entities[i].alive == 1 && globals.entities[i].uiComponent->active != 1 && globals.entities[i].transformComponent->active == 1){
-            globals.entities[i].transformComponent->rotation[1] += 0.01f;
-            globals.entities[i].transformComponent->modelNeedsUpdate = 1;
+            transform_rotateLocal(globals.entities[i].transformComponent, 0.01f, (vec3){0.0f, 1.0f, 0.0f});
+            transform_markDirty(globals.entities[i].transformComponent);
        }
     }
     printf("Button pressed!\n");
@@ -1337,7 +1527,7 @@ void togglePanel(void *params){
              if(globals.entities[i].transformComponent->scale[1] > 0.0f){
                 globals.entities[i].transformComponent->scale[1] -= 0.61f;
             }
-            globals.entities[i].transformComponent->modelNeedsUpdate = 1;
+            transform_markDirty(globals.entities[i].transformComponent);
         }
 
         
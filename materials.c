@@ -0,0 +1,166 @@
+#include "materials.h"
+#include "globals.h"
+#include "utils.h"
+#include <stdint.h>
+
+typedef struct MaterialSlot {
+    int index;      // in globals.materials, -1 marks an empty slot
+    uint32_t hash;
+} MaterialSlot;
+
+// Name -> first material with that name. Linear probing, capacity is a power of 2.
+static MaterialSlot* slots = NULL;
+static int slotCapacity = 0;
+static int slotCount = 0;
+static Arena names; // interned names, growable
+
+static uint32_t materials_hashName(const char* name){
+    return (uint32_t)hashBytes(HASH_SEED, name, strlen(name)); // low bits pick the slot
+}
+
+static void materials_allocSlots(int capacity){
+    slots = (MaterialSlot*)malloc(capacity * sizeof(MaterialSlot));
+    if(slots == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate material name table\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    for(int i = 0; i < capacity; i++){
+        slots[i].index = -1;
+    }
+    slotCapacity = capacity;
+}
+
+static void materials_growSlots(){
+    MaterialSlot* oldSlots = slots;
+    int oldCapacity = slotCapacity;
+    materials_allocSlots(slotCapacity * 2);
+    for(int i = 0; i < oldCapacity; i++){
+        if(oldSlots[i].index == -1){
+            continue;
+        }
+        int slot = (int)(oldSlots[i].hash & (uint32_t)(slotCapacity - 1));
+        while(slots[slot].index != -1){
+            slot = (slot + 1) & (slotCapacity - 1);
+        }
+        slots[slot] = oldSlots[i];
+    }
+    free(oldSlots);
+}
+
+/**
+ * @brief Slot holding name, or the empty slot it would go in.
+ */
+static int materials_findSlot(const char* name, uint32_t hash){
+    int slot = (int)(hash & (uint32_t)(slotCapacity - 1));
+    while(slots[slot].index != -1){
+        if(slots[slot].hash == hash && strcmp(globals.materials[slots[slot].index].name, name) == 0){
+            return slot;
+        }
+        slot = (slot + 1) & (slotCapacity - 1);
+    }
+    return slot;
+}
+
+/**
+ * @brief Set up globals.materials with room for capacity materials, it grows past that.
+ */
+void materials_init(int capacity){
+    if(capacity < 1){
+        capacity = MATERIALS_INITIAL_CAPACITY;
+    }
+    globals.materials = (Material*)malloc(capacity * sizeof(Material));
+    if(globals.materials == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate materials\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    globals.materialsCapacity = capacity;
+    globals.materialsCount = 0;
+    int tableCapacity = 1;
+    while(tableCapacity < capacity * 2){
+        tableCapacity *= 2;
+    }
+    materials_allocSlots(tableCapacity);
+    slotCount = 0;
+    arena_initScratch(&names, MATERIALS_NAMES_BLOCK_SIZE);
+}
+
+/**
+ * @brief Register a material, its name is copied (interned).
+ * @return handle of the material, index in globals.materials.
+ */
+int addMaterial(Material material){
+    if(globals.materialsCount == globals.materialsCapacity){
+        int capacity = globals.materialsCapacity * 2;
+        Material* materials = (Material*)realloc(globals.materials, capacity * sizeof(Material));
+        if(materials == NULL){
+            printf(TEXT_COLOR_ERROR "Failed to grow materials to %d\n" TEXT_COLOR_RESET, capacity);
+            exit(1);
+        }
+        globals.materials = materials;
+        globals.materialsCapacity = capacity;
+    }
+    int index = globals.materialsCount;
+
+    if(material.name != NULL){
+        uint32_t hash = materials_hashName(material.name);
+        int slot = materials_findSlot(material.name, hash);
+        if(slots[slot].index != -1){
+            // Same name as an earlier material, share its copy. Lookups keep finding the earlier one.
+            material.name = globals.materials[slots[slot].index].name;
+        }else {
+            size_t length = strlen(material.name) + 1;
+            char* name = (char*)arena_Alloc(&names, length);
+            memcpy(name, material.name, length);
+            material.name = name;
+            slots[slot].index = index;
+            slots[slot].hash = hash;
+            slotCount++;
+            if(slotCount * 10 > slotCapacity * 7){
+                materials_growSlots();
+            }
+        }
+    }
+
+    globals.materials[index] = material;
+    globals.materialsCount++;
+    return index;
+}
+
+Material* getMaterial(int index){
+    ASSERT(index < globals.materialsCount && index >= 0, "Material index out of bounds or not assigned");
+    return &globals.materials[index];
+}
+
+/**
+ * @brief Material an entity renders with, NULL if its material component is off.
+ */
+Material* getEntityMaterial(Entity* entity){
+    if(!entity->materialComponent->active || entity->materialComponent->materialIndex < 0){
+        return NULL;
+    }
+    return getMaterial(entity->materialComponent->materialIndex);
+}
+
+/**
+ * Hash lookup in globals.materials on provided name.
+ * @param name of the material
+ * @returns materialIndex in globals.materials or -1 if no hits
+ */
+int getMaterialByName(const char* name){
+    if(name == NULL || slotCapacity == 0){
+        return -1;
+    }
+    return slots[materials_findSlot(name, materials_hashName(name))].index;
+}
+
+void materials_shutdown(){
+    free(slots);
+    slots = NULL;
+    slotCapacity = 0;
+    slotCount = 0;
+    arena_free(&names);
+    free(globals.materials);
+    globals.materials = NULL;
+    globals.materialsCount = 0;
+    globals.materialsCapacity = 0;
+}
@@ -0,0 +1,26 @@
+#ifndef MATERIALS_H
+#define MATERIALS_H
+
+#include "types.h"
+
+/**
+ * Material registry
+ * Materials live in globals.materials, a growable array. The index returned by addMaterial is the handle,
+ * it stays valid for the whole run (materials are never removed), pointers from getMaterial only until the
+ * next addMaterial. Entities share materials by handle, MaterialComponent only keeps the per entity tint.
+ * Names are interned, one copy per distinct name, and indexed by an open addressing hash table so
+ * getMaterialByName (every usemtl) is O(1). Materials with the same name resolve to the first one added.
+ * Main thread only.
+ */
+
+#define MATERIALS_INITIAL_CAPACITY 128 // the name table starts at the next power of 2 of twice this
+#define MATERIALS_NAMES_BLOCK_SIZE (64 * 1024)
+
+void materials_init(int capacity);
+int addMaterial(Material material);
+Material* getMaterial(int index);
+int getMaterialByName(const char* name);
+Material* getEntityMaterial(Entity* entity);
+void materials_shutdown();
+
+#endif
@@ -0,0 +1,334 @@
+#include "meshcache.h"
+#include "utils.h"
+#include "globals.h"
+#include "opengl.h"
+#include "profiler.h"
+#include "jobs.h"
+#include <stddef.h>
+
+// Loaded objects point into these, kept until meshcache_unload. Loads run on job threads too.
+static MappedFile* mappings = NULL;
+static int mappingCount = 0;
+static SDL_SpinLock mappingsLock = 0;
+
+static uint64_t meshcache_align(uint64_t offset){
+    return (offset + MESHCACHE_BLOB_ALIGNMENT - 1) & ~(uint64_t)(MESHCACHE_BLOB_ALIGNMENT - 1);
+}
+
+static void meshcache_writePadding(FILE* fp, uint64_t from, uint64_t to){
+    static const char zeros[MESHCACHE_BLOB_ALIGNMENT] = {0};
+    if(to > from){
+        fwrite(zeros, 1, (size_t)(to - from), fp);
+    }
+}
+
+static uint64_t meshcache_addString(char* strings, uint64_t* stringsSize, const char* string){
+    if(string == NULL){
+        return MESHCACHE_NO_STRING;
+    }
+    uint64_t offset = *stringsSize;
+    size_t length = strlen(string) + 1;
+    if(strings != NULL){
+        memcpy(strings + offset, string, length);
+    }
+    *stringsSize += length;
+    return offset;
+}
+
+static void meshcache_path(const char* sourcePath, char* out, size_t outSize){
+    snprintf(out, outSize, "%s%s", sourcePath, MESHCACHE_EXTENSION);
+}
+
+typedef struct MeshCachePackJob {
+    ObjGroup* group;
+    PackedMesh* packed;
+} MeshCachePackJob;
+
+static void meshcache_packObjects(void* data, int start, int end){
+    MeshCachePackJob* job = (MeshCachePackJob*)data;
+    for(int i = start; i < end; i++){
+        ObjData* obj = &job->group->objData[i];
+        // Same layout createObject uploads obj meshes in
+        job->packed[i] = packMesh(obj->vertexData, obj->num_of_vertices, obj->indices, obj->num_of_indices, VERTEX_LAYOUT_COMPACT);
+    }
+}
+
+bool meshcache_save(const char* sourcePath, ObjGroup* group){
+    #if !MESHCACHE_ENABLED
+    (void)sourcePath;
+    (void)group;
+    return false;
+    #else
+    PROFILE_BEGIN("meshcache_save");
+    char path[512];
+    meshcache_path(sourcePath, path, sizeof(path));
+
+    SourceStamp source;
+    if(!getSourceStamp(sourcePath, &source)){
+        printf(TEXT_COLOR_WARNING "Could not read %s for its mesh cache\n" TEXT_COLOR_RESET, sourcePath);
+        PROFILE_END();
+        return false;
+    }
+
+    int objectCount = group->objectCount;
+    PackedMesh* packed = (PackedMesh*)malloc((objectCount + 1) * sizeof(PackedMesh));
+    MeshCacheObject* objects = (MeshCacheObject*)calloc(objectCount + 1, sizeof(MeshCacheObject));
+    if(packed == NULL || objects == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate memory for mesh cache\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    MeshCachePackJob packJob = {group, packed};
+    jobs_parallelFor(objectCount, 1, meshcache_packObjects, &packJob);
+
+    // Size the string table, then fill it.
+    uint64_t stringsSize = 0;
+    meshcache_addString(NULL, &stringsSize, sourcePath);
+    for(int i = 0; i < objectCount; i++){
+        meshcache_addString(NULL, &stringsSize, group->objData[i].name);
+        meshcache_addString(NULL, &stringsSize, group->objData[i].materialName);
+    }
+    char* strings = (char*)malloc(stringsSize + 1);
+    if(strings == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate memory for mesh cache\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    stringsSize = 0;
+
+    MeshCacheHeader header = {0};
+    memcpy(header.magic, MESHCACHE_MAGIC, 4);
+    header.version = MESHCACHE_VERSION;
+    header.headerSize = sizeof(MeshCacheHeader);
+    header.objectSize = sizeof(MeshCacheObject);
+    header.objectCount = objectCount;
+    header.flags = group->hasMtllib ? MESHCACHE_HAS_MTLLIB : 0;
+    header.source = source;
+    header.sourcePathOffset = meshcache_addString(strings, &stringsSize, sourcePath);
+    header.objectsOffset = sizeof(MeshCacheHeader);
+
+    for(int i = 0; i < objectCount; i++){
+        ObjData* obj = &group->objData[i];
+        MeshCacheObject* out = &objects[i];
+        out->nameOffset = meshcache_addString(strings, &stringsSize, obj->name);
+        out->materialNameOffset = meshcache_addString(strings, &stringsSize, obj->materialName);
+        memcpy(out->boundsMin, obj->bounds.min, sizeof(out->boundsMin));
+        memcpy(out->boundsMax, obj->bounds.max, sizeof(out->boundsMax));
+        memcpy(out->positionScale, packed[i].positionScale, sizeof(out->positionScale));
+        memcpy(out->positionOffset, packed[i].positionOffset, sizeof(out->positionOffset));
+        out->positionFormat = (uint8_t)packed[i].layout.position;
+        out->uvFormat = (uint8_t)packed[i].layout.uv;
+        out->normalFormat = (uint8_t)packed[i].layout.normal;
+        out->dropColor = packed[i].layout.dropColor;
+        out->stride = (uint32_t)packed[i].stride;
+        out->vertexCount = (uint32_t)packed[i].vertexCount;
+        out->indexCount = (uint32_t)packed[i].indexCount;
+        out->indexType = packed[i].indexType;
+    }
+    header.stringsOffset = header.objectsOffset + objectCount * sizeof(MeshCacheObject);
+    header.stringsSize = stringsSize;
+    header.blobsOffset = meshcache_align(header.stringsOffset + stringsSize);
+
+    uint64_t blobCursor = header.blobsOffset;
+    for(int i = 0; i < objectCount; i++){
+        MeshCacheObject* out = &objects[i];
+        out->verticesOffset = meshcache_align(blobCursor);
+        blobCursor = out->verticesOffset + (uint64_t)out->vertexCount * out->stride;
+        out->indicesOffset = meshcache_align(blobCursor);
+        blobCursor = out->indicesOffset + (uint64_t)out->indexCount * (out->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int));
+    }
+    header.blobsSize = blobCursor - header.blobsOffset;
+    header.fileSize = blobCursor;
+
+    bool success = false;
+    // Written next to the cache & renamed over it, earlier loads keep the old file mapped until meshcache_unload.
+    char tempPath[sizeof(path) + 16];
+    FILE* fp = openReplacingFile(path, tempPath, sizeof(tempPath));
+    if(fp == NULL){
+        printf(TEXT_COLOR_WARNING "Could not write mesh cache %s\n" TEXT_COLOR_RESET, path);
+    }else {
+        fwrite(&header, sizeof(MeshCacheHeader), 1, fp);
+        fwrite(objects, sizeof(MeshCacheObject), objectCount, fp);
+        fwrite(strings, 1, stringsSize, fp);
+        uint64_t cursor = header.stringsOffset + stringsSize;
+        for(int i = 0; i < objectCount; i++){
+            MeshCacheObject* out = &objects[i];
+            size_t indexSize = out->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+            meshcache_writePadding(fp, cursor, out->verticesOffset);
+            fwrite(packed[i].vertices, out->stride, out->vertexCount, fp);
+            cursor = out->verticesOffset + (uint64_t)out->vertexCount * out->stride;
+            meshcache_writePadding(fp, cursor, out->indicesOffset);
+            fwrite(packed[i].indices, indexSize, out->indexCount, fp);
+            cursor = out->indicesOffset + (uint64_t)out->indexCount * indexSize;
+        }
+        success = closeReplacingFile(fp, tempPath, path, true);
+        if(success){
+            printf("Mesh cache saved: %s, %d objects, %.2f MB\n", path, objectCount, header.fileSize / (1024.0 * 1024.0));
+        }else {
+            printf(TEXT_COLOR_WARNING "Failed writing mesh cache %s\n" TEXT_COLOR_RESET, path);
+        }
+    }
+
+    for(int i = 0; i < objectCount; i++){
+        freePackedMesh(&packed[i]);
+    }
+    free(packed);
+    free(objects);
+    free(strings);
+    PROFILE_END();
+    return success;
+    #endif
+}
+
+void meshcache_unload(){
+    SDL_AtomicLock(&mappingsLock);
+    for(int i = 0; i < mappingCount; i++){
+        unmapFile(&mappings[i]);
+    }
+    free(mappings);
+    mappings = NULL;
+    mappingCount = 0;
+    SDL_AtomicUnlock(&mappingsLock);
+}
+
+static bool meshcache_rangeValid(uint64_t offset, uint64_t size, uint64_t fileSize){
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+static bool meshcache_stringValid(const MeshCacheHeader* header, uint64_t offset){
+    return offset == MESHCACHE_NO_STRING || offset < header->stringsSize;
+}
+
+/**
+ * @brief Check everything the loader is about to dereference, a bad file is rebuilt from the source.
+ */
+static bool meshcache_validate(const char* data, size_t size){
+    if(size < sizeof(MeshCacheHeader)){
+        return false;
+    }
+    const MeshCacheHeader* header = (const MeshCacheHeader*)data;
+    if(memcmp(header->magic, MESHCACHE_MAGIC, 4) != 0 || header->version != MESHCACHE_VERSION){
+        return false;
+    }
+    if(header->headerSize != sizeof(MeshCacheHeader) || header->objectSize != sizeof(MeshCacheObject)){
+        return false;
+    }
+    if(header->fileSize != size
+        || !meshcache_rangeValid(header->objectsOffset, (uint64_t)header->objectCount * sizeof(MeshCacheObject), size)
+        || !meshcache_rangeValid(header->stringsOffset, header->stringsSize, size)
+        || !meshcache_rangeValid(header->blobsOffset, header->blobsSize, size)){
+        return false;
+    }
+    if(header->stringsSize == 0 || data[header->stringsOffset + header->stringsSize - 1] != '\0'){
+        return false;
+    }
+    if(header->sourcePathOffset == MESHCACHE_NO_STRING || !meshcache_stringValid(header, header->sourcePathOffset)){
+        return false;
+    }
+
+    const MeshCacheObject* objects = (const MeshCacheObject*)(data + header->objectsOffset);
+    for(uint32_t i = 0; i < header->objectCount; i++){
+        const MeshCacheObject* object = &objects[i];
+        if(object->nameOffset == MESHCACHE_NO_STRING || !meshcache_stringValid(header, object->nameOffset) || !meshcache_stringValid(header, object->materialNameOffset)){
+            return false;
+        }
+        if(object->positionFormat > VERTEX_POSITION_UNORM16 || object->uvFormat > VERTEX_UV_UNORM16 || object->normalFormat > VERTEX_NORMAL_INT_2_10_10_10){
+            return false;
+        }
+        VertexLayout layout = {(VertexPositionFormat)object->positionFormat, object->dropColor != 0, (VertexUvFormat)object->uvFormat, (VertexNormalFormat)object->normalFormat};
+        if(object->stride != (uint32_t)vertexLayoutStride(&layout)){
+            return false;
+        }
+        if(object->indexType != GL_UNSIGNED_SHORT && object->indexType != GL_UNSIGNED_INT){
+            return false;
+        }
+        size_t indexSize = object->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+        if(!meshcache_rangeValid(object->verticesOffset, (uint64_t)object->vertexCount * object->stride, size)
+            || !meshcache_rangeValid(object->indicesOffset, (uint64_t)object->indexCount * indexSize, size)
+            || object->indicesOffset % indexSize != 0
+            || !indicesInRange(data + object->indicesOffset, object->indexType, object->indexCount, object->vertexCount)){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Is the cache from this source file, same path & source stamp.
+ */
+static bool meshcache_matchesSource(const char* path, const MeshCacheHeader* header, const char* strings, const char* sourcePath){
+    return strcmp(strings + header->sourcePathOffset, sourcePath) == 0 && sourceStampMatches(sourcePath, &header->source, path, (long)offsetof(MeshCacheHeader, source));
+}
+
+ObjGroup* meshcache_load(const char* sourcePath, Arena* arena){
+    #if !MESHCACHE_ENABLED
+    (void)sourcePath;
+    (void)arena;
+    return NULL;
+    #else
+    PROFILE_BEGIN("meshcache_load");
+    Uint32 startTime = SDL_GetTicks();
+    char path[512];
+    meshcache_path(sourcePath, path, sizeof(path));
+
+    MappedFile mapping;
+    if(!mapFile(path, &mapping)){
+        PROFILE_END();
+        return NULL;
+    }
+    char* base = (char*)mapping.data;
+    MeshCacheHeader* header = (MeshCacheHeader*)base;
+    if(!meshcache_validate(base, mapping.size) || !meshcache_matchesSource(path, header, base + header->stringsOffset, sourcePath)){
+        printf(TEXT_COLOR_WARNING "Mesh cache %s is outdated or broken, parsing %s\n" TEXT_COLOR_RESET, path, sourcePath);
+        unmapFile(&mapping);
+        PROFILE_END();
+        return NULL;
+    }
+    MeshCacheObject* objects = (MeshCacheObject*)(base + header->objectsOffset);
+    char* strings = base + header->stringsOffset;
+
+    ObjGroup* group = (ObjGroup*)arena_Alloc(arena, sizeof(ObjGroup));
+    group->name = sourcePath;
+    group->objectCount = (int)header->objectCount;
+    group->hasMtllib = (header->flags & MESHCACHE_HAS_MTLLIB) != 0;
+    group->objData = (ObjData*)arena_Alloc(arena, (header->objectCount + 1) * sizeof(ObjData));
+    memset(group->objData, 0, (header->objectCount + 1) * sizeof(ObjData));
+    for(uint32_t i = 0; i < header->objectCount; i++){
+        MeshCacheObject* in = &objects[i];
+        ObjData* obj = &group->objData[i];
+        obj->name = strings + in->nameOffset;
+        if(in->materialNameOffset != MESHCACHE_NO_STRING){
+            obj->materialName = strings + in->materialNameOffset;
+        }
+        obj->num_of_vertices = (int)in->vertexCount;
+        obj->num_of_indices = (int)in->indexCount;
+        memcpy(obj->bounds.min, in->boundsMin, sizeof(in->boundsMin));
+        memcpy(obj->bounds.max, in->boundsMax, sizeof(in->boundsMax));
+
+        PackedMesh* packed = &obj->packed;
+        packed->layout = (VertexLayout){
+            (VertexPositionFormat)in->positionFormat, in->dropColor != 0, (VertexUvFormat)in->uvFormat, (VertexNormalFormat)in->normalFormat
+        };
+        memcpy(packed->positionScale, in->positionScale, sizeof(in->positionScale));
+        memcpy(packed->positionOffset, in->positionOffset, sizeof(in->positionOffset));
+        packed->stride = (GLsizei)in->stride;
+        packed->vertexCount = (int)in->vertexCount;
+        packed->vertices = base + in->verticesOffset;
+        packed->indexCount = (int)in->indexCount;
+        packed->indexType = in->indexType;
+        packed->indices = base + in->indicesOffset;
+    }
+
+    SDL_AtomicLock(&mappingsLock);
+    MappedFile* grown = (MappedFile*)realloc(mappings, (mappingCount + 1) * sizeof(MappedFile));
+    if(grown == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate memory for mesh cache\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    mappings = grown;
+    mappings[mappingCount++] = mapping;
+    SDL_AtomicUnlock(&mappingsLock);
+
+    printf("Mesh cache loaded: %s, %d objects in %u ms\n", path, group->objectCount, SDL_GetTicks() - startTime);
+    PROFILE_END();
+    return group;
+    #endif
+}
@@ -0,0 +1,90 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+ * Binary cache of imported obj files, written next to the source as <file>.meshcache after a parse.
+ * Holds what the importer produced: per object the deduplicated, vertex cache optimized mesh already packed
+ * into VERTEX_LAYOUT_COMPACT (16 bit indices when they fit), its material binding by name and its AABB.
+ * A load maps the file and ObjData.packed points into the mapping, createObject uploads it with glBufferData
+ * from there. The .mtl is still parsed by obj_bindMaterials (it's small & loads the textures).
+ * Neither load nor save touch GL or globals, both run on job threads for async loads.
+ *
+ * Valid when the format version & struct sizes match and the source path & size are the same, then either
+ * the modification time matches or the source content hashes to the same value (touched but unchanged files).
+ *
+ * Layout: header | objects | strings | blobs (16 byte aligned vertex & index data)
+ * All offsets are bytes from the start of the file. Written & read on the same platform, no endian swapping.
+ * Wasm has no persistent files & takes full float vertices, the cache is off there.
+ */
+
+#define MESHCACHE_MAGIC "MSHC"
+#define MESHCACHE_VERSION 1
+#define MESHCACHE_EXTENSION ".meshcache"
+#define MESHCACHE_NO_STRING UINT64_MAX
+#define MESHCACHE_BLOB_ALIGNMENT 16
+
+#define MESHCACHE_HAS_MTLLIB (1 << 0)
+
+#ifdef __EMSCRIPTEN__
+    #define MESHCACHE_ENABLED 0
+#else
+    #define MESHCACHE_ENABLED 1
+#endif
+
+typedef struct MeshCacheHeader {
+    char magic[4];
+    uint32_t version;
+    // Struct sizes at write time, a mismatch means the file came from another build.
+    uint32_t headerSize;
+    uint32_t objectSize;
+    uint32_t objectCount;
+    uint32_t flags;         // MESHCACHE_*
+    SourceStamp source;     // source file the cache was built from
+    uint64_t sourcePathOffset;
+    uint64_t objectsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    uint64_t blobsOffset;
+    uint64_t blobsSize;
+    uint64_t fileSize;
+} MeshCacheHeader;
+
+typedef struct MeshCacheObject {
+    uint64_t nameOffset;
+    uint64_t materialNameOffset; // MESHCACHE_NO_STRING if the object has no material
+    float boundsMin[3];
+    float boundsMax[3];
+    float positionScale[3];
+    float positionOffset[3];
+    uint8_t positionFormat;
+    uint8_t uvFormat;
+    uint8_t normalFormat;
+    uint8_t dropColor;
+    uint32_t stride;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexType;     // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t padding;
+    uint64_t verticesOffset;
+    uint64_t indicesOffset;
+} MeshCacheObject;
+
+/**
+ * @brief Load the cache of an obj file if it is up to date. Objects get material names, obj_bindMaterials resolves them.
+ * @param arena the objGroup & objData go here, names & meshes point into the mapping.
+ * @return NULL if there is no valid cache, caller parses the obj then.
+ */
+ObjGroup* meshcache_load(const char* sourcePath, Arena* arena);
+/**
+ * @brief Write the cache of a parsed obj file, failures only print a warning.
+ */
+bool meshcache_save(const char* sourcePath, ObjGroup* group);
+/**
+ * @brief Release all cache mappings. Meshes & object names point into them, only call when they are gone (quit).
+ */
+void meshcache_unload();
+
+#endif
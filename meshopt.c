@@ -0,0 +1,402 @@
+#include <stdint.h>
+#include "meshopt.h"
+#include "utils.h"
+#include "profiler.h"
+
+#define MESHOPT_MAX_VALENCE_SCORE 32 // valence scores above this are computed, not looked up
+
+static void* meshopt_alloc(size_t size){
+    void* memory = malloc(size > 0 ? size : 1);
+    if(memory == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate mesh optimizer memory" TEXT_COLOR_RESET "\n");
+        exit(1);
+    }
+    return memory;
+}
+
+/**
+ * @brief Simulate a FIFO post-transform cache over the index buffer.
+ */
+MeshCacheStats meshopt_analyzeVertexCache(const GLuint* indices, int indexCount, int vertexCount){
+    MeshCacheStats stats = {0.0f, 0.0f};
+    if(indexCount < 3 || vertexCount == 0){
+        return stats;
+    }
+    // Vertex is in the cache while fewer than MESHOPT_FIFO_SIZE misses happened since it was loaded.
+    unsigned int* loadedAt = (unsigned int*)meshopt_alloc(vertexCount * sizeof(unsigned int));
+    bool* used = (bool*)meshopt_alloc(vertexCount * sizeof(bool));
+    for(int i = 0; i < vertexCount; i++){
+        loadedAt[i] = 0;
+        used[i] = false;
+    }
+    unsigned int misses = MESHOPT_FIFO_SIZE + 1; // never used vertices look evicted
+    unsigned int transformed = 0;
+    int usedCount = 0;
+    for(int i = 0; i < indexCount; i++){
+        GLuint v = indices[i];
+        if(misses - loadedAt[v] > MESHOPT_FIFO_SIZE){
+            loadedAt[v] = misses++;
+            transformed++;
+        }
+        if(!used[v]){
+            used[v] = true;
+            usedCount++;
+        }
+    }
+    stats.acmr = (float)transformed / (float)(indexCount / 3);
+    stats.atvr = (float)transformed / (float)usedCount;
+    free(loadedAt);
+    free(used);
+    return stats;
+}
+
+// Forsyth's vertex score, see "Linear-Speed Vertex Cache Optimisation" (2006).
+static float cachePositionScores[MESHOPT_CACHE_SIZE];
+static float valenceScores[MESHOPT_MAX_VALENCE_SCORE];
+static bool scoresReady = false;
+static SDL_SpinLock scoresLock = 0; // obj imports optimize their objects on job threads
+
+static void meshopt_initScores(){
+    for(int i = 0; i < MESHOPT_CACHE_SIZE; i++){
+        // Last triangle's vertices get a fixed score so the next triangle doesn't just reuse its edge.
+        cachePositionScores[i] = i < 3 ? 0.75f : powf(1.0f - (float)(i - 3) / (MESHOPT_CACHE_SIZE - 3), 1.5f);
+    }
+    for(int i = 0; i < MESHOPT_MAX_VALENCE_SCORE; i++){
+        valenceScores[i] = i == 0 ? 0.0f : 2.0f * powf((float)i, -0.5f);
+    }
+    scoresReady = true;
+}
+
+static float meshopt_vertexScore(int cachePosition, int liveTriangles){
+    if(liveTriangles == 0){
+        return -1.0f; // nothing left to draw with it
+    }
+    float score = cachePosition >= 0 ? cachePositionScores[cachePosition] : 0.0f;
+    score += liveTriangles < MESHOPT_MAX_VALENCE_SCORE ? valenceScores[liveTriangles] : 2.0f * powf((float)liveTriangles, -0.5f);
+    return score;
+}
+
+/**
+ * @brief Reorder triangles in place for the post-transform vertex cache.
+ */
+void meshopt_optimizeVertexCache(GLuint* indices, int indexCount, int vertexCount){
+    int triangleCount = indexCount / 3;
+    if(triangleCount == 0){
+        return;
+    }
+    PROFILE_BEGIN("meshopt_optimizeVertexCache");
+    SDL_AtomicLock(&scoresLock);
+    if(!scoresReady){
+        meshopt_initScores();
+    }
+    SDL_AtomicUnlock(&scoresLock);
+
+    // Triangles using each vertex, the live ones first in each vertex's range.
+    int* liveTriangles = (int*)meshopt_alloc(vertexCount * sizeof(int));
+    int* adjacencyOffsets = (int*)meshopt_alloc((vertexCount + 1) * sizeof(int));
+    int* adjacency = (int*)meshopt_alloc(triangleCount * 3 * sizeof(int));
+    for(int i = 0; i < vertexCount; i++){
+        liveTriangles[i] = 0;
+    }
+    for(int i = 0; i < triangleCount * 3; i++){
+        liveTriangles[indices[i]]++;
+    }
+    adjacencyOffsets[0] = 0;
+    for(int i = 0; i < vertexCount; i++){
+        adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangles[i];
+        liveTriangles[i] = 0;
+    }
+    for(int t = 0; t < triangleCount; t++){
+        for(int k = 0; k < 3; k++){
+            GLuint v = indices[t * 3 + k];
+            adjacency[adjacencyOffsets[v] + liveTriangles[v]++] = t;
+        }
+    }
+
+    int* cachePositions = (int*)meshopt_alloc(vertexCount * sizeof(int));
+    float* vertexScores = (float*)meshopt_alloc(vertexCount * sizeof(float));
+    float* triangleScores = (float*)meshopt_alloc(triangleCount * sizeof(float));
+    bool* emitted = (bool*)meshopt_alloc(triangleCount * sizeof(bool));
+    GLuint* output = (GLuint*)meshopt_alloc(triangleCount * 3 * sizeof(GLuint));
+    for(int i = 0; i < vertexCount; i++){
+        cachePositions[i] = -1;
+        vertexScores[i] = meshopt_vertexScore(-1, liveTriangles[i]);
+    }
+    int bestTriangle = 0;
+    for(int t = 0; t < triangleCount; t++){
+        emitted[t] = false;
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        if(triangleScores[t] > triangleScores[bestTriangle]){
+            bestTriangle = t;
+        }
+    }
+
+    int cache[MESHOPT_CACHE_SIZE + 3];
+    int cacheCount = 0;
+    int scanCursor = 0; // fallback when nothing in the cache has triangles left, input order is as good as any
+    for(int outputTriangle = 0; outputTriangle < triangleCount; outputTriangle++){
+        if(bestTriangle < 0){
+            while(emitted[scanCursor]){
+                scanCursor++;
+            }
+            bestTriangle = scanCursor;
+        }
+        const GLuint* triangle = &indices[bestTriangle * 3];
+        output[outputTriangle * 3] = triangle[0];
+        output[outputTriangle * 3 + 1] = triangle[1];
+        output[outputTriangle * 3 + 2] = triangle[2];
+        emitted[bestTriangle] = true;
+
+        // Drop the triangle from its vertices' live lists.
+        for(int k = 0; k < 3; k++){
+            GLuint v = triangle[k];
+            int* live = &adjacency[adjacencyOffsets[v]];
+            for(int j = 0; j < liveTriangles[v]; j++){
+                if(live[j] == bestTriangle){
+                    live[j] = live[liveTriangles[v] - 1];
+                    live[liveTriangles[v] - 1] = bestTriangle;
+                    break;
+                }
+            }
+            liveTriangles[v]--;
+        }
+
+        // Triangle's vertices move to the front of the LRU, the rest shift back, the last 3 may fall out.
+        int newCache[MESHOPT_CACHE_SIZE + 3];
+        int newCount = 0;
+        for(int k = 0; k < 3; k++){
+            bool duplicate = false; // degenerate triangle
+            for(int j = 0; j < k; j++){
+                duplicate = duplicate || triangle[j] == triangle[k];
+            }
+            if(!duplicate){
+                newCache[newCount++] = triangle[k];
+            }
+        }
+        for(int i = 0; i < cacheCount; i++){
+            int v = cache[i];
+            if(v != (int)triangle[0] && v != (int)triangle[1] && v != (int)triangle[2]){
+                newCache[newCount++] = v;
+            }
+        }
+
+        // Rescore everything whose cache position changed.
+        for(int i = 0; i < newCount; i++){
+            int v = newCache[i];
+            cachePositions[v] = i < MESHOPT_CACHE_SIZE ? i : -1;
+            float score = meshopt_vertexScore(cachePositions[v], liveTriangles[v]);
+            float delta = score - vertexScores[v];
+            vertexScores[v] = score;
+            const int* live = &adjacency[adjacencyOffsets[v]];
+            for(int j = 0; j < liveTriangles[v]; j++){
+                triangleScores[live[j]] += delta;
+            }
+        }
+        // Best next triangle uses a cached vertex.
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for(int i = 0; i < newCount && i < MESHOPT_CACHE_SIZE; i++){
+            int v = newCache[i];
+            const int* live = &adjacency[adjacencyOffsets[v]];
+            for(int j = 0; j < liveTriangles[v]; j++){
+                if(triangleScores[live[j]] > bestScore){
+                    bestScore = triangleScores[live[j]];
+                    bestTriangle = live[j];
+                }
+            }
+        }
+        cacheCount = newCount < MESHOPT_CACHE_SIZE ? newCount : MESHOPT_CACHE_SIZE;
+        for(int i = 0; i < cacheCount; i++){
+            cache[i] = newCache[i];
+        }
+    }
+    memcpy(indices, output, triangleCount * 3 * sizeof(GLuint));
+
+    free(liveTriangles);
+    free(adjacencyOffsets);
+    free(adjacency);
+    free(cachePositions);
+    free(vertexScores);
+    free(triangleScores);
+    free(emitted);
+    free(output);
+    PROFILE_END();
+}
+
+typedef struct MeshCluster {
+    int start; // first triangle
+    int end;
+    float sortKey;
+} MeshCluster;
+
+static int meshopt_compareClusters(const void* a, const void* b){
+    float keyA = ((const MeshCluster*)a)->sortKey;
+    float keyB = ((const MeshCluster*)b)->sortKey;
+    return keyA < keyB ? 1 : (keyA > keyB ? -1 : 0); // descending
+}
+
+// FIFO miss count of one triangle, time advances per miss like in meshopt_analyzeVertexCache.
+static int meshopt_cacheTriangle(const GLuint* triangle, unsigned int* loadedAt, unsigned int* time){
+    int misses = 0;
+    for(int k = 0; k < 3; k++){
+        if(*time - loadedAt[triangle[k]] > MESHOPT_FIFO_SIZE){
+            loadedAt[triangle[k]] = (*time)++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+/**
+ * @brief Reorder clusters of an already cache optimized index buffer to draw outside, outward facing triangles first.
+ * Based on Sander, Nehab & Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (2007).
+ */
+void meshopt_optimizeOverdraw(GLuint* indices, int indexCount, const Vertex* vertices, int vertexCount, float threshold){
+    int triangleCount = indexCount / 3;
+    if(triangleCount < 2){
+        return;
+    }
+    PROFILE_BEGIN("meshopt_optimizeOverdraw");
+    unsigned int* loadedAt = (unsigned int*)meshopt_alloc(vertexCount * sizeof(unsigned int));
+    int* hardStarts = (int*)meshopt_alloc((triangleCount + 1) * sizeof(int));
+    MeshCluster* clusters = (MeshCluster*)meshopt_alloc(triangleCount * sizeof(MeshCluster));
+    int* triangleMisses = (int*)meshopt_alloc(triangleCount * sizeof(int));
+
+    // Hard boundaries: triangles where the cache optimizer had to start over (all 3 vertices missed).
+    unsigned int time = MESHOPT_FIFO_SIZE + 1;
+    for(int i = 0; i < vertexCount; i++){
+        loadedAt[i] = 0;
+    }
+    int hardCount = 0;
+    for(int t = 0; t < triangleCount; t++){
+        triangleMisses[t] = meshopt_cacheTriangle(&indices[t * 3], loadedAt, &time);
+        if(t == 0 || triangleMisses[t] == 3){
+            hardStarts[hardCount++] = t;
+        }
+    }
+    hardStarts[hardCount] = triangleCount;
+
+    // Soft boundaries: cut a hard cluster as soon as the part so far, drawn on its own, is within threshold of the cluster's ACMR.
+    int clusterCount = 0;
+    for(int h = 0; h < hardCount; h++){
+        int start = hardStarts[h];
+        int end = hardStarts[h + 1];
+        int clusterMisses = 0;
+        for(int t = start; t < end; t++){
+            clusterMisses += triangleMisses[t];
+        }
+        float target = threshold * (float)clusterMisses / (float)(end - start);
+
+        int firstCluster = clusterCount;
+        clusters[clusterCount++].start = start;
+        time += MESHOPT_FIFO_SIZE + 1; // flush
+        int runningMisses = 0;
+        int runningTriangles = 0;
+        for(int t = start; t < end; t++){
+            runningMisses += meshopt_cacheTriangle(&indices[t * 3], loadedAt, &time);
+            runningTriangles++;
+            if((float)runningMisses / (float)runningTriangles <= target && t + 1 < end){
+                clusters[clusterCount++].start = t + 1;
+                time += MESHOPT_FIFO_SIZE + 1;
+                runningMisses = 0;
+                runningTriangles = 0;
+            }
+        }
+        // The leftover tail is usually a few triangles with a bad ACMR, merge it into the previous cluster.
+        if(clusterCount - firstCluster > 1){
+            clusterCount--;
+        }
+        for(int c = firstCluster; c < clusterCount; c++){
+            clusters[c].end = c + 1 < clusterCount ? clusters[c + 1].start : end;
+        }
+    }
+
+    // Mesh centroid
+    vec3 meshCenter = {0.0f, 0.0f, 0.0f};
+    for(int i = 0; i < vertexCount; i++){
+        vec3_add(meshCenter, meshCenter, vertices[i].position);
+    }
+    vec3_scale(meshCenter, meshCenter, 1.0f / (float)vertexCount);
+
+    // Sort key: area weighted cluster normal dot direction from the mesh center, outer & outward facing first.
+    for(int c = 0; c < clusterCount; c++){
+        vec3 center = {0.0f, 0.0f, 0.0f};
+        vec3 normal = {0.0f, 0.0f, 0.0f};
+        float totalArea = 0.0f;
+        for(int t = clusters[c].start; t < clusters[c].end; t++){
+            const float* p0 = vertices[indices[t * 3]].position;
+            const float* p1 = vertices[indices[t * 3 + 1]].position;
+            const float* p2 = vertices[indices[t * 3 + 2]].position;
+            vec3 e1, e2, n;
+            vec3_sub(e1, p1, p0);
+            vec3_sub(e2, p2, p0);
+            vec3_mul_cross(n, e1, e2); // length = 2 * area
+            float area = vec3_len(n);
+            for(int k = 0; k < 3; k++){
+                center[k] += (p0[k] + p1[k] + p2[k]) * (area / 3.0f);
+            }
+            vec3_add(normal, normal, n);
+            totalArea += area;
+        }
+        if(totalArea > 0.0f){
+            vec3_scale(center, center, 1.0f / totalArea);
+        }
+        float normalLength = vec3_len(normal);
+        if(normalLength > 0.0f){
+            vec3_scale(normal, normal, 1.0f / normalLength);
+        }
+        vec3 offset;
+        vec3_sub(offset, center, meshCenter);
+        clusters[c].sortKey = vec3_mul_inner(offset, normal);
+    }
+    qsort(clusters, clusterCount, sizeof(MeshCluster), meshopt_compareClusters);
+
+    GLuint* output = (GLuint*)meshopt_alloc(triangleCount * 3 * sizeof(GLuint));
+    int outputIndex = 0;
+    for(int c = 0; c < clusterCount; c++){
+        int count = (clusters[c].end - clusters[c].start) * 3;
+        memcpy(&output[outputIndex], &indices[clusters[c].start * 3], count * sizeof(GLuint));
+        outputIndex += count;
+    }
+    memcpy(indices, output, triangleCount * 3 * sizeof(GLuint));
+
+    free(output);
+    free(loadedAt);
+    free(hardStarts);
+    free(clusters);
+    free(triangleMisses);
+    PROFILE_END();
+}
+
+/**
+ * @brief Reorder vertices by first use in the index buffer & remap the indices. Unused vertices move to the end.
+ */
+void meshopt_optimizeVertexFetch(Vertex* vertices, GLuint* indices, int indexCount, int vertexCount){
+    if(vertexCount == 0){
+        return;
+    }
+    PROFILE_BEGIN("meshopt_optimizeVertexFetch");
+    GLuint* remap = (GLuint*)meshopt_alloc(vertexCount * sizeof(GLuint));
+    Vertex* reordered = (Vertex*)meshopt_alloc(vertexCount * sizeof(Vertex));
+    for(int i = 0; i < vertexCount; i++){
+        remap[i] = UINT32_MAX;
+    }
+    GLuint next = 0;
+    for(int i = 0; i < indexCount; i++){
+        GLuint v = indices[i];
+        if(remap[v] == UINT32_MAX){
+            remap[v] = next;
+            reordered[next++] = vertices[v];
+        }
+        indices[i] = remap[v];
+    }
+    for(int i = 0; i < vertexCount; i++){
+        if(remap[i] == UINT32_MAX){
+            reordered[next++] = vertices[i];
+        }
+    }
+    memcpy(vertices, reordered, vertexCount * sizeof(Vertex));
+    free(remap);
+    free(reordered);
+    PROFILE_END();
+}
@@ -0,0 +1,36 @@
+#ifndef MESHOPT_H
+#define MESHOPT_H
+
+#include <stdbool.h>
+#include "types.h"
+
+/**
+ * Mesh optimization for indexed triangle lists, run on import.
+ * 1. Triangle order for the post-transform vertex cache, Tom Forsyth's linear-speed algorithm
+ *    (simulated LRU cache, scores favour recently used & low valence vertices).
+ * 2. Optional overdraw pass: the cache optimized order is cut into clusters at cache restarts and wherever
+ *    a cluster already reaches its ACMR target, clusters are then sorted so outward facing ones on
+ *    the outside of the mesh draw first and hide what's behind them. Costs at most
+ *    MESHOPT_OVERDRAW_THRESHOLD times the ACMR.
+ * 3. Vertex order = first use in the index buffer, so vertex fetch walks memory linearly.
+ *
+ * ACMR: transformed vertices per triangle (0.5 is ideal on big grids, 3 is no reuse at all).
+ * ATVR: transformed vertices per unique vertex (1 is ideal).
+ * Both are measured with a MESHOPT_FIFO_SIZE FIFO, a typical hardware post-transform cache.
+ */
+
+#define MESHOPT_CACHE_SIZE 32 // LRU size Forsyth's scoring assumes
+#define MESHOPT_FIFO_SIZE 16
+#define MESHOPT_OVERDRAW_THRESHOLD 1.05f
+
+typedef struct MeshCacheStats {
+    float acmr;
+    float atvr;
+} MeshCacheStats;
+
+MeshCacheStats meshopt_analyzeVertexCache(const GLuint* indices, int indexCount, int vertexCount);
+void meshopt_optimizeVertexCache(GLuint* indices, int indexCount, int vertexCount);
+void meshopt_optimizeOverdraw(GLuint* indices, int indexCount, const Vertex* vertices, int vertexCount, float threshold);
+void meshopt_optimizeVertexFetch(Vertex* vertices, GLuint* indices, int indexCount, int vertexCount);
+
+#endif
@@ -2,6 +2,8 @@
 #include "linmath.h"
 #include "globals.h"
 #include "opengl.h"
+#include "profiler.h"
+#include "pack.h"
 
 
 /** 
@@ -150,6 +152,26 @@ void depthshadow_setViewportForDepthMapShadowRender(View view){
 
 static bool myTempVar = true;
 
+/**
+ * @brief Draw the bound VAO, indexed when the buffer has indices.
+ */
+static void drawGpuData(GpuData* buffer, GLenum drawMode){
+    if(buffer->numIndicies != 0){
+        glDrawElements(drawMode, buffer->numIndicies, buffer->indexType, 0);
+    }else {
+        glDrawArrays(drawMode, 0, buffer->vertexCount);
+    }
+}
+
+/**
+ * @brief Uniforms that undo the buffer's vertex quantization, for shaders that read positions/normals.
+ */
+static void setVertexLayoutUniforms(GLuint shaderProgram, GpuData* buffer){
+    glUniform3fv(glGetUniformLocation(shaderProgram, "positionScale"), 1, buffer->positionScale);
+    glUniform3fv(glGetUniformLocation(shaderProgram, "positionOffset"), 1, buffer->positionOffset);
+    glUniform1i(glGetUniformLocation(shaderProgram, "octahedralNormals"), buffer->vertexLayout.normal == VERTEX_NORMAL_OCT16);
+}
+
 void depthshadow_renderToDepthTexture(GpuData *buffer,TransformComponent *transformComponent)
 {
     for(int i = 0; i < globals.lightsCount; i++){
@@ -167,9 +189,10 @@ void depthshadow_renderToDepthTexture(GpuData *buffer,TransformComponent *transf
                     glUseProgram(globals.depthMapBuffer.shaderProgram);
                     unsigned int modelLoc = glGetUniformLocation(globals.depthMapBuffer.shaderProgram, "model");
                     glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &transformComponent->transform[0][0]);
+                    setVertexLayoutUniforms(globals.depthMapBuffer.shaderProgram, buffer);
                     glUniformMatrix4fv(glGetUniformLocation(globals.depthMapBuffer.shaderProgram, "lightSpaceMatrix"), 1, GL_FALSE, (const GLfloat*)&globals.lightSpaceMatrix[globals.lights[i].lightSpaceMatrixIndex[j]][0][0]);  
                     glBindVertexArray(buffer->VAO);
-                    glDrawArrays(GL_TRIANGLES, 0, buffer->vertexCount);
+                    drawGpuData(buffer, GL_TRIANGLES);
 
                     // debug drawcalls
                     if(globals.debugDrawCalls){
@@ -187,9 +210,10 @@ void depthshadow_renderToDepthTexture(GpuData *buffer,TransformComponent *transf
                 glUseProgram(globals.depthMapBuffer.shaderProgram);
                 unsigned int modelLoc = glGetUniformLocation(globals.depthMapBuffer.shaderProgram, "model");
                 glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &transformComponent->transform[0][0]);
+                setVertexLayoutUniforms(globals.depthMapBuffer.shaderProgram, buffer);
                 glUniformMatrix4fv(glGetUniformLocation(globals.depthMapBuffer.shaderProgram, "lightSpaceMatrix"), 1, GL_FALSE, (const GLfloat*)&globals.lightSpaceMatrix[globals.lights[i].lightSpaceMatrixIndex[0]][0][0]);  
                 glBindVertexArray(buffer->VAO);
-                glDrawArrays(GL_TRIANGLES, 0, buffer->vertexCount);
+                drawGpuData(buffer, GL_TRIANGLES);
 
                 // debug drawcalls
                 if(globals.debugDrawCalls){
@@ -209,12 +233,349 @@ void depthshadow_renderToDepthTexture(GpuData *buffer,TransformComponent *transf
     myTempVar = false;
 }
 
+/**
+ * @brief Float to IEEE half, round to nearest. Out of range values become infinity, tiny ones zero or denormal.
+ */
+static uint16_t floatToHalf(float value){
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    if(exponent >= 31){
+        return (uint16_t)(sign | 0x7C00);
+    }
+    if(exponent <= 0){
+        if(exponent < -10){
+            return (uint16_t)sign;
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        if((mantissa >> (shift - 1)) & 1){
+            half++;
+        }
+        return (uint16_t)(sign | half);
+    }
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    if(mantissa & 0x1000){
+        half++; // carry into the exponent is the correct rounding
+    }
+    return (uint16_t)half;
+}
+
+static float halfToFloat(uint16_t half){
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    float value;
+    if(exponent == 0){
+        value = ldexpf((float)mantissa, -24); // zero or denormal
+    }else if(exponent == 31){
+        value = mantissa == 0 ? INFINITY : NAN;
+    }else {
+        value = ldexpf((float)(mantissa | 0x400), (int)exponent - 25);
+    }
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits |= sign;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static int16_t floatToSnorm16(float value){
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return (int16_t)roundf(value * 32767.0f);
+}
+
+static uint16_t floatToUnorm16(float value){
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (uint16_t)roundf(value * 65535.0f);
+}
+
+static uint32_t floatToSnorm10(float value){
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return (uint32_t)(int32_t)roundf(value * 511.0f) & 0x3FF;
+}
+
+/**
+ * @brief Octahedral normal encoding, the unit sphere is folded onto the [-1,1] square. Matches octDecode in mesh_vertex.glsl.
+ */
+static void encodeOctahedral(const vec3 normal, int16_t out[2]){
+    float l1 = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+    if(l1 == 0.0f){
+        out[0] = 0;
+        out[1] = 0;
+        return;
+    }
+    float x = normal[0] / l1;
+    float y = normal[1] / l1;
+    if(normal[2] < 0.0f){
+        float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    out[0] = floatToSnorm16(x);
+    out[1] = floatToSnorm16(y);
+}
+
+typedef struct VertexAttribOffsets {
+    size_t position;
+    size_t color;
+    size_t texcoord;
+    size_t normal;
+    GLsizei stride;
+} VertexAttribOffsets;
+
+static VertexAttribOffsets vertexAttribOffsets(const VertexLayout* layout){
+    VertexAttribOffsets offsets = {0};
+    size_t size = 0;
+    offsets.position = size;
+    size += layout->position == VERTEX_POSITION_UNORM16 ? 4 * sizeof(uint16_t) : 3 * sizeof(float); // 4th short keeps 4 byte alignment
+    offsets.color = size;
+    size += layout->dropColor ? 0 : 3 * sizeof(float);
+    offsets.texcoord = size;
+    size += layout->uv == VERTEX_UV_HALF || layout->uv == VERTEX_UV_UNORM16 ? 2 * sizeof(uint16_t) : 2 * sizeof(float);
+    offsets.normal = size;
+    size += layout->normal == VERTEX_NORMAL_OCT16 || layout->normal == VERTEX_NORMAL_INT_2_10_10_10 ? sizeof(uint32_t) : 3 * sizeof(float);
+    offsets.stride = (GLsizei)size;
+    return offsets;
+}
+
+/**
+ * @brief Bytes per vertex in a layout.
+ */
+GLsizei vertexLayoutStride(const VertexLayout* layout){
+    return vertexAttribOffsets(layout).stride;
+}
+
+/**
+ * @brief Does every index point at one of vertexCount vertices. For meshes read from a file, the GPU reads
+ * whatever vertex an index names. indices must be aligned to the index size.
+ */
+bool indicesInRange(const void* indices, GLenum indexType, uint64_t indexCount, uint64_t vertexCount){
+    if(indexType == GL_UNSIGNED_SHORT){
+        const unsigned short* shorts = (const unsigned short*)indices;
+        for(uint64_t i = 0; i < indexCount; i++){
+            if(shorts[i] >= vertexCount){
+                return false;
+            }
+        }
+        return true;
+    }
+    const unsigned int* ints = (const unsigned int*)indices;
+    for(uint64_t i = 0; i < indexCount; i++){
+        if(ints[i] >= vertexCount){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Pack vertices into layout and indices into 16 bit when the vertices allow it, no GL calls.
+ * Fills in the position dequantization and may fall back to a wider uv format. Free with freePackedMesh.
+ */
+PackedMesh packMesh(const Vertex* vertices, int vertexCount, const unsigned int* indices, int indexCount, VertexLayout layout){
+    #ifdef __EMSCRIPTEN__
+    layout = VERTEX_LAYOUT_FULL; // wasm shaders take plain floats
+    #endif
+    vec3 boundsMin = {0.0f, 0.0f, 0.0f};
+    vec3 boundsMax = {0.0f, 0.0f, 0.0f};
+    bool uvsInUnitRange = true;
+    for(int i = 0; i < vertexCount; i++){
+        for(int axis = 0; axis < 3; axis++){
+            float p = vertices[i].position[axis];
+            if(i == 0 || p < boundsMin[axis]) boundsMin[axis] = p;
+            if(i == 0 || p > boundsMax[axis]) boundsMax[axis] = p;
+        }
+        for(int axis = 0; axis < 2; axis++){
+            float t = vertices[i].texcoord[axis];
+            if(t < 0.0f || t > 1.0f) uvsInUnitRange = false;
+        }
+    }
+    if(layout.uv == VERTEX_UV_UNORM16 && !uvsInUnitRange){
+        layout.uv = VERTEX_UV_HALF;
+    }
+
+    PackedMesh mesh = {0};
+    mesh.layout = layout;
+    VertexAttribOffsets offsets = vertexAttribOffsets(&layout);
+    size_t size = (size_t)offsets.stride;
+    mesh.stride = offsets.stride;
+    mesh.vertexCount = vertexCount;
+    mesh.indexCount = indexCount;
+    mesh.indexType = vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    for(int axis = 0; axis < 3; axis++){
+        if(layout.position == VERTEX_POSITION_UNORM16){
+            mesh.positionScale[axis] = boundsMax[axis] - boundsMin[axis]; // normalized attribute arrives in [0,1]
+            mesh.positionOffset[axis] = boundsMin[axis];
+        }else {
+            mesh.positionScale[axis] = 1.0f;
+            mesh.positionOffset[axis] = 0.0f;
+        }
+    }
+
+    unsigned char* packed = malloc(size * (vertexCount > 0 ? vertexCount : 1));
+    size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    void* packedIndices = malloc(indexSize * (indexCount > 0 ? indexCount : 1));
+    if(packed == NULL || packedIndices == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate vertex buffer of %d vertices\n" TEXT_COLOR_RESET, vertexCount);
+        exit(1);
+    }
+    for(int i = 0; i < vertexCount; i++){
+        const Vertex* v = &vertices[i];
+        unsigned char* out = packed + (size_t)i * size;
+
+        if(layout.position == VERTEX_POSITION_UNORM16){
+            uint16_t position[4] = {0, 0, 0, 0};
+            for(int axis = 0; axis < 3; axis++){
+                float extent = boundsMax[axis] - boundsMin[axis];
+                position[axis] = extent > 0.0f ? floatToUnorm16((v->position[axis] - boundsMin[axis]) / extent) : 0;
+            }
+            memcpy(out + offsets.position, position, sizeof(position));
+        }else {
+            memcpy(out + offsets.position, v->position, 3 * sizeof(float));
+        }
+
+        if(!layout.dropColor){
+            memcpy(out + offsets.color, v->color, 3 * sizeof(float));
+        }
+
+        if(layout.uv == VERTEX_UV_HALF){
+            uint16_t uv[2] = {floatToHalf(v->texcoord[0]), floatToHalf(v->texcoord[1])};
+            memcpy(out + offsets.texcoord, uv, sizeof(uv));
+        }else if(layout.uv == VERTEX_UV_UNORM16){
+            uint16_t uv[2] = {floatToUnorm16(v->texcoord[0]), floatToUnorm16(v->texcoord[1])};
+            memcpy(out + offsets.texcoord, uv, sizeof(uv));
+        }else {
+            memcpy(out + offsets.texcoord, v->texcoord, 2 * sizeof(float));
+        }
+
+        if(layout.normal == VERTEX_NORMAL_OCT16){
+            int16_t normal[2];
+            encodeOctahedral(v->normal, normal);
+            memcpy(out + offsets.normal, normal, sizeof(normal));
+        }else if(layout.normal == VERTEX_NORMAL_INT_2_10_10_10){
+            vec3 n = {0.0f, 0.0f, 0.0f};
+            float length = vec3_len(v->normal);
+            if(length > 0.0f){
+                vec3_scale(n, v->normal, 1.0f / length);
+            }
+            uint32_t normal = floatToSnorm10(n[0]) | (floatToSnorm10(n[1]) << 10) | (floatToSnorm10(n[2]) << 20);
+            memcpy(out + offsets.normal, &normal, sizeof(normal));
+        }else {
+            memcpy(out + offsets.normal, v->normal, 3 * sizeof(float));
+        }
+    }
+
+    // 16 bit indices when the vertices allow it (half the index memory & bandwidth)
+    if(mesh.indexType == GL_UNSIGNED_SHORT){
+        unsigned short* shortIndices = (unsigned short*)packedIndices;
+        for(int i = 0; i < indexCount; i++){
+            shortIndices[i] = (unsigned short)indices[i];
+        }
+    }else if(indexCount > 0){
+        memcpy(packedIndices, indices, indexCount * sizeof(unsigned int));
+    }
+    mesh.vertices = packed;
+    mesh.indices = packedIndices;
+    return mesh;
+}
+
+void freePackedMesh(PackedMesh* mesh){
+    free((void*)mesh->vertices);
+    free((void*)mesh->indices);
+    mesh->vertices = NULL;
+    mesh->indices = NULL;
+}
+
+static void growBounds(BoundingBox* bounds, float* texcoordExtent, int i, const float position[3], const float texcoord[2], float texcoordMin[2], float texcoordMax[2]){
+    for(int axis = 0; axis < 3; axis++){
+        if(i == 0 || position[axis] < bounds->min[axis]) bounds->min[axis] = position[axis];
+        if(i == 0 || position[axis] > bounds->max[axis]) bounds->max[axis] = position[axis];
+    }
+    for(int axis = 0; axis < 2; axis++){
+        if(i == 0 || texcoord[axis] < texcoordMin[axis]) texcoordMin[axis] = texcoord[axis];
+        if(i == 0 || texcoord[axis] > texcoordMax[axis]) texcoordMax[axis] = texcoord[axis];
+        float extent = texcoordMax[axis] - texcoordMin[axis];
+        if(extent > *texcoordExtent) *texcoordExtent = extent;
+    }
+}
+
+/**
+ * @brief Local bounds of vertices and the widest texcoord range over u & v (how many times a texture repeats across the mesh).
+ */
+void meshBounds(const Vertex* vertices, int vertexCount, BoundingBox* bounds, float* texcoordExtent){
+    *bounds = (BoundingBox){0};
+    *texcoordExtent = 0.0f;
+    float texcoordMin[2] = {0.0f, 0.0f};
+    float texcoordMax[2] = {0.0f, 0.0f};
+    for(int i = 0; i < vertexCount; i++){
+        growBounds(bounds, texcoordExtent, i, vertices[i].position, vertices[i].texcoord, texcoordMin, texcoordMax);
+    }
+}
+
+/**
+ * @brief meshBounds of already packed vertices, decoded from the layout.
+ */
+void packedMeshBounds(const PackedMesh* mesh, BoundingBox* bounds, float* texcoordExtent){
+    *bounds = (BoundingBox){0};
+    *texcoordExtent = 0.0f;
+    float texcoordMin[2] = {0.0f, 0.0f};
+    float texcoordMax[2] = {0.0f, 0.0f};
+    VertexAttribOffsets offsets = vertexAttribOffsets(&mesh->layout);
+    for(int i = 0; i < mesh->vertexCount; i++){
+        const unsigned char* in = (const unsigned char*)mesh->vertices + (size_t)i * mesh->stride;
+        float position[3];
+        float texcoord[2];
+        if(mesh->layout.position == VERTEX_POSITION_UNORM16){
+            uint16_t packed[4];
+            memcpy(packed, in + offsets.position, sizeof(packed));
+            for(int axis = 0; axis < 3; axis++){
+                position[axis] = mesh->positionOffset[axis] + mesh->positionScale[axis] * (packed[axis] / 65535.0f);
+            }
+        }else {
+            memcpy(position, in + offsets.position, sizeof(position));
+        }
+        if(mesh->layout.uv == VERTEX_UV_HALF || mesh->layout.uv == VERTEX_UV_UNORM16){
+            uint16_t packed[2];
+            memcpy(packed, in + offsets.texcoord, sizeof(packed));
+            for(int axis = 0; axis < 2; axis++){
+                texcoord[axis] = mesh->layout.uv == VERTEX_UV_HALF ? halfToFloat(packed[axis]) : packed[axis] / 65535.0f;
+            }
+        }else {
+            memcpy(texcoord, in + offsets.texcoord, sizeof(texcoord));
+        }
+        growBounds(bounds, texcoordExtent, i, position, texcoord, texcoordMin, texcoordMax);
+    }
+}
+
 /** 
- * @brief Setup buffer to render a mesh.
+ * @brief Setup buffer to render a mesh, vertices are packed into buffer->vertexLayout.
 */
 void setupMesh(Vertex* vertices, int vertexCount, unsigned int* indices, int indexCount, GpuData* buffer) {
+    PackedMesh mesh = packMesh(vertices, vertexCount, indices, indexCount, buffer->vertexLayout);
+    setupPackedMesh(&mesh, buffer);
+    freePackedMesh(&mesh);
+}
 
-    buffer->numIndicies = indexCount;
+/**
+ * @brief Setup buffer to render already packed vertices & indices, uploaded as they are.
+ * The mesh cache calls this with pointers straight into its file mapping.
+ */
+void setupPackedMesh(const PackedMesh* mesh, GpuData* buffer) {
+    VertexAttribOffsets offsets = vertexAttribOffsets(&mesh->layout);
+    ASSERT(offsets.stride == mesh->stride, "Packed mesh stride doesn't match its layout");
+    buffer->vertexLayout = mesh->layout;
+    for(int axis = 0; axis < 3; axis++){
+        buffer->positionScale[axis] = mesh->positionScale[axis];
+        buffer->positionOffset[axis] = mesh->positionOffset[axis];
+    }
+    buffer->numIndicies = mesh->indexCount;
+    buffer->indexType = mesh->indexType;
     glGenVertexArrays(1, &(buffer->VAO));
     glGenBuffers(1, &(buffer->VBO));
     glGenBuffers(1, &buffer->EBO);
@@ -224,29 +585,54 @@ void setupMesh(Vertex* vertices, int vertexCount, unsigned int* indices, int ind
     glBindBuffer(GL_ARRAY_BUFFER, buffer->VBO);
 
     // Copy vertices to buffer
-    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)mesh->stride * mesh->vertexCount, mesh->vertices, GL_STATIC_DRAW);
 
     // Bind/Activate EBO
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->EBO);
 
     // Copy indices to buffer
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+    size_t indexSize = mesh->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexSize * mesh->indexCount, mesh->indices, GL_STATIC_DRAW);
+
+    // This tells OpenGL how to interpret the vertex data
+    const VertexLayout* layout = &mesh->layout;
+    GLsizei stride = offsets.stride;
 
-    // This line tells OpenGL how to interpret the vertex data
     // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)0);
+    if(layout->position == VERTEX_POSITION_UNORM16){
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (GLvoid*)offsets.position);
+    }else {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offsets.position);
+    }
     glEnableVertexAttribArray(0);
 
     // Color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
-    
+    if(layout->dropColor){
+        glDisableVertexAttribArray(1);
+        glVertexAttrib3f(1, 1.0f, 1.0f, 1.0f);
+    }else {
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offsets.color);
+        glEnableVertexAttribArray(1);
+    }
+
     // Texture attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
+    if(layout->uv == VERTEX_UV_HALF){
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (GLvoid*)offsets.texcoord);
+    }else if(layout->uv == VERTEX_UV_UNORM16){
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (GLvoid*)offsets.texcoord);
+    }else {
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offsets.texcoord);
+    }
     glEnableVertexAttribArray(2);
 
     // Normal attribute
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
+    if(layout->normal == VERTEX_NORMAL_OCT16){
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, stride, (GLvoid*)offsets.normal);
+    }else if(layout->normal == VERTEX_NORMAL_INT_2_10_10_10){
+        glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (GLvoid*)offsets.normal);
+    }else {
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offsets.normal);
+    }
     glEnableVertexAttribArray(3);
 
     // Unbind VBO/buffer
@@ -256,13 +642,21 @@ void setupMesh(Vertex* vertices, int vertexCount, unsigned int* indices, int ind
     glBindVertexArray(0);
 }
 
+static void compileShaderProgram(GpuData* buffer,const char* vertexPath,const char* fragmentPath);
+
 void setupMaterial(GpuData* buffer,const char* vertexPath,const char* fragmentPath){
+    PROFILE_BEGIN("setupMaterial");
+    compileShaderProgram(buffer, vertexPath, fragmentPath);
+    PROFILE_END();
+}
+
+static void compileShaderProgram(GpuData* buffer,const char* vertexPath,const char* fragmentPath){
      #ifdef __EMSCRIPTEN__
-        char* vertexShaderSource = readFile("shaders/wasm/mesh_vertex_wasm.glsl"); // TODO: fix path
-        char* fragmentShaderSource = readFile("shaders/wasm/mesh_fragment_wasm.glsl"); //  TODO: fix path
+        const char* vertexShaderSource = readFile("shaders/wasm/mesh_vertex_wasm.glsl"); // TODO: fix path
+        const char* fragmentShaderSource = readFile("shaders/wasm/mesh_fragment_wasm.glsl"); //  TODO: fix path
     #else
-        char* vertexShaderSource = readFile(vertexPath);
-        char* fragmentShaderSource = readFile(fragmentPath);
+        const char* vertexShaderSource = readFile(vertexPath);
+        const char* fragmentShaderSource = readFile(fragmentPath);
     #endif
 
     if(fragmentShaderSource == NULL || vertexShaderSource == NULL) {
@@ -307,8 +701,8 @@ void setupMaterial(GpuData* buffer,const char* vertexPath,const char* fragmentPa
     }
 
     // free memory of shader sources
-    free(vertexShaderSource);
-    free(fragmentShaderSource);
+    freeFile(vertexShaderSource);
+    freeFile(fragmentShaderSource);
 
     // Link shaders
     buffer->shaderProgram = glCreateProgram();
@@ -425,7 +819,7 @@ void initializeShaderProgram(ShaderProgram* shaderProgram, const char* vertexPat
     shaderProgram->texture1Loc = glGetUniformLocation(shaderProgram->shaderProgram, "texture1");
 }
  */
-void renderMesh(GpuData* buffer,TransformComponent* transformComponent, Camera* camera,MaterialComponent* material) {
+void renderMesh(GpuData* buffer,TransformComponent* transformComponent, Camera* camera,MaterialComponent* materialComponent) {
  
     // Check if camera is NULL
     if (camera == NULL) {
@@ -433,6 +827,9 @@ void renderMesh(GpuData* buffer,TransformComponent* transformComponent, Camera*
         return;
     }
      
+    // Shared by every entity with this material, the component only adds the tint.
+    Material* material = getMaterial(materialComponent->materialIndex);
+
     // Set shader
     glUseProgram(buffer->shaderProgram);
 
@@ -486,11 +883,11 @@ void renderMesh(GpuData* buffer,TransformComponent* transformComponent, Camera*
     glUniform1f(glGetUniformLocation(buffer->shaderProgram, "far_plane"), camera->far); // TODO, use projCoord.z instead and remove this?
 
     // Set diffuseMapOpacity uniform
-    glUniform1f(glGetUniformLocation(buffer->shaderProgram, "material.diffuseMapOpacity"), material->diffuseMapOpacity);
+    glUniform1f(glGetUniformLocation(buffer->shaderProgram, "material.diffuseMapOpacity"), materialComponent->diffuseMapOpacity);
 
     // Set the diffuseColor uniform
     GLint diffuseColorLocation = glGetUniformLocation(buffer->shaderProgram, "material.diffuseColor");
-    glUniform4f(diffuseColorLocation, material->diffuse.r, material->diffuse.g, material->diffuse.b, material->diffuse.a);
+    glUniform4f(diffuseColorLocation, materialComponent->diffuse.r, materialComponent->diffuse.g, materialComponent->diffuse.b, materialComponent->diffuse.a);
 
     // Set the ambient uniform
     GLint ambientLocation = glGetUniformLocation(buffer->shaderProgram, "ambient");
@@ -1021,13 +1418,10 @@ void renderMesh(GpuData* buffer,TransformComponent* transformComponent, Camera*
     glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &camera->view[0][0]);
 
     glUniformMatrix4fv(glGetUniformLocation(buffer->shaderProgram, "projection"), 1, GL_FALSE, &camera->projection[0][0]);
+    setVertexLayoutUniforms(buffer->shaderProgram, buffer);
       
     glBindVertexArray(buffer->VAO);
-   if(buffer->numIndicies != 0) {
-        glDrawElements(buffer->drawMode ,buffer->numIndicies,GL_UNSIGNED_INT,0);
-    }else {
-        glDrawArrays(buffer->drawMode, 0, buffer->vertexCount);
-   }
+    drawGpuData(buffer, buffer->drawMode);
 
    // debug drawcalls
    if(globals.debugDrawCalls){
@@ -1040,16 +1434,27 @@ void renderMesh(GpuData* buffer,TransformComponent* transformComponent, Camera*
 
 
 
-GLuint setupTexture(TextureData textureData){
+/**
+ * @brief New texture object with the params' filtering/wrapping, nothing uploaded yet.
+ */
+static GLuint createTexture(TextureParams params){
     GLuint texture;
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
     // set the texture wrapping/filtering options (on the currently bound texture object)
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); 
-    
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, params.wrap);	
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, params.wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, params.minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, params.magFilter); 
+    return texture;
+}
+
+/**
+ * @brief Upload decoded pixels (& mipmaps) into an existing texture object, replacing what it held.
+ * Frees the pixels on success.
+ * @param colorSpace sRGB textures are stored as such when gamma correction is on, linear ones never are.
+ */
+bool uploadTexture(GLuint texture, TextureData textureData, TextureColorSpace colorSpace){
     // Use tightly packed data , this necessary?
   //   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     
@@ -1059,22 +1464,148 @@ GLuint setupTexture(TextureData textureData){
     printf("Texture channels: %d\n", textureData.channels); */
     if(textureData.data == NULL){
         printf("Error: Texture data is null\n");
-        return 0;
+        return false;
     }
     if(textureData.channels < 3){
         printf("Error: Texture must have at least 3 channels\n");
-        return 0;
+        return false;
     }
+    glBindTexture(GL_TEXTURE_2D, texture);
     if(textureData.channels == 4){
-        glTexImage2D(GL_TEXTURE_2D, 0, globals.gamma ? GL_SRGB8_ALPHA8 : GL_RGBA, textureData.width, textureData.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, textureData.data);
+        bool srgb = globals.gamma && colorSpace == TEXTURE_COLORSPACE_SRGB;
+        glTexImage2D(GL_TEXTURE_2D, 0, srgb ? GL_SRGB8_ALPHA8 : GL_RGBA, textureData.width, textureData.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, textureData.data);
     }
     if(textureData.channels == 3){
-        glTexImage2D(GL_TEXTURE_2D, 0, globals.gamma ? GL_SRGB : GL_RGB, textureData.width, textureData.height, 0, GL_RGB, GL_UNSIGNED_BYTE, textureData.data);
+        // Always linear, GL_SRGB8 isn't color renderable in GLES3 so glGenerateMipmap fails on it.
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, textureData.width, textureData.height, 0, GL_RGB, GL_UNSIGNED_BYTE, textureData.data);
     }
     glGenerateMipmap(GL_TEXTURE_2D);
 
     stbi_image_free(textureData.data);
+    return true;
+}
+
+/**
+ * @brief Does the current context list an extension. Goes through glGetStringi so it works without SDL video
+ * (headless EGL contexts) and on core profiles, where GL_EXTENSIONS isn't one string.
+ */
+bool glExtensionSupported(const char* name){
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for(GLint i = 0; i < extensionCount; i++){
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if(extension != NULL && strcmp(extension, name) == 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Can this context take the ETC2/EAC textures texcompress writes. Core in GLES 3.0 & desktop GL 4.3, the
+ * desktop GL 3.3 context we ask for natively only has them through GL_ARB_ES3_compatibility. Drivers don't list
+ * them in GL_COMPRESSED_TEXTURE_FORMATS on desktop, so go by version & extension. Needs a current GL context.
+ */
+bool compressedTexturesSupported(){
+    #if !TEXCOMPRESS_ENABLED
+        return false;
+    #else
+        const char* version = (const char*)glGetString(GL_VERSION);
+        if(version == NULL){
+            return false;
+        }
+        if(strncmp(version, "OpenGL ES", 9) == 0){
+            return true;
+        }
+        int major = 0;
+        int minor = 0;
+        if(sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 4 || (major == 4 && minor >= 3))){
+            return true;
+        }
+        return glExtensionSupported("GL_ARB_ES3_compatibility");
+    #endif
+}
+
+/**
+ * @brief Internal format a compressed texture is uploaded as. sRGB textures use the sRGB ETC2 formats when
+ * gamma correction is on, the blocks are the same. Pick it once per texture, every level has to match.
+ */
+GLenum compressedTextureFormat(const CompressedTexture* compressed, TextureColorSpace colorSpace){
+    bool srgb = globals.gamma && colorSpace == TEXTURE_COLORSPACE_SRGB;
+    if(!srgb){
+        return compressed->format;
+    }
+    return compressed->format == GL_COMPRESSED_RGBA8_ETC2_EAC ? GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC : GL_COMPRESSED_SRGB8_ETC2;
+}
+
+/**
+ * @brief Upload a prebuilt ETC2 mip chain into an existing texture object, replacing what it held.
+ * Levels finer than baseLevel are left out, GL_TEXTURE_BASE_LEVEL keeps sampling off them (see texstream.h).
+ * @param format from compressedTextureFormat
+ * @return false if GL rejected a level, the caller uploads the image uncompressed instead.
+ */
+bool uploadCompressedTexture(GLuint texture, const CompressedTexture* compressed, GLenum format, int baseLevel){
+    if(compressed->levelCount < 1 || baseLevel < 0 || baseLevel >= compressed->levelCount){
+        printf("Error: Compressed texture has no level %d\n", baseLevel);
+        return false;
+    }
+    while(glGetError() != GL_NO_ERROR){
+        // Not ours, don't blame this upload for it
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    for(int level = baseLevel; level < compressed->levelCount; level++){
+        int width = compressed->width >> level;
+        int height = compressed->height >> level;
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width > 0 ? width : 1, height > 0 ? height : 1, 0, compressed->levelSizes[level], compressed->levels[level]);
+    }
+    GLenum error = glGetError();
+    if(error != GL_NO_ERROR){
+        printf(TEXT_COLOR_WARNING "Compressed texture upload failed (0x%x)\n" TEXT_COLOR_RESET, error);
+        return false;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, baseLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, compressed->levelCount - 1);
+    return true;
+}
+
+/**
+ * @brief Upload one more level of a texture from uploadCompressedTexture, level is the one above its base level.
+ * @param format the one the texture was first uploaded with
+ */
+void uploadCompressedLevel(GLuint texture, const CompressedTexture* compressed, GLenum format, int level){
+    int width = compressed->width >> level;
+    int height = compressed->height >> level;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width > 0 ? width : 1, height > 0 ? height : 1, 0, compressed->levelSizes[level], compressed->levels[level]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+}
+
+/**
+ * @brief Free the base level of a compressed texture, respecified as 0x0, sampling moves to the next level.
+ */
+void evictCompressedLevel(GLuint texture, GLenum format, int level){
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, format, 0, 0, 0, 0, NULL);
+}
+
+GLuint setupTexture(TextureData textureData, TextureParams params){
+    GLuint texture = createTexture(params);
+    if(!uploadTexture(texture, textureData, params.colorSpace)){
+        return 0;
+    }
+    return texture;
+}
+
+/**
+ * @brief A texture holding one white pixel, handed out while the real image loads. uploadTexture fills in the
+ * same texture object later, so materials keep the id they got.
+ */
+GLuint setupPlaceholderTexture(TextureParams params){
+    static const unsigned char white[4] = {255, 255, 255, 255};
+    GLuint texture = createTexture(params);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glGenerateMipmap(GL_TEXTURE_2D);
     return texture;
 }
 
@@ -1155,9 +1686,13 @@ void setupFontTextures(char* fontPath,int fontSize){
         exit(1);
     }
 
-    // Load font
+    // Load font, a packed font is read in place
     FT_Face face;
-    if (FT_New_Face(ft, fontPath, 0, &face))
+    PackView view;
+    FT_Error error = pack_find(fontPath, &view)
+        ? FT_New_Memory_Face(ft, (const FT_Byte*)view.data, (FT_Long)view.size, 0, &face)
+        : FT_New_Face(ft, fontPath, 0, &face);
+    if (error)
     {
         printf("ERROR::FREETYPE: Failed to load font\n");
         exit(1);
@@ -7,13 +7,29 @@
 #include "opengl_types.h"
 #include "types.h"
 #include "utils.h"
+#include "texcompress.h"
 
 
-void renderMesh(GpuData* buffer,TransformComponent* transformComponent,Camera* camera,MaterialComponent* material);
+void renderMesh(GpuData* buffer,TransformComponent* transformComponent,Camera* camera,MaterialComponent* materialComponent);
 
 void setupMaterial(GpuData* buffer,const char* vertexPath,const char* fragmentPath);
 void setupMesh(Vertex* vertices, int vertexCount, unsigned int* indices, int indexCount, GpuData* buffer);
-GLuint setupTexture(TextureData textureData);
+void setupPackedMesh(const PackedMesh* mesh, GpuData* buffer);
+PackedMesh packMesh(const Vertex* vertices, int vertexCount, const unsigned int* indices, int indexCount, VertexLayout layout);
+void freePackedMesh(PackedMesh* mesh);
+void meshBounds(const Vertex* vertices, int vertexCount, BoundingBox* bounds, float* texcoordExtent);
+void packedMeshBounds(const PackedMesh* mesh, BoundingBox* bounds, float* texcoordExtent);
+GLsizei vertexLayoutStride(const VertexLayout* layout);
+bool indicesInRange(const void* indices, GLenum indexType, uint64_t indexCount, uint64_t vertexCount);
+GLuint setupTexture(TextureData textureData, TextureParams params);
+bool uploadTexture(GLuint texture, TextureData textureData, TextureColorSpace colorSpace);
+bool glExtensionSupported(const char* name);
+bool compressedTexturesSupported();
+GLenum compressedTextureFormat(const CompressedTexture* compressed, TextureColorSpace colorSpace);
+bool uploadCompressedTexture(GLuint texture, const CompressedTexture* compressed, GLenum format, int baseLevel);
+void uploadCompressedLevel(GLuint texture, const CompressedTexture* compressed, GLenum format, int level);
+void evictCompressedLevel(GLuint texture, GLenum format, int level);
+GLuint setupPlaceholderTexture(TextureParams params);
 
 void setupFontTextures(char* fontPath,int fontSize);
 void setupFontMesh(GpuData *buffer);
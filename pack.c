@@ -0,0 +1,253 @@
+#include "pack.h"
+#include "utils.h"
+#include "loader.h"
+
+// The open pack, read only until pack_close.
+static MappedFile mapping = {0};
+static const PackHeader* header = NULL;
+static const PackEntry* directory = NULL;
+static const char* names = NULL;
+
+static uint64_t pack_align(uint64_t offset){
+    return (offset + PACK_ALIGNMENT - 1) & ~(uint64_t)(PACK_ALIGNMENT - 1);
+}
+
+static void pack_writePadding(FILE* fp, uint64_t from, uint64_t to){
+    static const char zeros[PACK_ALIGNMENT] = {0};
+    if(to > from){
+        fwrite(zeros, 1, (size_t)(to - from), fp);
+    }
+}
+
+/**
+ * @brief Check the header & that every entry lies inside the file, so lookups never read past the mapping.
+ */
+static bool pack_validate(const MappedFile* file){
+    if(file->size < sizeof(PackHeader)){
+        return false;
+    }
+    const PackHeader* h = (const PackHeader*)file->data;
+    if(memcmp(h->magic, PACK_MAGIC, 4) != 0 || h->version != PACK_VERSION || h->headerSize != sizeof(PackHeader) || h->entrySize != sizeof(PackEntry)){
+        return false;
+    }
+    if(h->fileSize != file->size || h->slotCount == 0 || (h->slotCount & (h->slotCount - 1)) != 0 || h->entryCount >= h->slotCount){
+        return false;
+    }
+    if(h->directoryOffset % sizeof(uint64_t) != 0 || h->directoryOffset + (uint64_t)h->slotCount * sizeof(PackEntry) > file->size || h->namesOffset + h->namesSize > file->size){
+        return false;
+    }
+    const PackEntry* entries = (const PackEntry*)((const char*)file->data + h->directoryOffset);
+    for(uint32_t i = 0; i < h->slotCount; i++){
+        if(entries[i].nameLength == 0){
+            continue;
+        }
+        if((uint64_t)entries[i].nameOffset + entries[i].nameLength > h->namesSize || entries[i].size >= file->size || entries[i].offset > file->size - entries[i].size - 1){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Map a pack, later pack_find calls look in it. Replaces the open one.
+ * @return false if the file is missing or not a pack from this build.
+ */
+bool pack_open(const char* path){
+    pack_close();
+    MappedFile file;
+    if(!mapFile(path, &file)){
+        return false;
+    }
+    if(!pack_validate(&file)){
+        printf(TEXT_COLOR_WARNING "Asset pack %s is broken or from another build, using loose files\n" TEXT_COLOR_RESET, path);
+        unmapFile(&file);
+        return false;
+    }
+    mapping = file;
+    header = (const PackHeader*)mapping.data;
+    directory = (const PackEntry*)((const char*)mapping.data + header->directoryOffset);
+    names = (const char*)mapping.data + header->namesOffset;
+    printf("Asset pack: %s, %u files, %.2f MB\n", path, header->entryCount, header->fileSize / (1024.0 * 1024.0));
+    return true;
+}
+
+/**
+ * @brief Look up a file in the open pack.
+ * @param view set to the file's bytes inside the mapping, followed by a 0 byte.
+ * @return false when no pack is open or it doesn't hold path.
+ */
+bool pack_find(const char* path, PackView* view){
+    if(header == NULL || path == NULL){
+        return false;
+    }
+    char canonical[LOADER_MAX_PATH];
+    canonicalPath(path, canonical, sizeof(canonical));
+    size_t length = strlen(canonical);
+    uint64_t hash = hashBytes(HASH_SEED, canonical, length);
+    uint32_t mask = header->slotCount - 1;
+    for(uint32_t slot = (uint32_t)hash & mask; directory[slot].nameLength != 0; slot = (slot + 1) & mask){
+        const PackEntry* entry = &directory[slot];
+        if(entry->hash == hash && entry->nameLength == length && memcmp(names + entry->nameOffset, canonical, length) == 0){
+            view->data = (const char*)mapping.data + entry->offset;
+            view->size = (size_t)entry->size;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Does pointer point into the open pack, for freeing what may be a view or a loose file copy.
+ */
+bool pack_contains(const void* pointer){
+    const char* p = (const char*)pointer;
+    return header != NULL && p >= (const char*)mapping.data && p < (const char*)mapping.data + mapping.size;
+}
+
+int pack_entryCount(){
+    return header != NULL ? (int)header->entryCount : 0;
+}
+
+/**
+ * @brief Unmap the pack, views from pack_find are invalid after this.
+ */
+void pack_close(){
+    if(header == NULL){
+        return;
+    }
+    unmapFile(&mapping);
+    header = NULL;
+    directory = NULL;
+    names = NULL;
+}
+
+/**
+ * @brief Write a pack of files, each stored under the canonical form of its path as given.
+ * Files are read one at a time while writing, nothing else is kept in memory. Used by tools/assetpack.c.
+ * @return false if a file can't be read or the pack can't be written, no pack is left behind then.
+ */
+bool pack_build(const char* outPath, const char* const* paths, int count){
+    uint32_t slotCount = PACK_MIN_SLOTS;
+    while(slotCount < (uint32_t)count * 2){
+        slotCount *= 2; // at most half full, probe runs stay short
+    }
+    PackEntry* entries = (PackEntry*)calloc(slotCount, sizeof(PackEntry));
+    int* slotOf = (int*)malloc((count > 0 ? count : 1) * sizeof(int)); // input order -> slot
+    char* nameData = NULL;
+    uint64_t namesSize = 0;
+    if(entries == NULL || slotOf == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate pack directory of %d files\n" TEXT_COLOR_RESET, count);
+        exit(1);
+    }
+
+    // Directory & payload offsets first, the file is then written front to back.
+    PackHeader packHeader = {0};
+    memcpy(packHeader.magic, PACK_MAGIC, 4);
+    packHeader.version = PACK_VERSION;
+    packHeader.headerSize = sizeof(PackHeader);
+    packHeader.entrySize = sizeof(PackEntry);
+    packHeader.slotCount = slotCount;
+    packHeader.directoryOffset = sizeof(PackHeader);
+    packHeader.namesOffset = packHeader.directoryOffset + (uint64_t)slotCount * sizeof(PackEntry);
+    bool success = true;
+    for(int i = 0; i < count && success; i++){
+        char canonical[LOADER_MAX_PATH];
+        canonicalPath(paths[i], canonical, sizeof(canonical));
+        size_t length = strlen(canonical);
+        uint64_t hash = hashBytes(HASH_SEED, canonical, length);
+        uint64_t size;
+        int64_t modified;
+        if(length == 0 || !getFileInfo(paths[i], &size, &modified)){
+            printf(TEXT_COLOR_ERROR "Can't pack %s, no such file\n" TEXT_COLOR_RESET, paths[i]);
+            success = false;
+            break;
+        }
+        uint32_t slot = (uint32_t)hash & (slotCount - 1);
+        while(entries[slot].nameLength != 0){
+            if(entries[slot].hash == hash && entries[slot].nameLength == length && memcmp(nameData + entries[slot].nameOffset, canonical, length) == 0){
+                break;
+            }
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        if(entries[slot].nameLength != 0){
+            printf(TEXT_COLOR_WARNING "%s is listed twice, packed once\n" TEXT_COLOR_RESET, canonical);
+            slotOf[i] = -1;
+            continue;
+        }
+        char* grown = (char*)realloc(nameData, (size_t)(namesSize + length));
+        if(grown == NULL){
+            printf(TEXT_COLOR_ERROR "Failed to allocate pack names\n" TEXT_COLOR_RESET);
+            exit(1);
+        }
+        nameData = grown;
+        memcpy(nameData + namesSize, canonical, length);
+        entries[slot].hash = hash;
+        entries[slot].size = size;
+        entries[slot].nameOffset = (uint32_t)namesSize;
+        entries[slot].nameLength = (uint32_t)length;
+        namesSize += length;
+        slotOf[i] = (int)slot;
+        packHeader.entryCount++;
+    }
+    packHeader.namesSize = namesSize;
+    uint64_t cursor = packHeader.namesOffset + namesSize;
+    for(int i = 0; i < count && success; i++){
+        if(slotOf[i] < 0){
+            continue;
+        }
+        PackEntry* entry = &entries[slotOf[i]];
+        entry->offset = pack_align(cursor);
+        cursor = entry->offset + entry->size + 1; // + the 0 byte
+    }
+    packHeader.fileSize = cursor;
+
+    FILE* fp = success ? fopen(outPath, "wb") : NULL;
+    if(success && fp == NULL){
+        printf(TEXT_COLOR_ERROR "Could not write asset pack %s\n" TEXT_COLOR_RESET, outPath);
+        success = false;
+    }
+    if(success){
+        fwrite(&packHeader, sizeof(PackHeader), 1, fp);
+        fwrite(entries, sizeof(PackEntry), slotCount, fp);
+        if(namesSize > 0){
+            fwrite(nameData, 1, (size_t)namesSize, fp);
+        }
+        cursor = packHeader.namesOffset + namesSize;
+        for(int i = 0; i < count && success; i++){
+            if(slotOf[i] < 0){
+                continue;
+            }
+            PackEntry* entry = &entries[slotOf[i]];
+            pack_writePadding(fp, cursor, entry->offset);
+            if(entry->size > 0){
+                // Mapped & written straight back, a file changing size since the directory was made fails the pack.
+                MappedFile file;
+                bool mapped = mapFile(paths[i], &file);
+                if(!mapped || file.size != entry->size){
+                    printf(TEXT_COLOR_ERROR "Can't read %s or it changed while packing\n" TEXT_COLOR_RESET, paths[i]);
+                    if(mapped){
+                        unmapFile(&file);
+                    }
+                    success = false;
+                    break;
+                }
+                fwrite(file.data, 1, file.size, fp);
+                unmapFile(&file);
+            }
+            fputc(0, fp);
+            cursor = entry->offset + entry->size + 1;
+        }
+        success = success && ferror(fp) == 0;
+        fclose(fp);
+        if(success){
+            printf("Asset pack saved: %s, %u files, %.2f MB\n", outPath, packHeader.entryCount, packHeader.fileSize / (1024.0 * 1024.0));
+        }else {
+            printf(TEXT_COLOR_ERROR "Failed writing asset pack %s\n" TEXT_COLOR_RESET, outPath);
+            remove(outPath);
+        }
+    }
+    free(nameData);
+    free(slotOf);
+    free(entries);
+    return success;
+}
@@ -0,0 +1,66 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "types.h"
+
+/**
+ * Asset pack
+ * Many asset files in one file, built offline by tools/assetpack.c and mapped once at startup. Lookups hash the
+ * canonical path (see canonicalPath, "./Assets/a.png" and "Assets/a.png" are the same entry) into a directory
+ * of entries and return a view straight into the mapping, nothing is read or copied.
+ * readFile, loadImage, the obj & mtl readers, compressed textures (.ktx) and the font go through pack_find
+ * first and fall back to the loose file when the pack doesn't have it, so a pack can hold any subset of assets.
+ *
+ * Layout: header | directory | names | payloads
+ * - directory: open addressing table of slotCount entries (power of 2, linear probing on the path hash)
+ * - names: the canonical paths, not terminated
+ * - payloads: PACK_ALIGNMENT aligned, each followed by a 0 byte so text files are C strings in place
+ * All offsets are bytes from the start of the file. Written & read on the same platform, no endian swapping.
+ * The pack is read only once open, lookups are safe from the loader's job threads.
+ */
+
+#define PACK_MAGIC "FHPK"
+#define PACK_VERSION 1
+#define PACK_EXTENSION ".fhpack"
+#define PACK_DEFAULT_PATH "./assets" PACK_EXTENSION // opened at startup when it exists, --pack picks another
+#define PACK_ALIGNMENT 64 // cache line, more than any reader needs
+#define PACK_MIN_SLOTS 16
+
+typedef struct PackHeader {
+    char magic[4];
+    uint32_t version;
+    // Struct sizes at write time, a mismatch means the file came from another build.
+    uint32_t headerSize;
+    uint32_t entrySize;
+    uint32_t entryCount;
+    uint32_t slotCount;
+    uint64_t directoryOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+    uint64_t fileSize;
+} PackHeader;
+
+typedef struct PackEntry {
+    uint64_t hash;          // FNV-1a 64 of the canonical path
+    uint64_t offset;
+    uint64_t size;          // payload bytes, without the 0 after it
+    uint32_t nameOffset;    // in names
+    uint32_t nameLength;    // 0 marks an empty slot
+} PackEntry;
+
+// Bytes of one packed file, valid until pack_close.
+typedef struct PackView {
+    const void* data;
+    size_t size;
+} PackView;
+
+bool pack_open(const char* path);
+bool pack_find(const char* path, PackView* view);
+bool pack_contains(const void* pointer);
+int pack_entryCount();
+void pack_close();
+bool pack_build(const char* outPath, const char* const* paths, int count);
+
+#endif
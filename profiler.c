@@ -0,0 +1,248 @@
+#include "profiler.h"
+#include "utils.h"
+#include "globals.h"
+#include "jobs.h"
+#include <math.h>
+
+// One ring per job system thread, index 0 is the main thread.
+static ProfilerThread* threads = NULL;
+static ProfilerZoneStats zones[PROFILER_MAX_ZONES];
+static int zoneCount = 0;
+static int statsFrameCount = 0;
+static uint64_t startCounter = 0;
+static uint64_t frequency = 1;
+
+void profiler_init(){
+    threads = calloc(JOBS_MAX_WORKERS + 1, sizeof(ProfilerThread));
+    if(threads == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate profiler threads\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    for(int i = 0; i < JOBS_MAX_WORKERS + 1; i++){
+        threads[i].events = malloc(PROFILER_RING_SIZE * sizeof(ProfilerEvent));
+        if(threads[i].events == NULL){
+            printf(TEXT_COLOR_ERROR "Failed to allocate profiler ring\n" TEXT_COLOR_RESET);
+            exit(1);
+        }
+        SDL_AtomicSet(&threads[i].writeIndex, 0);
+    }
+    startCounter = SDL_GetPerformanceCounter();
+    frequency = SDL_GetPerformanceFrequency();
+}
+
+void profiler_shutdown(){
+    if(threads == NULL){
+        return;
+    }
+    for(int i = 0; i < JOBS_MAX_WORKERS + 1; i++){
+        free(threads[i].events);
+    }
+    free(threads);
+    threads = NULL;
+}
+
+/**
+ * @brief Nanoseconds since profiler_init.
+ */
+uint64_t profiler_now(){
+    uint64_t ticks = SDL_GetPerformanceCounter() - startCounter;
+    // Split so ticks * 1e9 can't overflow.
+    return (ticks / frequency) * 1000000000ull + (ticks % frequency) * 1000000000ull / frequency;
+}
+
+void profiler_begin(const char* name){
+    if(threads == NULL){
+        return;
+    }
+    ProfilerThread* thread = &threads[jobs_threadIndex()];
+    ASSERT(thread->depth < PROFILER_MAX_DEPTH, "Profiler zones nested too deep");
+    if(thread->depth >= PROFILER_MAX_DEPTH){
+        thread->depth++; // keep begin/end balanced, zone is dropped
+        return;
+    }
+    thread->openNames[thread->depth] = name;
+    thread->openStarts[thread->depth] = profiler_now();
+    thread->depth++;
+}
+
+void profiler_end(){
+    if(threads == NULL){
+        return;
+    }
+    uint64_t end = profiler_now();
+    ProfilerThread* thread = &threads[jobs_threadIndex()];
+    ASSERT(thread->depth > 0, "PROFILE_END without PROFILE_BEGIN");
+    if(thread->depth <= 0){
+        return;
+    }
+    thread->depth--;
+    if(thread->depth >= PROFILER_MAX_DEPTH){
+        return;
+    }
+
+    // Only this thread writes the ring. Publish the index after the event so readers never see half an event.
+    int writeIndex = SDL_AtomicGet(&thread->writeIndex);
+    ProfilerEvent* event = &thread->events[writeIndex & (PROFILER_RING_SIZE - 1)];
+    event->name = thread->openNames[thread->depth];
+    event->start = thread->openStarts[thread->depth];
+    event->end = end;
+    event->depth = thread->depth;
+    SDL_AtomicSet(&thread->writeIndex, writeIndex + 1);
+}
+
+static ProfilerZoneStats* profiler_findZone(const char* name){
+    for(int i = 0; i < zoneCount; i++){
+        if(zones[i].name == name || strcmp(zones[i].name, name) == 0){
+            return &zones[i];
+        }
+    }
+    if(zoneCount == PROFILER_MAX_ZONES){
+        return NULL;
+    }
+    ProfilerZoneStats* zone = &zones[zoneCount++];
+    memset(zone, 0, sizeof(ProfilerZoneStats));
+    zone->name = name;
+    return zone;
+}
+
+/**
+ * @brief Fold zones recorded since last call into the rolling stats. Call once per frame from the main thread
+ * while no jobs are running.
+ */
+void profiler_frameEnd(){
+    if(threads == NULL){
+        return;
+    }
+    for(int t = 0; t < JOBS_MAX_WORKERS + 1; t++){
+        ProfilerThread* thread = &threads[t];
+        int writeIndex = SDL_AtomicGet(&thread->writeIndex);
+        if(writeIndex - thread->readIndex > PROFILER_RING_SIZE){
+            thread->readIndex = writeIndex - PROFILER_RING_SIZE; // ring wrapped, oldest events are gone
+        }
+        for(int i = thread->readIndex; i < writeIndex; i++){
+            ProfilerEvent* event = &thread->events[i & (PROFILER_RING_SIZE - 1)];
+            ProfilerZoneStats* zone = profiler_findZone(event->name);
+            if(zone != NULL){
+                zone->frameTotal += event->end - event->start;
+            }
+        }
+        thread->readIndex = writeIndex;
+    }
+
+    int slot = statsFrameCount % PROFILER_STATS_FRAMES;
+    for(int i = 0; i < zoneCount; i++){
+        zones[i].history[slot] = zones[i].frameTotal;
+        zones[i].frameTotal = 0;
+    }
+    statsFrameCount++;
+}
+
+static void profiler_rollingStats(ProfilerZoneStats* zone, int frames, uint64_t* min, double* avg, uint64_t* max){
+    uint64_t total = 0;
+    *min = UINT64_MAX;
+    *max = 0;
+    for(int f = 0; f < frames; f++){
+        uint64_t value = zone->history[f];
+        *min = value < *min ? value : *min;
+        *max = value > *max ? value : *max;
+        total += value;
+    }
+    *avg = total / (double)frames;
+}
+
+/**
+ * @brief Rolling average ns per frame spent in zone, 0 if the zone hasn't been recorded.
+ */
+double profiler_zoneAverage(const char* name){
+    int frames = statsFrameCount < PROFILER_STATS_FRAMES ? statsFrameCount : PROFILER_STATS_FRAMES;
+    for(int i = 0; i < zoneCount && frames > 0; i++){
+        if(strcmp(zones[i].name, name) == 0){
+            uint64_t min, max;
+            double avg;
+            profiler_rollingStats(&zones[i], frames, &min, &avg, &max);
+            return avg;
+        }
+    }
+    return 0.0;
+}
+
+/**
+ * @brief Print min/avg/max ms per zone over the last PROFILER_STATS_FRAMES frames.
+ */
+void profiler_printStats(){
+    int frames = statsFrameCount < PROFILER_STATS_FRAMES ? statsFrameCount : PROFILER_STATS_FRAMES;
+    if(frames == 0){
+        return;
+    }
+    printf("------------------------------------\n");
+    printf("Profiler, last %d frames (ms)\n", frames);
+    printf("%-28s %9s %9s %9s\n", "zone", "min", "avg", "max");
+    for(int i = 0; i < zoneCount; i++){
+        uint64_t min, max;
+        double avg;
+        profiler_rollingStats(&zones[i], frames, &min, &avg, &max);
+        printf("%-28s %9.3f %9.3f %9.3f\n", zones[i].name, min / 1e6, avg / 1e6, max / 1e6);
+    }
+    printf("------------------------------------\n");
+}
+
+/**
+ * @brief Write every event still in the rings as Chrome trace event json (open in chrome://tracing or ui.perfetto.dev).
+ */
+bool profiler_dumpTrace(const char* path){
+    if(threads == NULL){
+        return false;
+    }
+    FILE* fp = fopen(path, "w");
+    if(fp == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to open profiler trace file %s\n" TEXT_COLOR_RESET, path);
+        return false;
+    }
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    int eventCount = 0;
+    for(int t = 0; t < JOBS_MAX_WORKERS + 1; t++){
+        ProfilerThread* thread = &threads[t];
+        int writeIndex = SDL_AtomicGet(&thread->writeIndex);
+        if(writeIndex == 0){
+            continue;
+        }
+        fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+            first ? "" : ",\n", t, t == 0 ? "Main" : "JobWorker", t);
+        first = false;
+        int begin = writeIndex > PROFILER_RING_SIZE ? writeIndex - PROFILER_RING_SIZE : 0;
+        for(int i = begin; i < writeIndex; i++){
+            ProfilerEvent* event = &thread->events[i & (PROFILER_RING_SIZE - 1)];
+            // Timestamps are in microseconds, three decimals keep the nanoseconds.
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                event->name, t, event->start / 1000.0, (event->end - event->start) / 1000.0);
+            eventCount++;
+        }
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    printf("Profiler trace written to %s (%d events)\n", path, eventCount);
+    return true;
+}
+
+static int profiler_compareSamples(const void* a, const void* b){
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Sort timing samples ascending, for profiler_percentile.
+ */
+void profiler_sortSamples(uint64_t* samples, int count){
+    qsort(samples, count, sizeof(uint64_t), profiler_compareSamples);
+}
+
+/**
+ * @brief Nearest rank percentile of sorted samples, shared by the headless stats & the benchmark.
+ */
+uint64_t profiler_percentile(const uint64_t* sorted, int count, double p){
+    int rank = (int)ceil(p / 100.0 * count);
+    rank = rank < 1 ? 1 : rank;
+    return sorted[rank - 1];
+}
@@ -0,0 +1,65 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <SDL2/SDL.h>
+
+/**
+ * Frame profiler.
+ * PROFILE_BEGIN("name") / PROFILE_END() pairs record nanosecond zones into a ring buffer owned by the calling
+ * thread (job system thread index), so recording takes no locks. Zone names must be string literals or
+ * otherwise outlive the profiler.
+ * profiler_frameEnd folds the zones of the finished frame into rolling per-zone min/avg/max (over
+ * PROFILER_STATS_FRAMES frames) and profiler_dumpTrace writes the rings as chrome://tracing / Perfetto json.
+ * Build with -DPROFILER_DISABLED to compile the zones out.
+ */
+
+#define PROFILER_RING_SIZE 65536 // events per thread, power of two
+#define PROFILER_MAX_DEPTH 32
+#define PROFILER_MAX_ZONES 128
+#define PROFILER_STATS_FRAMES 120
+
+typedef struct ProfilerEvent {
+    const char* name;
+    uint64_t start; // ns since profiler_init
+    uint64_t end;
+    int depth;
+} ProfilerEvent;
+
+typedef struct ProfilerThread {
+    ProfilerEvent* events;
+    SDL_atomic_t writeIndex; // total events written, published after the event is complete
+    int readIndex;           // first event not yet folded into the stats, main thread only
+    const char* openNames[PROFILER_MAX_DEPTH];
+    uint64_t openStarts[PROFILER_MAX_DEPTH];
+    int depth;
+} ProfilerThread;
+
+typedef struct ProfilerZoneStats {
+    const char* name;
+    uint64_t frameTotal;                      // ns spent in zone during the current frame
+    uint64_t history[PROFILER_STATS_FRAMES];  // ns per frame
+    int calls;
+} ProfilerZoneStats;
+
+void profiler_init();
+void profiler_shutdown();
+uint64_t profiler_now();
+void profiler_begin(const char* name);
+void profiler_end();
+void profiler_frameEnd();
+void profiler_printStats();
+double profiler_zoneAverage(const char* name);
+bool profiler_dumpTrace(const char* path);
+void profiler_sortSamples(uint64_t* samples, int count);
+uint64_t profiler_percentile(const uint64_t* sorted, int count, double p);
+
+#ifdef PROFILER_DISABLED
+    #define PROFILE_BEGIN(name) ((void)0)
+    #define PROFILE_END() ((void)0)
+#else
+    #define PROFILE_BEGIN(name) profiler_begin(name)
+    #define PROFILE_END() profiler_end()
+#endif
+
+#endif
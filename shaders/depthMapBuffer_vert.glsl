@@ -5,9 +5,11 @@ layout (location = 0) in vec3 aPos;
 uniform mat4 lightSpaceMatrix;
 
 uniform mat4 model;
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
 
 void main()
 {
-	gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+	gl_Position = lightSpaceMatrix * model * vec4(positionOffset + aPos * positionScale, 1.0);
 }
 
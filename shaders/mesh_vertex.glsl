@@ -15,13 +15,27 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 uniform mat4 lightSpaceMatrix[9];
+uniform vec3 positionScale; // quantized meshes store positions as unorm16 inside their bounds
+uniform vec3 positionOffset;
+uniform bool octahedralNormals;
+
+vec3 octDecode(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if(n.z < 0.0){
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(n);
+}
 
 void main()
 {
 	// Convert the vertex position to world coordinates
-	FragPos = vec3(model * vec4(aPos, 1.0));
+	vec3 position = positionOffset + aPos * positionScale;
+	FragPos = vec3(model * vec4(position, 1.0));
 	
-	Normal = mat3(transpose(inverse(model))) * aNormal;
+	vec3 normal = octahedralNormals ? octDecode(aNormal.xy) : aNormal;
+	Normal = mat3(transpose(inverse(model))) * normal;
 	TexCoords = vec2(aTexCoord.x, aTexCoord.y);
 	for(int i = 0; i < 9; i++){
 		FragPosLightSpace[i] = lightSpaceMatrix[i] * vec4(FragPos, 1.0);
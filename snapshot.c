@@ -0,0 +1,557 @@
+#include "snapshot.h"
+#include "utils.h"
+#include "globals.h"
+#include "opengl.h"
+#include "ecs.h"
+#include "ecs-entity.h"
+#include "transform.h"
+#include "api.h"
+#include "texcache.h"
+#include "pack.h"
+
+// Loaded meshes & material names point into this, kept until snapshot_unload.
+static MappedFile mapping = {0};
+static PackedMesh* packedMeshes = NULL; // of loaded packed meshes, pointing into the mapping
+static GLuint* textures = NULL;         // texture cache references taken by the loaded materials
+static int textureCount = 0;
+
+static uint64_t snapshot_align(uint64_t offset){
+    return (offset + SNAPSHOT_BLOB_ALIGNMENT - 1) & ~(uint64_t)(SNAPSHOT_BLOB_ALIGNMENT - 1);
+}
+
+static void snapshot_writePadding(FILE* fp, uint64_t from, uint64_t to){
+    static const char zeros[SNAPSHOT_BLOB_ALIGNMENT] = {0};
+    if(to > from){
+        fwrite(zeros, 1, (size_t)(to - from), fp);
+    }
+}
+
+static size_t snapshot_indexSize(uint32_t indexType){
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+}
+
+static uint64_t snapshot_addString(char* strings, uint64_t* stringsSize, const char* string){
+    if(string == NULL){
+        return SNAPSHOT_NO_STRING;
+    }
+    uint64_t offset = *stringsSize;
+    size_t length = strlen(string) + 1;
+    if(strings != NULL){
+        memcpy(strings + offset, string, length);
+    }
+    *stringsSize += length;
+    return offset;
+}
+
+/**
+ * @brief Stamp of a file the scene is built from. The asset pack copy wins over the loose file, like in the readers,
+ * it has no time so it is stamped by size & hash.
+ */
+static bool snapshot_stampSource(const char* sourcePath, SourceStamp* stamp){
+    PackView view;
+    if(pack_find(sourcePath, &view)){
+        stamp->size = view.size;
+        stamp->modified = 0;
+        stamp->hash = hashBytes(HASH_SEED, view.data, view.size);
+        return true;
+    }
+    return getSourceStamp(sourcePath, stamp);
+}
+
+/**
+ * @param stampOffset of source->stamp in the snapshot file, see sourceStampMatches.
+ */
+static bool snapshot_sourceMatches(const char* path, const SnapshotSource* source, const char* sourcePath, long stampOffset){
+    PackView view;
+    if(pack_find(sourcePath, &view)){
+        return source->stamp.size == view.size && source->stamp.hash == hashBytes(HASH_SEED, view.data, view.size);
+    }
+    return sourceStampMatches(sourcePath, &source->stamp, path, stampOffset);
+}
+
+bool snapshot_save(const char* path, const char* const* sources, int sourceCount, Entity** roots, int rootCount){
+    SnapshotSource* snapshotSources = (SnapshotSource*)calloc(sourceCount + 1, sizeof(SnapshotSource));
+    if(snapshotSources == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate memory for scene snapshot\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    for(int i = 0; i < sourceCount; i++){
+        if(!snapshot_stampSource(sources[i], &snapshotSources[i].stamp)){
+            printf(TEXT_COLOR_WARNING "Scene snapshot %s not written, could not read its source %s\n" TEXT_COLOR_RESET, path, sources[i]);
+            free(snapshotSources);
+            return false;
+        }
+    }
+
+    int* order = (int*)malloc(MAX_ENTITIES * sizeof(int));
+    int* snapshotIndex = (int*)malloc(MAX_ENTITIES * sizeof(int));
+    int* materialRemap = (int*)malloc((globals.materialsCount + 1) * sizeof(int));
+    int* materialOrder = (int*)malloc((globals.materialsCount + 1) * sizeof(int));
+    if(order == NULL || snapshotIndex == NULL || materialRemap == NULL || materialOrder == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate memory for scene snapshot\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    for(int i = 0; i < MAX_ENTITIES; i++){
+        snapshotIndex[i] = -1;
+    }
+    for(int i = 0; i < globals.materialsCount; i++){
+        materialRemap[i] = -1;
+    }
+
+    // Roots first, then breadth first through the hierarchy so a parent is always created before its children.
+    int entityCount = 0;
+    for(int i = 0; i < rootCount; i++){
+        if(roots[i] != NULL && snapshotIndex[roots[i]->id] == -1){
+            snapshotIndex[roots[i]->id] = entityCount;
+            order[entityCount++] = roots[i]->id;
+        }
+    }
+    for(int i = 0; i < entityCount; i++){
+        int child = globals.entities[order[i]].groupComponent->firstChild;
+        while(child != -1){
+            if(snapshotIndex[child] == -1){
+                snapshotIndex[child] = entityCount;
+                order[entityCount++] = child;
+            }
+            child = globals.entities[child].groupComponent->nextSibling;
+        }
+    }
+    int materialCount = 0;
+    for(int i = 0; i < entityCount; i++){
+        MaterialComponent* materialComponent = globals.entities[order[i]].materialComponent;
+        int index = materialComponent->materialIndex;
+        if(materialComponent->active && index >= 0 && index < globals.materialsCount && materialRemap[index] == -1){
+            materialRemap[index] = materialCount;
+            materialOrder[materialCount++] = index;
+        }
+    }
+
+    // Size the string table, then fill it.
+    uint64_t stringsSize = 0;
+    for(int i = 0; i < sourceCount; i++){
+        snapshot_addString(NULL, &stringsSize, sources[i]);
+    }
+    for(int i = 0; i < materialCount; i++){
+        Material* material = &globals.materials[materialOrder[i]];
+        snapshot_addString(NULL, &stringsSize, material->name);
+        for(int map = 0; map < MATERIAL_MAP_COUNT; map++){
+            snapshot_addString(NULL, &stringsSize, material->mapPaths[map]);
+        }
+    }
+    char* strings = (char*)malloc(stringsSize + 1);
+    SnapshotEntity* snapshotEntities = (SnapshotEntity*)calloc(entityCount + 1, sizeof(SnapshotEntity));
+    SnapshotMaterial* snapshotMaterials = (SnapshotMaterial*)calloc(materialCount + 1, sizeof(SnapshotMaterial));
+    if(strings == NULL || snapshotEntities == NULL || snapshotMaterials == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate memory for scene snapshot\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+
+    stringsSize = 0;
+    for(int i = 0; i < sourceCount; i++){
+        snapshotSources[i].pathOffset = snapshot_addString(strings, &stringsSize, sources[i]);
+    }
+    for(int i = 0; i < materialCount; i++){
+        Material* material = &globals.materials[materialOrder[i]];
+        SnapshotMaterial* out = &snapshotMaterials[i];
+        out->ambient = material->ambient;
+        out->diffuse = material->diffuse;
+        out->specular = material->specular;
+        out->emissive = material->emissive;
+        out->shininess = material->shininess;
+        out->transparency = material->transparency;
+        out->diffuseMapOpacity = material->diffuseMapOpacity;
+        out->ior = material->ior;
+        out->materialFlags = material->material_flags;
+        out->isPostProcessMaterial = material->isPostProcessMaterial;
+        out->nameOffset = snapshot_addString(strings, &stringsSize, material->name);
+        for(int map = 0; map < MATERIAL_MAP_COUNT; map++){
+            out->mapPathOffsets[map] = snapshot_addString(strings, &stringsSize, material->mapPaths[map]);
+        }
+    }
+
+    SnapshotHeader header = {0};
+    memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+    header.version = SNAPSHOT_VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.entitySize = sizeof(SnapshotEntity);
+    header.materialSize = sizeof(SnapshotMaterial);
+    header.entityCount = entityCount;
+    header.materialCount = materialCount;
+    header.sourceCount = sourceCount;
+    header.sourcesOffset = sizeof(SnapshotHeader);
+    header.entitiesOffset = header.sourcesOffset + sourceCount * sizeof(SnapshotSource);
+    header.materialsOffset = header.entitiesOffset + entityCount * sizeof(SnapshotEntity);
+    header.stringsOffset = header.materialsOffset + materialCount * sizeof(SnapshotMaterial);
+    header.stringsSize = stringsSize;
+    header.blobsOffset = snapshot_align(header.stringsOffset + stringsSize);
+
+    uint64_t blobCursor = header.blobsOffset;
+    for(int i = 0; i < entityCount; i++){
+        Entity* entity = &globals.entities[order[i]];
+        SnapshotEntity* out = &snapshotEntities[i];
+        out->tag = entity->tag;
+        out->parent = entity->groupComponent->parent == -1 ? -1 : snapshotIndex[entity->groupComponent->parent];
+        out->materialIndex = -1;
+        out->flags = entity->visible ? SNAPSHOT_ENTITY_VISIBLE : 0;
+        memcpy(out->position, entity->transformComponent->position, sizeof(out->position));
+        memcpy(out->rotation, entity->transformComponent->rotation, sizeof(out->rotation));
+        memcpy(out->scale, entity->transformComponent->scale, sizeof(out->scale));
+
+        MaterialComponent* materialComponent = entity->materialComponent;
+        if(materialComponent->active){
+            out->flags |= SNAPSHOT_ENTITY_MATERIAL;
+            int index = materialComponent->materialIndex;
+            out->materialIndex = (index >= 0 && index < globals.materialsCount) ? materialRemap[index] : -1;
+            // The shared material's values, so the entity still reads alone. Diffuse & opacity are its tint.
+            Material* material = getEntityMaterial(entity);
+            if(material != NULL){
+                out->ambient = material->ambient;
+                out->specular = material->specular;
+                out->shininess = material->shininess;
+                out->materialFlags = material->material_flags;
+            }
+            out->diffuse = materialComponent->diffuse;
+            out->diffuseMapOpacity = materialComponent->diffuseMapOpacity;
+        }
+
+        MeshComponent* meshComponent = entity->meshComponent;
+        const PackedMesh* packed = meshComponent->vertices == NULL ? meshComponent->packedMesh : NULL;
+        if(meshComponent->active && (meshComponent->vertices != NULL || packed != NULL)){
+            out->flags |= SNAPSHOT_ENTITY_MESH;
+            if(meshComponent->drawIndexed){
+                out->flags |= SNAPSHOT_ENTITY_DRAW_INDEXED;
+            }
+            out->drawMode = meshComponent->gpuData->drawMode;
+            VertexLayout* layout = &meshComponent->gpuData->vertexLayout;
+            out->positionFormat = (uint8_t)layout->position;
+            out->uvFormat = (uint8_t)layout->uv;
+            out->normalFormat = (uint8_t)layout->normal;
+            out->dropColor = layout->dropColor;
+            if(packed != NULL){
+                // From the mesh cache, only the gpu layout exists. Stored as it is.
+                out->flags |= SNAPSHOT_ENTITY_PACKED;
+                out->stride = (uint32_t)packed->stride;
+                out->indexType = packed->indexType;
+                memcpy(out->positionScale, packed->positionScale, sizeof(out->positionScale));
+                memcpy(out->positionOffset, packed->positionOffset, sizeof(out->positionOffset));
+                out->vertexCount = (uint64_t)packed->vertexCount;
+                out->verticesOffset = snapshot_align(blobCursor);
+                blobCursor = out->verticesOffset + out->vertexCount * out->stride;
+                if(packed->indexCount > 0){
+                    out->indexCount = (uint64_t)packed->indexCount;
+                    out->indicesOffset = snapshot_align(blobCursor);
+                    blobCursor = out->indicesOffset + out->indexCount * snapshot_indexSize(out->indexType);
+                }
+            }else {
+                out->vertexCount = meshComponent->vertexCount;
+                out->verticesOffset = snapshot_align(blobCursor);
+                blobCursor = out->verticesOffset + meshComponent->vertexCount * sizeof(Vertex);
+                if(meshComponent->indexCount > 0 && meshComponent->indices != NULL){
+                    out->indexCount = meshComponent->indexCount;
+                    out->indexType = GL_UNSIGNED_INT;
+                    out->indicesOffset = snapshot_align(blobCursor);
+                    blobCursor = out->indicesOffset + meshComponent->indexCount * sizeof(unsigned int);
+                }
+            }
+        }
+    }
+    header.blobsSize = blobCursor - header.blobsOffset;
+    header.fileSize = blobCursor;
+
+    bool success = false;
+    FILE* fp = fopen(path, "wb");
+    if(fp == NULL){
+        printf(TEXT_COLOR_WARNING "Could not write scene snapshot %s\n" TEXT_COLOR_RESET, path);
+    }else {
+        fwrite(&header, sizeof(SnapshotHeader), 1, fp);
+        fwrite(snapshotSources, sizeof(SnapshotSource), sourceCount, fp);
+        fwrite(snapshotEntities, sizeof(SnapshotEntity), entityCount, fp);
+        fwrite(snapshotMaterials, sizeof(SnapshotMaterial), materialCount, fp);
+        fwrite(strings, 1, stringsSize, fp);
+        uint64_t cursor = header.stringsOffset + stringsSize;
+        for(int i = 0; i < entityCount; i++){
+            SnapshotEntity* out = &snapshotEntities[i];
+            if(!(out->flags & SNAPSHOT_ENTITY_MESH)){
+                continue;
+            }
+            MeshComponent* meshComponent = globals.entities[order[i]].meshComponent;
+            bool isPacked = (out->flags & SNAPSHOT_ENTITY_PACKED) != 0;
+            size_t vertexSize = isPacked ? out->stride : sizeof(Vertex);
+            snapshot_writePadding(fp, cursor, out->verticesOffset);
+            fwrite(isPacked ? meshComponent->packedMesh->vertices : (const void*)meshComponent->vertices, vertexSize, out->vertexCount, fp);
+            cursor = out->verticesOffset + out->vertexCount * vertexSize;
+            if(out->indexCount > 0){
+                size_t indexSize = snapshot_indexSize(out->indexType);
+                snapshot_writePadding(fp, cursor, out->indicesOffset);
+                fwrite(isPacked ? meshComponent->packedMesh->indices : (const void*)meshComponent->indices, indexSize, out->indexCount, fp);
+                cursor = out->indicesOffset + out->indexCount * indexSize;
+            }
+        }
+        success = ferror(fp) == 0;
+        fclose(fp);
+        if(success){
+            printf("Scene snapshot saved: %s, %d entities, %d materials, %.2f MB\n", path, entityCount, materialCount, header.fileSize / (1024.0 * 1024.0));
+        }else {
+            printf(TEXT_COLOR_WARNING "Failed writing scene snapshot %s\n" TEXT_COLOR_RESET, path);
+            remove(path);
+        }
+    }
+
+    free(snapshotSources);
+    free(order);
+    free(snapshotIndex);
+    free(materialRemap);
+    free(materialOrder);
+    free(strings);
+    free(snapshotEntities);
+    free(snapshotMaterials);
+    return success;
+}
+
+void snapshot_unload(){
+    for(int i = 0; i < textureCount; i++){
+        texcache_release(textures[i]);
+    }
+    free(textures);
+    textures = NULL;
+    textureCount = 0;
+    free(packedMeshes);
+    packedMeshes = NULL;
+    if(mapping.data == NULL){
+        return;
+    }
+    unmapFile(&mapping);
+}
+
+static bool snapshot_rangeValid(uint64_t offset, uint64_t size, uint64_t fileSize){
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+static bool snapshot_stringValid(const SnapshotHeader* header, uint64_t offset){
+    return offset == SNAPSHOT_NO_STRING || offset < header->stringsSize;
+}
+
+/**
+ * @brief Check everything the loader is about to dereference, a bad file falls back to a normal scene build.
+ */
+static bool snapshot_validate(const char* data, size_t size){
+    if(size < sizeof(SnapshotHeader)){
+        return false;
+    }
+    const SnapshotHeader* header = (const SnapshotHeader*)data;
+    if(memcmp(header->magic, SNAPSHOT_MAGIC, 4) != 0 || header->version != SNAPSHOT_VERSION){
+        return false;
+    }
+    if(header->vertexSize != sizeof(Vertex) || header->entitySize != sizeof(SnapshotEntity) || header->materialSize != sizeof(SnapshotMaterial)){
+        return false;
+    }
+    if(header->fileSize != size
+        || !snapshot_rangeValid(header->sourcesOffset, (uint64_t)header->sourceCount * sizeof(SnapshotSource), size)
+        || !snapshot_rangeValid(header->entitiesOffset, (uint64_t)header->entityCount * sizeof(SnapshotEntity), size)
+        || !snapshot_rangeValid(header->materialsOffset, (uint64_t)header->materialCount * sizeof(SnapshotMaterial), size)
+        || !snapshot_rangeValid(header->stringsOffset, header->stringsSize, size)
+        || !snapshot_rangeValid(header->blobsOffset, header->blobsSize, size)){
+        return false;
+    }
+    if(header->stringsSize > 0 && data[header->stringsOffset + header->stringsSize - 1] != '\0'){
+        return false;
+    }
+
+    const SnapshotSource* sources = (const SnapshotSource*)(data + header->sourcesOffset);
+    for(uint32_t i = 0; i < header->sourceCount; i++){
+        if(sources[i].pathOffset == SNAPSHOT_NO_STRING || !snapshot_stringValid(header, sources[i].pathOffset)){
+            return false;
+        }
+    }
+
+    const SnapshotMaterial* materials = (const SnapshotMaterial*)(data + header->materialsOffset);
+    for(uint32_t i = 0; i < header->materialCount; i++){
+        if(!snapshot_stringValid(header, materials[i].nameOffset)){
+            return false;
+        }
+        for(int map = 0; map < MATERIAL_MAP_COUNT; map++){
+            if(!snapshot_stringValid(header, materials[i].mapPathOffsets[map])){
+                return false;
+            }
+        }
+    }
+
+    const SnapshotEntity* entities = (const SnapshotEntity*)(data + header->entitiesOffset);
+    for(uint32_t i = 0; i < header->entityCount; i++){
+        const SnapshotEntity* entity = &entities[i];
+        if(entity->parent < -1 || entity->parent >= (int32_t)i || entity->materialIndex < -1 || entity->materialIndex >= (int32_t)header->materialCount){
+            return false;
+        }
+        if(entity->flags & SNAPSHOT_ENTITY_MESH){
+            if(entity->positionFormat > VERTEX_POSITION_UNORM16 || entity->uvFormat > VERTEX_UV_UNORM16 || entity->normalFormat > VERTEX_NORMAL_INT_2_10_10_10){
+                return false;
+            }
+            uint64_t vertexSize = sizeof(Vertex);
+            uint64_t indexSize = sizeof(unsigned int);
+            GLenum indexType = GL_UNSIGNED_INT;
+            if(entity->flags & SNAPSHOT_ENTITY_PACKED){
+                VertexLayout layout = {(VertexPositionFormat)entity->positionFormat, entity->dropColor != 0, (VertexUvFormat)entity->uvFormat, (VertexNormalFormat)entity->normalFormat};
+                if(entity->stride != (uint32_t)vertexLayoutStride(&layout) || (entity->indexType != GL_UNSIGNED_SHORT && entity->indexType != GL_UNSIGNED_INT)
+                    || entity->vertexCount > INT32_MAX || entity->indexCount > INT32_MAX){
+                    return false;
+                }
+                vertexSize = entity->stride;
+                indexSize = snapshot_indexSize(entity->indexType);
+                indexType = entity->indexType;
+            }
+            if(entity->vertexCount > size / vertexSize || entity->indexCount > size / indexSize
+                || !snapshot_rangeValid(entity->verticesOffset, entity->vertexCount * vertexSize, size)
+                || !snapshot_rangeValid(entity->indicesOffset, entity->indexCount * indexSize, size)
+                || entity->indicesOffset % indexSize != 0
+                || !indicesInRange(data + entity->indicesOffset, indexType, entity->indexCount, entity->vertexCount)){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool snapshot_load(const char* path){
+    ASSERT(mapping.data == NULL, "Only one scene snapshot can be loaded at a time");
+    Uint32 startTime = SDL_GetTicks();
+
+    if(!mapFile(path, &mapping)){
+        return false;
+    }
+    char* base = (char*)mapping.data;
+    SnapshotHeader* header = (SnapshotHeader*)base;
+    bool valid = snapshot_validate((const char*)base, mapping.size);
+    // Header read only once validated
+    for(uint32_t i = 0; valid && i < header->sourceCount; i++){
+        SnapshotSource* source = (SnapshotSource*)(base + header->sourcesOffset) + i;
+        long stampOffset = (long)(header->sourcesOffset + i * sizeof(SnapshotSource) + offsetof(SnapshotSource, stamp));
+        valid = snapshot_sourceMatches(path, source, base + header->stringsOffset + source->pathOffset, stampOffset);
+    }
+    if(!valid){
+        printf(TEXT_COLOR_WARNING "Scene snapshot %s is outdated or broken, ignoring it\n" TEXT_COLOR_RESET, path);
+        snapshot_unload();
+        return false;
+    }
+
+    SnapshotEntity* snapshotEntities = (SnapshotEntity*)(base + header->entitiesOffset);
+    SnapshotMaterial* snapshotMaterials = (SnapshotMaterial*)(base + header->materialsOffset);
+    char* strings = base + header->stringsOffset;
+
+    // Materials, texture paths point into the mapping (names are interned). Textures come from the texture cache.
+    int materialBase = globals.materialsCount;
+    textures = (GLuint*)malloc((header->materialCount * MATERIAL_MAP_COUNT + 1) * sizeof(GLuint));
+    if(textures == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate memory for scene snapshot\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    for(uint32_t i = 0; i < header->materialCount; i++){
+        SnapshotMaterial* in = &snapshotMaterials[i];
+        Material* material = getMaterial(addMaterial((Material){
+            .active = true,
+            .name = in->nameOffset == SNAPSHOT_NO_STRING ? NULL : strings + in->nameOffset,
+        }));
+        material->ambient = in->ambient;
+        material->diffuse = in->diffuse;
+        material->specular = in->specular;
+        material->emissive = in->emissive;
+        material->shininess = in->shininess;
+        material->transparency = in->transparency;
+        material->diffuseMapOpacity = in->diffuseMapOpacity;
+        material->ior = in->ior;
+        material->material_flags = in->materialFlags;
+        material->isPostProcessMaterial = in->isPostProcessMaterial;
+
+        GLuint* maps[MATERIAL_MAP_COUNT];
+        maps[MATERIAL_MAP_DIFFUSE] = &material->diffuseMap;
+        maps[MATERIAL_MAP_SPECULAR] = &material->specularMap;
+        maps[MATERIAL_MAP_SHININESS] = &material->shininessMap;
+        maps[MATERIAL_MAP_AMBIENT] = &material->ambientMap;
+        maps[MATERIAL_MAP_ALPHA] = &material->alpha;
+        for(int map = 0; map < MATERIAL_MAP_COUNT; map++){
+            if(in->mapPathOffsets[map] == SNAPSHOT_NO_STRING){
+                continue;
+            }
+            material->mapPaths[map] = strings + in->mapPathOffsets[map];
+            *maps[map] = texcache_acquire(material->mapPaths[map], texcache_mapParams((MaterialMap)map));
+            textures[textureCount++] = *maps[map];
+        }
+    }
+
+    Entity** created = (Entity**)malloc((header->entityCount + 1) * sizeof(Entity*));
+    packedMeshes = (PackedMesh*)calloc(header->entityCount + 1, sizeof(PackedMesh));
+    if(created == NULL || packedMeshes == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate memory for scene snapshot\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    for(uint32_t i = 0; i < header->entityCount; i++){
+        SnapshotEntity* in = &snapshotEntities[i];
+        Entity* entity = addEntity((enum Tag)in->tag);
+        created[i] = entity;
+        entity->visible = (in->flags & SNAPSHOT_ENTITY_VISIBLE) != 0;
+
+        entity->transformComponent->active = 1;
+        memcpy(entity->transformComponent->position, in->position, sizeof(in->position));
+        memcpy(entity->transformComponent->rotation, in->rotation, sizeof(in->rotation));
+        memcpy(entity->transformComponent->scale, in->scale, sizeof(in->scale));
+        transform_markDirty(entity->transformComponent);
+        if(in->parent != -1){
+            transform_setParent(entity, created[in->parent]);
+        }
+
+        if(in->flags & SNAPSHOT_ENTITY_MATERIAL){
+            MaterialComponent* materialComponent = entity->materialComponent;
+            materialComponent->active = 1;
+            materialComponent->diffuse = in->diffuse;
+            materialComponent->diffuseMapOpacity = in->diffuseMapOpacity;
+            if(in->materialIndex != -1){
+                materialComponent->materialIndex = materialBase + in->materialIndex;
+            }else {
+                // Not saved with a material, give it one of its own from its values.
+                materialComponent->materialIndex = addMaterial((Material){
+                    .active = true,
+                    .ambient = in->ambient,
+                    .diffuse = in->diffuse,
+                    .specular = in->specular,
+                    .shininess = in->shininess,
+                    .diffuseMapOpacity = in->diffuseMapOpacity,
+                    .material_flags = in->materialFlags,
+                });
+            }
+        }
+
+        if(in->flags & SNAPSHOT_ENTITY_MESH){
+            MeshComponent* meshComponent = entity->meshComponent;
+            meshComponent->active = 1;
+            meshComponent->drawIndexed = (in->flags & SNAPSHOT_ENTITY_DRAW_INDEXED) != 0;
+            meshComponent->vertexCount = in->vertexCount;
+            meshComponent->indexCount = in->indexCount;
+            meshComponent->gpuData->drawMode = in->drawMode;
+            meshComponent->gpuData->vertexCount = in->vertexCount;
+            VertexLayout layout = {
+                (VertexPositionFormat)in->positionFormat, in->dropColor != 0, (VertexUvFormat)in->uvFormat, (VertexNormalFormat)in->normalFormat
+            };
+            if(in->flags & SNAPSHOT_ENTITY_PACKED){
+                PackedMesh* packed = &packedMeshes[i];
+                packed->layout = layout;
+                memcpy(packed->positionScale, in->positionScale, sizeof(in->positionScale));
+                memcpy(packed->positionOffset, in->positionOffset, sizeof(in->positionOffset));
+                packed->stride = (GLsizei)in->stride;
+                packed->vertexCount = (int)in->vertexCount;
+                packed->vertices = base + in->verticesOffset;
+                packed->indexCount = (int)in->indexCount;
+                packed->indexType = in->indexType;
+                packed->indices = base + in->indicesOffset;
+                meshComponent->packedMesh = packed;
+            }else {
+                meshComponent->vertices = (Vertex*)(base + in->verticesOffset);
+                meshComponent->indices = in->indexCount > 0 ? (unsigned int*)(base + in->indicesOffset) : NULL;
+                meshComponent->gpuData->vertexLayout = layout;
+            }
+            uploadMesh(entity);
+        }
+    }
+    free(created);
+
+    printf("Scene snapshot loaded: %s, %u entities, %u materials in %u ms\n", path, header->entityCount, header->materialCount, SDL_GetTicks() - startTime);
+    return true;
+}
@@ -0,0 +1,120 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+ * Binary scene snapshots.
+ * Saves model entities (transforms, hierarchy, material components), the materials they use,
+ * texture file references and the vertex/index data to one versioned file. Meshes with a cpu copy are stored
+ * as Vertex, meshes from the mesh cache (gpu layout only) are stored packed & uploaded as they are.
+ * Loading maps the file and points mesh vertices, indices & material names straight into the mapping,
+ * so startup skips obj/mtl text parsing and only does the gpu uploads.
+ * The files the scene was built from (obj & mtl) are stamped like the mesh cache, a changed one makes the
+ * snapshot outdated & the scene is built the slow way, which writes a new one.
+ *
+ * Layout: header | sources | entities | materials | strings | blobs (16 byte aligned vertex & index data)
+ * All offsets are bytes from the start of the file. Written & read on the same platform, no endian swapping.
+ */
+
+#define SNAPSHOT_MAGIC "SNAP"
+#define SNAPSHOT_VERSION 7 // 2: obj meshes are indexed, 3: and vertex cache optimized, 4: vertex layouts, 5: shared materials, 6: source stamps, 7: packed meshes. Older files get rebuilt
+#define SNAPSHOT_NO_STRING UINT64_MAX
+#define SNAPSHOT_BLOB_ALIGNMENT 16
+
+#define SNAPSHOT_ENTITY_VISIBLE      (1 << 0)
+#define SNAPSHOT_ENTITY_MESH         (1 << 1)
+#define SNAPSHOT_ENTITY_MATERIAL     (1 << 2)
+#define SNAPSHOT_ENTITY_DRAW_INDEXED (1 << 3)
+#define SNAPSHOT_ENTITY_PACKED       (1 << 4) // vertices & indices are in the gpu layout, see PackedMesh
+
+typedef struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    // Struct sizes at write time, a mismatch means the file came from another build.
+    uint32_t vertexSize;
+    uint32_t entitySize;
+    uint32_t materialSize;
+    uint32_t entityCount;
+    uint32_t materialCount;
+    uint32_t sourceCount;
+    uint64_t sourcesOffset;
+    uint64_t entitiesOffset;
+    uint64_t materialsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    uint64_t blobsOffset;
+    uint64_t blobsSize;
+    uint64_t fileSize;
+} SnapshotHeader;
+
+// A file the scene was built from
+typedef struct SnapshotSource {
+    uint64_t pathOffset;    // in string table
+    SourceStamp stamp;      // of the packed copy (time 0) when the asset pack has the file
+} SnapshotSource;
+
+typedef struct SnapshotEntity {
+    int32_t tag;
+    int32_t parent;         // index in snapshot entities, -1 for roots
+    int32_t materialIndex;  // index in snapshot materials, -1 for none
+    uint32_t flags;         // SNAPSHOT_ENTITY_*
+    float position[3];
+    float rotation[4];      // quat (x,y,z,w)
+    float scale[3];
+    Color ambient;
+    Color diffuse;
+    Color specular;
+    float shininess;
+    float diffuseMapOpacity;
+    uint32_t materialFlags;
+    uint32_t drawMode;
+    uint8_t positionFormat; // VertexLayout of the gpu copy, vertices are stored as Vertex unless packed
+    uint8_t uvFormat;
+    uint8_t normalFormat;
+    uint8_t dropColor;
+    // Packed meshes only
+    uint32_t stride;
+    uint32_t indexType;     // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    float positionScale[3];
+    float positionOffset[3];
+    uint64_t verticesOffset;
+    uint64_t vertexCount;
+    uint64_t indicesOffset;
+    uint64_t indexCount;
+} SnapshotEntity;
+
+typedef struct SnapshotMaterial {
+    Color ambient;
+    Color diffuse;
+    Color specular;
+    Color emissive;
+    float shininess;
+    float transparency;
+    float diffuseMapOpacity;
+    float ior;
+    uint32_t materialFlags;
+    uint32_t isPostProcessMaterial;
+    uint64_t nameOffset;                          // in string table, SNAPSHOT_NO_STRING if none
+    uint64_t mapPathOffsets[MATERIAL_MAP_COUNT];  // texture files, SNAPSHOT_NO_STRING if none
+} SnapshotMaterial;
+
+/**
+ * @brief Write roots and all their descendants (through GroupComponent) to a snapshot file.
+ * @param sources files the entities were built from, a later change to any of them makes the snapshot outdated.
+ * @return false if the file could not be written.
+ */
+bool snapshot_save(const char* path, const char* const* sources, int sourceCount, Entity** roots, int rootCount);
+/**
+ * @brief Recreate the entities of a snapshot file. Materials are appended to globals.materials.
+ * @return false if the file is missing, outdated, from an other version or broken. Caller should build the scene the slow way then.
+ */
+bool snapshot_load(const char* path);
+/**
+ * @brief Release the file mapping & the texture references of the loaded materials. Loaded meshes point into it,
+ * only call when they are gone (quit), before texcache_shutdown.
+ */
+void snapshot_unload();
+
+#endif
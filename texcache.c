@@ -0,0 +1,197 @@
+#include "texcache.h"
+#include "loader.h"
+#include "texstream.h"
+#include "globals.h"
+#include "opengl.h"
+#include <stdint.h>
+
+typedef struct TexCacheEntry {
+    char* path;             // canonical, NULL marks an empty slot
+    uint64_t hash;
+    TextureParams params;
+    GLuint texture;
+    int refCount;
+} TexCacheEntry;
+
+// Open addressing with linear probing, capacity is a power of 2.
+static TexCacheEntry* entries = NULL;
+static int capacity = 0;
+static int count = 0;
+
+static uint64_t texcache_hash(const char* path, TextureParams params){
+    uint64_t hash = hashBytes(HASH_SEED, path, strlen(path));
+    // Field by field, the struct may have padding
+    hash = hashBytes(hash, &params.wrap, sizeof(params.wrap));
+    hash = hashBytes(hash, &params.minFilter, sizeof(params.minFilter));
+    hash = hashBytes(hash, &params.magFilter, sizeof(params.magFilter));
+    hash = hashBytes(hash, &params.colorSpace, sizeof(params.colorSpace));
+    return hash;
+}
+
+static bool texcache_paramsEqual(TextureParams a, TextureParams b){
+    return a.wrap == b.wrap && a.minFilter == b.minFilter && a.magFilter == b.magFilter && a.colorSpace == b.colorSpace;
+}
+
+static void texcache_grow(){
+    int oldCapacity = capacity;
+    TexCacheEntry* oldEntries = entries;
+    capacity = capacity == 0 ? TEXCACHE_INITIAL_CAPACITY : capacity * 2;
+    entries = (TexCacheEntry*)calloc(capacity, sizeof(TexCacheEntry));
+    if(entries == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate texture cache\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    for(int i = 0; i < oldCapacity; i++){
+        if(oldEntries[i].path == NULL){
+            continue;
+        }
+        int slot = (int)(oldEntries[i].hash & (uint64_t)(capacity - 1));
+        while(entries[slot].path != NULL){
+            slot = (slot + 1) & (capacity - 1);
+        }
+        entries[slot] = oldEntries[i];
+    }
+    free(oldEntries);
+}
+
+/**
+ * @brief Texture of an image file, loaded on the first acquire of its path & params.
+ * @return texture with one more reference, pair with texcache_release. 0 if path is NULL.
+ */
+GLuint texcache_acquire(const char* path, TextureParams params){
+    if(path == NULL){
+        return 0;
+    }
+    char canonical[LOADER_MAX_PATH];
+    canonicalPath(path, canonical, sizeof(canonical));
+    uint64_t hash = texcache_hash(canonical, params);
+
+    if(capacity > 0){
+        int slot = (int)(hash & (uint64_t)(capacity - 1));
+        while(entries[slot].path != NULL){
+            TexCacheEntry* entry = &entries[slot];
+            if(entry->hash == hash && texcache_paramsEqual(entry->params, params) && strcmp(entry->path, canonical) == 0){
+                entry->refCount++;
+                return entry->texture;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+    }
+
+    if(count + 1 > capacity * TEXCACHE_MAX_LOAD){
+        texcache_grow();
+    }
+    int slot = (int)(hash & (uint64_t)(capacity - 1));
+    while(entries[slot].path != NULL){
+        slot = (slot + 1) & (capacity - 1);
+    }
+    TexCacheEntry* entry = &entries[slot];
+    entry->path = (char*)malloc(strlen(canonical) + 1);
+    if(entry->path == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate texture cache path\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    strcpy(entry->path, canonical);
+    entry->hash = hash;
+    entry->params = params;
+    entry->texture = loader_loadTexture(canonical, params); // placeholder until the image has decoded
+    entry->refCount = 1;
+    count++;
+    return entry->texture;
+}
+
+static int texcache_find(GLuint texture){
+    // Releases are rare, a scan keeps the table keyed by path only.
+    for(int i = 0; i < capacity; i++){
+        if(entries[i].path != NULL && entries[i].texture == texture){
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Add a reference to a texture from texcache_acquire, for sharing a handle that is released separately.
+ */
+void texcache_retain(GLuint texture){
+    if(texture == 0){
+        return;
+    }
+    int slot = texcache_find(texture);
+    if(slot < 0){
+        printf(TEXT_COLOR_WARNING "texcache_retain: texture %u is not in the texture cache\n" TEXT_COLOR_RESET, texture);
+        return;
+    }
+    entries[slot].refCount++;
+}
+
+/**
+ * @brief Drop a reference, the last one deletes the GL texture (and drops its load if still in flight).
+ */
+void texcache_release(GLuint texture){
+    if(texture == 0){
+        return;
+    }
+    int slot = texcache_find(texture);
+    if(slot < 0){
+        printf(TEXT_COLOR_WARNING "texcache_release: texture %u is not in the texture cache\n" TEXT_COLOR_RESET, texture);
+        return;
+    }
+    if(--entries[slot].refCount > 0){
+        return;
+    }
+    loader_cancelTexture(texture);
+    texstream_unregister(texture);
+    glDeleteTextures(1, &texture);
+    free(entries[slot].path);
+    entries[slot].path = NULL;
+    count--;
+
+    // Backward shift deletion, pull later entries of the probe run into the hole so lookups don't stop early.
+    int hole = slot;
+    int next = (hole + 1) & (capacity - 1);
+    while(entries[next].path != NULL){
+        int home = (int)(entries[next].hash & (uint64_t)(capacity - 1));
+        // Move it if its home isn't cyclically in (hole, next]
+        bool between = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+        if(!between){
+            entries[hole] = entries[next];
+            entries[next].path = NULL;
+            hole = next;
+        }
+        next = (next + 1) & (capacity - 1);
+    }
+}
+
+/**
+ * @brief Params material maps load with, colors are sRGB and the rest is data.
+ */
+TextureParams texcache_mapParams(MaterialMap map){
+    switch(map){
+        case MATERIAL_MAP_DIFFUSE:
+        case MATERIAL_MAP_AMBIENT:
+            return TEXTURE_PARAMS_COLOR;
+        default:
+            return TEXTURE_PARAMS_DATA;
+    }
+}
+
+int texcache_count(){
+    return count;
+}
+
+/**
+ * @brief Delete every cached texture, call after loader_shutdown.
+ */
+void texcache_shutdown(){
+    for(int i = 0; i < capacity; i++){
+        if(entries[i].path != NULL){
+            glDeleteTextures(1, &entries[i].texture);
+            free(entries[i].path);
+        }
+    }
+    free(entries);
+    entries = NULL;
+    capacity = 0;
+    count = 0;
+}
@@ -0,0 +1,31 @@
+#ifndef TEXCACHE_H
+#define TEXCACHE_H
+
+#include "types.h"
+
+/**
+ * Texture cache
+ * Every file backed texture goes through here, so a file referenced by many materials is decoded & uploaded once.
+ * Keyed by the canonical path (separators normalized, "." and ".." folded, no filesystem access) plus the
+ * TextureParams, the same image sampled differently or loaded as color & as data is a separate texture.
+ * Handles are the GL texture names, reference counted: texcache_acquire adds a reference, texcache_release
+ * drops one and deletes the texture with the last. Misses are loaded through loader_loadTexture, so a handle
+ * holds the white placeholder until its image lands.
+ * References are owned by what acquired them: a .mtl material's maps (a map line read again releases the old one),
+ * a loaded scene snapshot (until snapshot_unload) and the built in assets (until texcache_shutdown). Copies of a
+ * Material in globals.materials share those handles without a reference of their own, so material teardown
+ * doesn't release anything, texcache_shutdown deletes whatever is left.
+ * Main thread only (GL).
+ */
+
+#define TEXCACHE_INITIAL_CAPACITY 64 // power of 2, grows
+#define TEXCACHE_MAX_LOAD 0.7f
+
+GLuint texcache_acquire(const char* path, TextureParams params);
+void texcache_retain(GLuint texture);
+void texcache_release(GLuint texture);
+TextureParams texcache_mapParams(MaterialMap map);
+int texcache_count();
+void texcache_shutdown();
+
+#endif
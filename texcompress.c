@@ -0,0 +1,541 @@
+#include "texcompress.h"
+#include "utils.h"
+#include "globals.h"
+#include "profiler.h"
+#include "pack.h"
+#include <stddef.h>
+
+static const uint8_t ktxIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// ETC1 intensity modifiers, pixel index order: +small, +large, -small, -large
+static const int etcModifiers[8][4] = {
+    {2, 8, -2, -8}, {5, 17, -5, -17}, {9, 29, -9, -29}, {13, 42, -13, -42},
+    {18, 60, -18, -60}, {24, 80, -24, -80}, {33, 106, -33, -106}, {47, 183, -47, -183}
+};
+
+// EAC alpha modifiers
+static const int eacModifiers[16][8] = {
+    {-3, -6, -9, -15, 2, 5, 8, 14}, {-3, -7, -10, -13, 2, 6, 9, 12}, {-2, -5, -8, -13, 1, 4, 7, 12},
+    {-2, -4, -6, -13, 1, 3, 5, 12}, {-3, -6, -8, -12, 2, 5, 7, 11}, {-3, -7, -9, -11, 2, 6, 8, 10},
+    {-4, -7, -8, -11, 3, 6, 7, 10}, {-3, -5, -8, -11, 2, 4, 7, 10}, {-2, -6, -8, -10, 1, 5, 7, 9},
+    {-2, -5, -8, -10, 1, 4, 7, 9}, {-2, -4, -8, -10, 1, 3, 7, 9}, {-2, -5, -7, -10, 1, 4, 6, 9},
+    {-3, -4, -7, -10, 2, 3, 6, 9}, {-1, -2, -3, -10, 0, 1, 2, 9}, {-4, -6, -8, -9, 3, 5, 7, 8},
+    {-3, -5, -7, -9, 2, 4, 6, 8}
+};
+
+static int texcompress_clamp255(int value){
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static void texcompress_path(const char* sourcePath, char* out, size_t outSize){
+    snprintf(out, outSize, "%s%s", sourcePath, TEXCOMPRESS_EXTENSION);
+}
+
+//----------------------------------------------------------------------------------------------//
+// Encoding
+//----------------------------------------------------------------------------------------------//
+
+// A 4x4 block of RGBA pixels, index x * 4 + y like the ETC pixel order.
+typedef struct EtcBlock {
+    int rgba[16][4];
+} EtcBlock;
+
+static int etc_pixelError(const int* pixel, const int* color){
+    // Rough perceptual weights, green matters most
+    int r = pixel[0] - color[0];
+    int g = pixel[1] - color[1];
+    int b = pixel[2] - color[2];
+    return 3 * r * r + 6 * g * g + b * b;
+}
+
+static bool etc_inSubBlock(int pixel, int subBlock, int flip){
+    int x = pixel / 4;
+    int y = pixel % 4;
+    int half = flip ? y : x;
+    return (half >= 2) == (subBlock == 1);
+}
+
+/**
+ * @brief Best table & pixel indices for one sub block around base (8 bit color).
+ * @return error, table & indices written out.
+ */
+static int etc_fitSubBlock(const EtcBlock* block, int subBlock, int flip, const int* base, int* tableOut, int* indices){
+    int bestError = 0x7fffffff;
+    for(int table = 0; table < 8; table++){
+        int error = 0;
+        int tableIndices[16];
+        for(int pixel = 0; pixel < 16 && error < bestError; pixel++){
+            if(!etc_inSubBlock(pixel, subBlock, flip)){
+                continue;
+            }
+            int bestPixelError = 0x7fffffff;
+            for(int index = 0; index < 4; index++){
+                int modifier = etcModifiers[table][index];
+                int color[3] = {texcompress_clamp255(base[0] + modifier), texcompress_clamp255(base[1] + modifier), texcompress_clamp255(base[2] + modifier)};
+                int pixelError = etc_pixelError(block->rgba[pixel], color);
+                if(pixelError < bestPixelError){
+                    bestPixelError = pixelError;
+                    tableIndices[pixel] = index;
+                }
+            }
+            error += bestPixelError;
+        }
+        if(error < bestError){
+            bestError = error;
+            *tableOut = table;
+            for(int pixel = 0; pixel < 16; pixel++){
+                if(etc_inSubBlock(pixel, subBlock, flip)){
+                    indices[pixel] = tableIndices[pixel];
+                }
+            }
+        }
+    }
+    return bestError;
+}
+
+static void etc_average(const EtcBlock* block, int subBlock, int flip, float* average){
+    average[0] = average[1] = average[2] = 0.0f;
+    for(int pixel = 0; pixel < 16; pixel++){
+        if(etc_inSubBlock(pixel, subBlock, flip)){
+            average[0] += block->rgba[pixel][0];
+            average[1] += block->rgba[pixel][1];
+            average[2] += block->rgba[pixel][2];
+        }
+    }
+    average[0] /= 8.0f;
+    average[1] /= 8.0f;
+    average[2] /= 8.0f;
+}
+
+typedef struct EtcCandidate {
+    int error;
+    bool differential;
+    int flip;
+    int colors[2][3];   // quantized, 4 bit (individual) or 5 bit & the second as base + delta (differential)
+    int tables[2];
+    int indices[16];
+} EtcCandidate;
+
+static void etc_tryColors(const EtcBlock* block, int flip, bool differential, int quantized[2][3], EtcCandidate* best){
+    EtcCandidate candidate = {0};
+    candidate.differential = differential;
+    candidate.flip = flip;
+    for(int subBlock = 0; subBlock < 2; subBlock++){
+        int base[3];
+        for(int c = 0; c < 3; c++){
+            int value = quantized[subBlock][c];
+            candidate.colors[subBlock][c] = value;
+            base[c] = differential ? (value << 3) | (value >> 2) : (value << 4) | value;
+        }
+        candidate.error += etc_fitSubBlock(block, subBlock, flip, base, &candidate.tables[subBlock], candidate.indices);
+        if(candidate.error >= best->error){
+            return;
+        }
+    }
+    *best = candidate;
+}
+
+/**
+ * @brief 64 bit ETC2 RGB block using the ETC1 modes, big endian.
+ */
+static void etc_encodeBlock(const EtcBlock* block, uint8_t* out){
+    EtcCandidate best = {0};
+    best.error = 0x7fffffff;
+    for(int flip = 0; flip < 2; flip++){
+        float averages[2][3];
+        etc_average(block, 0, flip, averages[0]);
+        etc_average(block, 1, flip, averages[1]);
+
+        int individual[2][3];
+        int differential[2][3];
+        for(int c = 0; c < 3; c++){
+            for(int subBlock = 0; subBlock < 2; subBlock++){
+                individual[subBlock][c] = (int)(averages[subBlock][c] * 15.0f / 255.0f + 0.5f);
+            }
+            int first = (int)(averages[0][c] * 31.0f / 255.0f + 0.5f);
+            int second = (int)(averages[1][c] * 31.0f / 255.0f + 0.5f);
+            // Keep the delta in -4..3, the second color moves towards the first so it stays in 0..31
+            int delta = second - first;
+            delta = delta < -4 ? -4 : (delta > 3 ? 3 : delta);
+            differential[0][c] = first;
+            differential[1][c] = first + delta;
+        }
+        etc_tryColors(block, flip, true, differential, &best);
+        etc_tryColors(block, flip, false, individual, &best);
+    }
+
+    if(best.differential){
+        for(int c = 0; c < 3; c++){
+            int delta = best.colors[1][c] - best.colors[0][c];
+            out[c] = (uint8_t)((best.colors[0][c] << 3) | (delta & 7));
+        }
+    }else {
+        for(int c = 0; c < 3; c++){
+            out[c] = (uint8_t)((best.colors[0][c] << 4) | best.colors[1][c]);
+        }
+    }
+    out[3] = (uint8_t)((best.tables[0] << 5) | (best.tables[1] << 2) | (best.differential ? 2 : 0) | best.flip);
+    unsigned int msb = 0;
+    unsigned int lsb = 0;
+    for(int pixel = 0; pixel < 16; pixel++){
+        msb |= (unsigned int)(best.indices[pixel] >> 1) << pixel;
+        lsb |= (unsigned int)(best.indices[pixel] & 1) << pixel;
+    }
+    out[4] = (uint8_t)(msb >> 8);
+    out[5] = (uint8_t)msb;
+    out[6] = (uint8_t)(lsb >> 8);
+    out[7] = (uint8_t)lsb;
+}
+
+static int eac_fit(const EtcBlock* block, int base, int multiplier, int table, int* indices){
+    int error = 0;
+    for(int pixel = 0; pixel < 16; pixel++){
+        int bestPixelError = 0x7fffffff;
+        for(int index = 0; index < 8; index++){
+            int difference = texcompress_clamp255(base + eacModifiers[table][index] * multiplier) - block->rgba[pixel][3];
+            if(difference * difference < bestPixelError){
+                bestPixelError = difference * difference;
+                indices[pixel] = index;
+            }
+        }
+        error += bestPixelError;
+    }
+    return error;
+}
+
+/**
+ * @brief 64 bit EAC alpha block, big endian.
+ */
+static void eac_encodeBlock(const EtcBlock* block, uint8_t* out){
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    for(int pixel = 0; pixel < 16; pixel++){
+        minAlpha = block->rgba[pixel][3] < minAlpha ? block->rgba[pixel][3] : minAlpha;
+        maxAlpha = block->rgba[pixel][3] > maxAlpha ? block->rgba[pixel][3] : maxAlpha;
+    }
+    int bestBase = minAlpha;
+    int bestMultiplier = 1;
+    int bestTable = 13; // has a 0 modifier, exact for flat blocks
+    int bestIndices[16];
+    int bestError = eac_fit(block, bestBase, bestMultiplier, bestTable, bestIndices);
+
+    for(int table = 0; table < 16 && bestError > 0; table++){
+        int low = eacModifiers[table][3];
+        int high = eacModifiers[table][7];
+        int guess = (int)((float)(maxAlpha - minAlpha) / (float)(high - low) + 0.5f);
+        for(int multiplier = guess - 1; multiplier <= guess + 1; multiplier++){
+            if(multiplier < 1 || multiplier > 15){
+                continue;
+            }
+            // Line the range up with the lowest, the highest & the middle of the table
+            int bases[3] = {minAlpha - low * multiplier, maxAlpha - high * multiplier, (minAlpha + maxAlpha + 1) / 2};
+            for(int b = 0; b < 3; b++){
+                int base = texcompress_clamp255(bases[b]);
+                int indices[16];
+                int error = eac_fit(block, base, multiplier, table, indices);
+                if(error < bestError){
+                    bestError = error;
+                    bestBase = base;
+                    bestMultiplier = multiplier;
+                    bestTable = table;
+                    memcpy(bestIndices, indices, sizeof(indices));
+                }
+            }
+        }
+    }
+
+    out[0] = (uint8_t)bestBase;
+    out[1] = (uint8_t)((bestMultiplier << 4) | bestTable);
+    uint64_t bits = 0;
+    for(int pixel = 0; pixel < 16; pixel++){
+        bits = (bits << 3) | (uint64_t)bestIndices[pixel];
+    }
+    for(int i = 0; i < 6; i++){
+        out[2 + i] = (uint8_t)(bits >> (40 - 8 * i));
+    }
+}
+
+static size_t texcompress_levelSize(int width, int height, int blockSize){
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+static void texcompress_encodeLevel(const unsigned char* pixels, int width, int height, int channels, uint8_t* out){
+    int blockSize = channels == 4 ? 16 : 8;
+    for(int blockY = 0; blockY < (height + 3) / 4; blockY++){
+        for(int blockX = 0; blockX < (width + 3) / 4; blockX++){
+            EtcBlock block;
+            for(int x = 0; x < 4; x++){
+                for(int y = 0; y < 4; y++){
+                    // Edge blocks repeat the last row/column
+                    int pixelX = blockX * 4 + x < width ? blockX * 4 + x : width - 1;
+                    int pixelY = blockY * 4 + y < height ? blockY * 4 + y : height - 1;
+                    const unsigned char* source = pixels + ((size_t)pixelY * width + pixelX) * channels;
+                    for(int c = 0; c < 4; c++){
+                        block.rgba[x * 4 + y][c] = c < channels ? source[c] : 255;
+                    }
+                }
+            }
+            uint8_t* blockOut = out + ((size_t)blockY * ((width + 3) / 4) + blockX) * blockSize;
+            if(channels == 4){
+                eac_encodeBlock(&block, blockOut);
+                etc_encodeBlock(&block, blockOut + 8);
+            }else {
+                etc_encodeBlock(&block, blockOut);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Half size box filter, odd edges repeat their last pixel.
+ */
+static void texcompress_downsample(const unsigned char* pixels, int width, int height, int channels, unsigned char* out){
+    int outWidth = width > 1 ? width / 2 : 1;
+    int outHeight = height > 1 ? height / 2 : 1;
+    for(int y = 0; y < outHeight; y++){
+        int y0 = y * 2 < height ? y * 2 : height - 1;
+        int y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+        for(int x = 0; x < outWidth; x++){
+            int x0 = x * 2 < width ? x * 2 : width - 1;
+            int x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+            for(int c = 0; c < channels; c++){
+                int sum = pixels[((size_t)y0 * width + x0) * channels + c] + pixels[((size_t)y0 * width + x1) * channels + c]
+                        + pixels[((size_t)y1 * width + x0) * channels + c] + pixels[((size_t)y1 * width + x1) * channels + c];
+                out[((size_t)y * outWidth + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------//
+// Container
+//----------------------------------------------------------------------------------------------//
+
+static uint32_t texcompress_align4(uint32_t size){
+    return (size + 3) & ~3u;
+}
+
+/**
+ * @brief Check the header & level table and point the levels into the mapping.
+ * @param source copied out, the value sits at an unaligned offset in the file.
+ * @param sourceOffset file offset of source.
+ */
+static bool texcompress_parse(const MappedFile* mapping, CompressedTexture* texture, TexCompressSource* source, long* sourceOffset){
+    const uint8_t* base = (const uint8_t*)mapping->data;
+    size_t size = mapping->size;
+    if(size < sizeof(KtxHeader)){
+        return false;
+    }
+    const KtxHeader* header = (const KtxHeader*)base;
+    if(memcmp(header->identifier, ktxIdentifier, sizeof(ktxIdentifier)) != 0 || header->endianness != 0x04030201
+        || header->glType != 0 || header->numberOfFaces != 1 || header->numberOfArrayElements != 0
+        || header->numberOfMipmapLevels < 1 || header->numberOfMipmapLevels > TEXCOMPRESS_MAX_LEVELS
+        || (header->glInternalFormat != GL_COMPRESSED_RGB8_ETC2 && header->glInternalFormat != GL_COMPRESSED_RGBA8_ETC2_EAC)
+        || header->pixelWidth == 0 || header->pixelHeight == 0
+        || (uint64_t)sizeof(KtxHeader) + header->bytesOfKeyValueData > size){
+        return false;
+    }
+
+    // Key/value pairs, ours must be there.
+    bool found = false;
+    size_t offset = sizeof(KtxHeader);
+    size_t keyValueEnd = offset + header->bytesOfKeyValueData;
+    while(offset + sizeof(uint32_t) <= keyValueEnd){
+        uint32_t pairSize = *(const uint32_t*)(base + offset);
+        offset += sizeof(uint32_t);
+        if(offset + pairSize > keyValueEnd){
+            return false;
+        }
+        const char* key = (const char*)(base + offset);
+        size_t keySize = strlen(TEXCOMPRESS_SOURCE_KEY) + 1;
+        if(pairSize == keySize + sizeof(TexCompressSource) && memcmp(key, TEXCOMPRESS_SOURCE_KEY, keySize) == 0){
+            memcpy(source, base + offset + keySize, sizeof(TexCompressSource));
+            *sourceOffset = (long)(offset + keySize);
+            found = true;
+        }
+        offset += texcompress_align4(pairSize);
+    }
+    if(!found || source->version != TEXCOMPRESS_VERSION){
+        return false;
+    }
+
+    int blockSize = header->glInternalFormat == GL_COMPRESSED_RGBA8_ETC2_EAC ? 16 : 8;
+    int width = (int)header->pixelWidth;
+    int height = (int)header->pixelHeight;
+    offset = keyValueEnd;
+    for(uint32_t level = 0; level < header->numberOfMipmapLevels; level++){
+        if(offset + sizeof(uint32_t) > size){
+            return false;
+        }
+        uint32_t imageSize = *(const uint32_t*)(base + offset);
+        offset += sizeof(uint32_t);
+        if(imageSize != texcompress_levelSize(width, height, blockSize) || offset + imageSize > size){
+            return false;
+        }
+        texture->levels[level] = base + offset;
+        texture->levelSizes[level] = imageSize;
+        offset += texcompress_align4(imageSize);
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    texture->format = header->glInternalFormat;
+    texture->width = (int)header->pixelWidth;
+    texture->height = (int)header->pixelHeight;
+    texture->levelCount = (int)header->numberOfMipmapLevels;
+    return true;
+}
+
+bool texcompress_load(const char* sourcePath, CompressedTexture* texture){
+    #if !TEXCOMPRESS_ENABLED
+    (void)sourcePath;
+    (void)texture;
+    return false;
+    #else
+    char path[512];
+    texcompress_path(sourcePath, path, sizeof(path));
+    memset(texture, 0, sizeof(CompressedTexture));
+    PackView view;
+    if(pack_find(path, &view)){
+        // Packed with its source, no staleness check. The mapping stays empty, levels point into the pack.
+        MappedFile packed = {(void*)view.data, view.size};
+        TexCompressSource source;
+        long sourceOffset;
+        if(texcompress_parse(&packed, texture, &source, &sourceOffset)){
+            return true;
+        }
+        printf(TEXT_COLOR_WARNING "Compressed texture %s in the asset pack is broken, using the source\n" TEXT_COLOR_RESET, path);
+        memset(texture, 0, sizeof(CompressedTexture));
+    }
+    if(!mapFile(path, &texture->mapping)){
+        return false;
+    }
+    TexCompressSource source;
+    long sourceOffset;
+    if(!texcompress_parse(&texture->mapping, texture, &source, &sourceOffset)
+        || !sourceStampMatches(sourcePath, &source.source, path, sourceOffset + (long)offsetof(TexCompressSource, source))){
+        printf(TEXT_COLOR_WARNING "Compressed texture %s is outdated or broken, rebuilding it\n" TEXT_COLOR_RESET, path);
+        unmapFile(&texture->mapping);
+        return false;
+    }
+    return true;
+    #endif
+}
+
+bool texcompress_build(const char* sourcePath, const unsigned char* pixels, int width, int height, int channels, CompressedTexture* texture){
+    #if !TEXCOMPRESS_ENABLED
+    (void)sourcePath;
+    (void)pixels;
+    (void)width;
+    (void)height;
+    (void)channels;
+    (void)texture;
+    return false;
+    #else
+    if(channels != 3 && channels != 4){
+        return false;
+    }
+    PROFILE_BEGIN("texcompress_build");
+    Uint32 startTime = SDL_GetTicks();
+    char path[512];
+    texcompress_path(sourcePath, path, sizeof(path));
+
+    TexCompressSource source = {0};
+    source.version = TEXCOMPRESS_VERSION;
+    if(!getSourceStamp(sourcePath, &source.source)){
+        printf(TEXT_COLOR_WARNING "Could not read %s for its compressed texture\n" TEXT_COLOR_RESET, sourcePath);
+        PROFILE_END();
+        return false;
+    }
+
+    int blockSize = channels == 4 ? 16 : 8;
+    int levelCount = 1;
+    for(int w = width, h = height; (w > 1 || h > 1) && levelCount < TEXCOMPRESS_MAX_LEVELS; levelCount++){
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+
+    // Written next to the file & renamed over it, a texture using the same source may have the old one mapped.
+    char tempPath[sizeof(path) + 16];
+    FILE* fp = openReplacingFile(path, tempPath, sizeof(tempPath));
+    if(fp == NULL){
+        printf(TEXT_COLOR_WARNING "Could not write compressed texture %s\n" TEXT_COLOR_RESET, path);
+        PROFILE_END();
+        return false;
+    }
+    size_t keySize = strlen(TEXCOMPRESS_SOURCE_KEY) + 1;
+    uint32_t pairSize = (uint32_t)(keySize + sizeof(TexCompressSource));
+    KtxHeader header = {0};
+    memcpy(header.identifier, ktxIdentifier, sizeof(ktxIdentifier));
+    header.endianness = 0x04030201;
+    header.glTypeSize = 1;
+    header.glInternalFormat = channels == 4 ? GL_COMPRESSED_RGBA8_ETC2_EAC : GL_COMPRESSED_RGB8_ETC2;
+    header.glBaseInternalFormat = channels == 4 ? GL_RGBA : GL_RGB;
+    header.pixelWidth = (uint32_t)width;
+    header.pixelHeight = (uint32_t)height;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = (uint32_t)levelCount;
+    header.bytesOfKeyValueData = (uint32_t)sizeof(uint32_t) + texcompress_align4(pairSize);
+    static const uint8_t zeros[4] = {0};
+    size_t pairPadding = texcompress_align4(pairSize) - pairSize;
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1
+        && fwrite(&pairSize, sizeof(pairSize), 1, fp) == 1
+        && fwrite(TEXCOMPRESS_SOURCE_KEY, keySize, 1, fp) == 1
+        && fwrite(&source, sizeof(source), 1, fp) == 1
+        && (pairPadding == 0 || fwrite(zeros, pairPadding, 1, fp) == 1);
+
+    // Level 0 encodes from the source, every next level is box filtered from the previous one.
+    size_t pixelsSize = (size_t)width * height * channels;
+    unsigned char* level = (unsigned char*)malloc(pixelsSize);
+    unsigned char* next = (unsigned char*)malloc(pixelsSize); // swapped with level, both need the full size
+    uint8_t* blocks = (uint8_t*)malloc(texcompress_levelSize(width, height, blockSize));
+    if(level == NULL || next == NULL || blocks == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate memory for texture compression\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    memcpy(level, pixels, pixelsSize);
+    int levelWidth = width;
+    int levelHeight = height;
+    for(int i = 0; i < levelCount && written; i++){
+        uint32_t imageSize = (uint32_t)texcompress_levelSize(levelWidth, levelHeight, blockSize);
+        texcompress_encodeLevel(level, levelWidth, levelHeight, channels, blocks);
+        written = fwrite(&imageSize, sizeof(imageSize), 1, fp) == 1 && fwrite(blocks, imageSize, 1, fp) == 1;
+        if(i + 1 < levelCount){
+            texcompress_downsample(level, levelWidth, levelHeight, channels, next);
+            unsigned char* swap = level;
+            level = next;
+            next = swap;
+            levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+            levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+        }
+    }
+    free(level);
+    free(next);
+    free(blocks);
+    if(!closeReplacingFile(fp, tempPath, path, written)){
+        printf(TEXT_COLOR_WARNING "Could not write compressed texture %s\n" TEXT_COLOR_RESET, path);
+        PROFILE_END();
+        return false;
+    }
+    printf("Compressed texture saved: %s, %dx%d, %d levels, %u ms\n", path, width, height, levelCount, SDL_GetTicks() - startTime);
+    PROFILE_END();
+    return texcompress_load(sourcePath, texture);
+    #endif
+}
+
+/**
+ * @brief Bytes uploaded, all levels.
+ */
+size_t texcompress_size(const CompressedTexture* texture){
+    size_t size = 0;
+    for(int level = 0; level < texture->levelCount; level++){
+        size += texture->levelSizes[level];
+    }
+    return size;
+}
+
+void texcompress_free(CompressedTexture* texture){
+    if(texture->mapping.data != NULL){
+        unmapFile(&texture->mapping);
+    }
+    texture->levelCount = 0;
+}
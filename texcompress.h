@@ -0,0 +1,87 @@
+#ifndef TEXCOMPRESS_H
+#define TEXCOMPRESS_H
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+ * Compressed textures
+ * Source images are converted once into ETC2 (GLES 3.0 core) with the whole mip chain prebuilt, and written
+ * next to the source as <image>.ktx. Later loads map that file and uploadCompressedTexture uploads each
+ * level with glCompressedTexImage2D, no decoding & no glGenerateMipmap at runtime.
+ * - 3 channel images: GL_COMPRESSED_RGB8_ETC2, 8 bytes per 4x4 block (6x smaller than RGB8)
+ * - 4 channel images: GL_COMPRESSED_RGBA8_ETC2_EAC, 16 bytes per 4x4 block (4x smaller than RGBA8)
+ * The stored formats are the linear ones, the sRGB variant is picked at upload (same block data).
+ *
+ * The encoder only emits ETC1 compatible blocks (individual & differential modes, differential
+ * deltas always in range so ETC2 decoders never see T/H/planar), alpha goes in EAC blocks.
+ * Mips are box filtered on the raw bytes, like glGenerateMipmap did on the uncompressed textures.
+ *
+ * The file is a plain KTX 1.1 file. Its "engine.source" key/value holds the source size, modification time and
+ * content hash, stale files are rebuilt the same way as the mesh cache. A .ktx in the asset pack is used as is.
+ * Neither load nor build touch GL or globals, both run on the loader's job threads.
+ * Wasm (WebGL2 only has ETC2 behind an extension, no persistent files) & macOS (desktop GL 4.1) are off.
+ * Elsewhere the context is checked at startup (compressedTexturesSupported, desktop GL 3.3 only has ETC2 through
+ * GL_ARB_ES3_compatibility), without it the loader neither reads nor writes .ktx files.
+ */
+
+#define TEXCOMPRESS_EXTENSION ".ktx"
+#define TEXCOMPRESS_VERSION 1
+#define TEXCOMPRESS_SOURCE_KEY "engine.source"
+#define TEXCOMPRESS_MAX_LEVELS 16
+
+#if defined(__EMSCRIPTEN__) || defined(__APPLE__)
+    #define TEXCOMPRESS_ENABLED 0
+#else
+    #define TEXCOMPRESS_ENABLED 1
+#endif
+
+// KTX 1.1 header, followed by key/value data then per level: uint32 imageSize, image data.
+typedef struct KtxHeader {
+    uint8_t identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+} KtxHeader;
+
+// Value of the TEXCOMPRESS_SOURCE_KEY key
+typedef struct TexCompressSource {
+    uint32_t version;
+    uint32_t padding;
+    SourceStamp source;
+} TexCompressSource;
+
+// A mapped .ktx, levels point into the mapping.
+typedef struct CompressedTexture {
+    MappedFile mapping;
+    GLenum format;       // GL_COMPRESSED_RGB8_ETC2 or GL_COMPRESSED_RGBA8_ETC2_EAC
+    int width;
+    int height;
+    int levelCount;
+    const void* levels[TEXCOMPRESS_MAX_LEVELS];
+    uint32_t levelSizes[TEXCOMPRESS_MAX_LEVELS];
+} CompressedTexture;
+
+/**
+ * @brief Map the .ktx of an image if it is up to date.
+ */
+bool texcompress_load(const char* sourcePath, CompressedTexture* texture);
+/**
+ * @brief Compress decoded pixels (3 or 4 channels) with their mip chain, write the .ktx & map it.
+ * @return false if the image can't be compressed or the file can't be written, pixels are untouched.
+ */
+bool texcompress_build(const char* sourcePath, const unsigned char* pixels, int width, int height, int channels, CompressedTexture* texture);
+size_t texcompress_size(const CompressedTexture* texture);
+void texcompress_free(CompressedTexture* texture);
+
+#endif
@@ -0,0 +1,367 @@
+#include "texstream.h"
+#include "globals.h"
+#include "materials.h"
+#include "opengl.h"
+#include "profiler.h"
+#include <stdint.h>
+#include <float.h>
+
+typedef struct TexStreamEntry {
+    GLuint texture;             // 0 marks an empty slot
+    CompressedTexture compressed;
+    GLenum format;              // internal format of every level, fixed at register (gamma can be toggled since)
+    int baseLevel;              // finest resident level
+    int minResidentLevel;       // this level and the coarser ones are never dropped
+    int wantedLevel;            // finest level asked for this frame, levelCount when unseen
+    uint32_t lastVisibleFrame;
+} TexStreamEntry;
+
+// Open addressing with linear probing on the texture name, capacity is a power of 2.
+static TexStreamEntry* entries = NULL;
+static int capacity = 0;
+static int count = 0;
+static size_t memoryBudget = TEXSTREAM_MEMORY_BUDGET_BYTES;
+static size_t uploadBudget = TEXSTREAM_UPLOAD_BUDGET_BYTES;
+static size_t residentBytes = 0;
+static uint32_t frame = 0;
+
+static int texstream_home(GLuint texture){
+    return (int)((texture * 2654435761u) & (uint32_t)(capacity - 1)); // Fibonacci hashing, names are sequential
+}
+
+static int texstream_find(GLuint texture){
+    if(capacity == 0){
+        return -1;
+    }
+    int slot = texstream_home(texture);
+    while(entries[slot].texture != 0){
+        if(entries[slot].texture == texture){
+            return slot;
+        }
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return -1;
+}
+
+static void texstream_grow(){
+    int oldCapacity = capacity;
+    TexStreamEntry* oldEntries = entries;
+    capacity = capacity == 0 ? TEXSTREAM_INITIAL_CAPACITY : capacity * 2;
+    entries = (TexStreamEntry*)calloc(capacity, sizeof(TexStreamEntry));
+    if(entries == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate texture streaming table\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    for(int i = 0; i < oldCapacity; i++){
+        if(oldEntries[i].texture == 0){
+            continue;
+        }
+        int slot = texstream_home(oldEntries[i].texture);
+        while(entries[slot].texture != 0){
+            slot = (slot + 1) & (capacity - 1);
+        }
+        entries[slot] = oldEntries[i];
+    }
+    free(oldEntries);
+}
+
+static size_t texstream_bytes(const TexStreamEntry* entry, int fromLevel){
+    size_t bytes = 0;
+    for(int level = fromLevel; level < entry->compressed.levelCount; level++){
+        bytes += entry->compressed.levelSizes[level];
+    }
+    return bytes;
+}
+
+/**
+ * @brief Upload the small levels of a compressed texture and take over its mapping for streaming in the rest.
+ * On success compressed is left empty, the mapping is freed by texstream_unregister.
+ * @return false if nothing was uploaded, compressed is untouched.
+ */
+bool texstream_register(GLuint texture, CompressedTexture* compressed, TextureColorSpace colorSpace){
+    if(compressed->levelCount < 1){
+        return false;
+    }
+    int minResidentLevel = compressed->levelCount - 1;
+    while(minResidentLevel > 0){
+        int width = compressed->width >> (minResidentLevel - 1);
+        int height = compressed->height >> (minResidentLevel - 1);
+        if(width > TEXSTREAM_MIN_RESIDENT_SIZE || height > TEXSTREAM_MIN_RESIDENT_SIZE){
+            break;
+        }
+        minResidentLevel--;
+    }
+    GLenum format = compressedTextureFormat(compressed, colorSpace);
+    if(!uploadCompressedTexture(texture, compressed, format, minResidentLevel)){
+        return false;
+    }
+    texstream_unregister(texture); // a texture object loaded twice, the new image wins
+
+    if(count + 1 > capacity * TEXSTREAM_MAX_LOAD){
+        texstream_grow();
+    }
+    int slot = texstream_home(texture);
+    while(entries[slot].texture != 0){
+        slot = (slot + 1) & (capacity - 1);
+    }
+    TexStreamEntry* entry = &entries[slot];
+    entry->texture = texture;
+    entry->compressed = *compressed;
+    entry->format = format;
+    entry->baseLevel = minResidentLevel;
+    entry->minResidentLevel = minResidentLevel;
+    entry->wantedLevel = compressed->levelCount;
+    entry->lastVisibleFrame = frame;
+    *compressed = (CompressedTexture){0};
+    residentBytes += texstream_bytes(entry, entry->baseLevel);
+    count++;
+    return true;
+}
+
+/**
+ * @brief Stop streaming a texture and unmap its file, call before deleting the GL texture. Untracked textures are ignored.
+ */
+void texstream_unregister(GLuint texture){
+    int slot = texstream_find(texture);
+    if(slot < 0){
+        return;
+    }
+    residentBytes -= texstream_bytes(&entries[slot], entries[slot].baseLevel);
+    texcompress_free(&entries[slot].compressed);
+    entries[slot].texture = 0;
+    count--;
+
+    // Backward shift deletion, same as the texture cache.
+    int hole = slot;
+    int next = (hole + 1) & (capacity - 1);
+    while(entries[next].texture != 0){
+        int home = texstream_home(entries[next].texture);
+        bool between = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+        if(!between){
+            entries[hole] = entries[next];
+            entries[next].texture = 0;
+            hole = next;
+        }
+        next = (next + 1) & (capacity - 1);
+    }
+}
+
+/**
+ * @brief Resident texture memory cap and per frame upload bytes. An upload budget of 0 streams everything wanted
+ * in the same frame (headless runs, so every run renders the same frames).
+ */
+void texstream_setBudget(size_t memoryBytes, size_t uploadBytes){
+    memoryBudget = memoryBytes;
+    uploadBudget = uploadBytes;
+}
+
+size_t texstream_residentBytes(){
+    return residentBytes;
+}
+
+/**
+ * @brief Note a texture on screen, covering pixels pixels per repeat of the texture.
+ */
+static void texstream_want(GLuint texture, float pixels){
+    if(texture == 0){
+        return;
+    }
+    int slot = texstream_find(texture);
+    if(slot < 0){
+        return;
+    }
+    TexStreamEntry* entry = &entries[slot];
+    entry->lastVisibleFrame = frame;
+    int texels = entry->compressed.width > entry->compressed.height ? entry->compressed.width : entry->compressed.height;
+    int level = 0;
+    if(pixels > 0.0f && pixels < (float)texels){
+        // Every level halves the texels, the finest one still minified onto the pixels is enough.
+        level = (int)floorf(log2f((float)texels / pixels)) - TEXSTREAM_LEVEL_BIAS;
+        level = level < 0 ? 0 : level;
+    }
+    if(level < entry->wantedLevel){
+        entry->wantedLevel = level;
+    }
+}
+
+static void texstream_wantMaterial(Material* material, float pixels){
+    texstream_want(material->diffuseMap, pixels);
+    texstream_want(material->specularMap, pixels);
+    texstream_want(material->shininessMap, pixels);
+    texstream_want(material->ambientMap, pixels);
+}
+
+static void texstream_transformPoint(vec3 out, mat4x4 m, vec3 point){
+    for(int row = 0; row < 3; row++){
+        out[row] = m[0][row] * point[0] + m[1][row] * point[1] + m[2][row] * point[2] + m[3][row];
+    }
+}
+
+/**
+ * @brief Sphere in view space against the planes of a projection (Gribb & Hartmann), so any camera works.
+ */
+static bool texstream_sphereInFrustum(mat4x4 projection, vec3 center, float radius){
+    for(int row = 0; row < 3; row++){
+        for(int side = -1; side <= 1; side += 2){
+            vec4 plane;
+            for(int column = 0; column < 4; column++){
+                plane[column] = projection[column][3] + side * projection[column][row];
+            }
+            float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+            if(plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius * length){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Screen height in pixels of an entity's bounding sphere, per repeat of its textures.
+ * @return negative when the bounds are outside the view frustum, behind the camera included.
+ */
+static float texstream_projectedPixels(Entity* entity, Camera* camera, float viewportHeight){
+    MeshComponent* mesh = entity->meshComponent;
+    vec3 extent;
+    vec3_sub(extent, mesh->bounds.max, mesh->bounds.min);
+    vec3 center;
+    for(int axis = 0; axis < 3; axis++){
+        center[axis] = (mesh->bounds.min[axis] + mesh->bounds.max[axis]) * 0.5f;
+    }
+    vec3 world;
+    vec3 view;
+    texstream_transformPoint(world, entity->transformComponent->transform, center);
+    texstream_transformPoint(view, camera->view, world);
+
+    float scale = 0.0f;
+    for(int column = 0; column < 3; column++){
+        float length = vec3_len(entity->transformComponent->transform[column]);
+        scale = length > scale ? length : scale;
+    }
+    float radius = vec3_len(extent) * 0.5f * scale;
+    if(!texstream_sphereInFrustum(camera->projection, view, radius)){
+        return -1.0f;
+    }
+    float depth = -view[2];
+    if(depth <= radius){
+        return FLT_MAX; // camera inside the bounds
+    }
+    float pixels = radius * camera->projection[1][1] * viewportHeight / depth;
+    float repeats = mesh->texcoordExtent > 1.0f ? mesh->texcoordExtent : 1.0f;
+    return pixels / repeats;
+}
+
+/**
+ * @brief Drop the finest level of the texture off screen the longest, or holding more than it wants.
+ * @return false when nothing can be dropped.
+ */
+static bool texstream_evictOne(const TexStreamEntry* keep){
+    TexStreamEntry* oldest = NULL;
+    for(int i = 0; i < capacity; i++){
+        TexStreamEntry* entry = &entries[i];
+        if(entry->texture == 0 || entry == keep || entry->baseLevel >= entry->minResidentLevel){
+            continue;
+        }
+        if(entry->lastVisibleFrame == frame && entry->baseLevel >= entry->wantedLevel){
+            continue; // on screen & needs what it has
+        }
+        if(oldest == NULL || entry->lastVisibleFrame < oldest->lastVisibleFrame){
+            oldest = entry;
+        }
+    }
+    if(oldest == NULL){
+        return false;
+    }
+    evictCompressedLevel(oldest->texture, oldest->format, oldest->baseLevel);
+    residentBytes -= oldest->compressed.levelSizes[oldest->baseLevel];
+    oldest->baseLevel++;
+    return true;
+}
+
+/**
+ * @brief Size the textures of everything on screen, stream in wanted levels & drop unused ones over the memory budget.
+ * Call once per frame after renderListSystem.
+ */
+void texstream_update(){
+    if(count == 0){
+        return;
+    }
+    PROFILE_BEGIN("texstream_update");
+    frame++;
+    for(int i = 0; i < capacity; i++){
+        entries[i].wantedLevel = entries[i].compressed.levelCount;
+    }
+
+    RenderLists* lists = &globals.renderLists;
+    Camera* camera = globals.views.main.camera;
+    if(camera != NULL){
+        float viewportHeight = (float)globals.views.main.rect.height;
+        for(int i = 0; i < lists->main.count; i++){
+            Entity* entity = &globals.entities[lists->main.ids[i]];
+            Material* material = getEntityMaterial(entity);
+            if(material == NULL){
+                continue;
+            }
+            float pixels = texstream_projectedPixels(entity, camera, viewportHeight);
+            if(pixels >= 0.0f){
+                texstream_wantMaterial(material, pixels);
+            }
+        }
+    }
+    for(int i = 0; i < lists->ui.count; i++){
+        Material* material = getEntityMaterial(&globals.entities[lists->ui.ids[i]]);
+        if(material != NULL){
+            texstream_wantMaterial(material, FLT_MAX); // drawn about 1:1, always full size
+        }
+    }
+
+    // Budget lowered since last frame
+    while(residentBytes > memoryBudget && texstream_evictOne(NULL)){
+    }
+
+    // One level per texture per pass, so every texture gets its coarser levels before anyone gets fine ones.
+    size_t uploaded = 0;
+    bool progress = true;
+    while(progress){
+        progress = false;
+        for(int i = 0; i < capacity; i++){
+            TexStreamEntry* entry = &entries[i];
+            if(entry->texture == 0 || entry->wantedLevel >= entry->baseLevel){
+                continue;
+            }
+            int level = entry->baseLevel - 1;
+            size_t size = entry->compressed.levelSizes[level];
+            if(uploadBudget > 0 && uploaded > 0 && uploaded + size > uploadBudget){
+                PROFILE_END();
+                return;
+            }
+            while(residentBytes + size > memoryBudget && texstream_evictOne(entry)){
+            }
+            if(residentBytes + size > memoryBudget){
+                continue; // doesn't fit, stays coarser
+            }
+            uploadCompressedLevel(entry->texture, &entry->compressed, entry->format, level);
+            entry->baseLevel = level;
+            residentBytes += size;
+            uploaded += size;
+            progress = true;
+        }
+    }
+    PROFILE_END();
+}
+
+/**
+ * @brief Unmap every streamed texture, the GL textures belong to the texture cache.
+ */
+void texstream_shutdown(){
+    for(int i = 0; i < capacity; i++){
+        if(entries[i].texture != 0){
+            texcompress_free(&entries[i].compressed);
+        }
+    }
+    free(entries);
+    entries = NULL;
+    capacity = 0;
+    count = 0;
+    residentBytes = 0;
+}
@@ -0,0 +1,39 @@
+#ifndef TEXSTREAM_H
+#define TEXSTREAM_H
+
+#include <stddef.h>
+#include "types.h"
+#include "texcompress.h"
+
+/**
+ * Texture streaming
+ * Compressed textures become resident smallest mips first. When the loader lands a .ktx, texstream_register
+ * uploads only the levels of TEXSTREAM_MIN_RESIDENT_SIZE and below and keeps the file mapped.
+ * texstream_update (once per frame, after the render lists) projects the bounds of every mesh in the main list
+ * that is inside the view frustum and works out the finest level each map of its material can show on screen, then uploads missing levels
+ * one at a time, coarse to fine, within a per frame byte budget. GL_TEXTURE_BASE_LEVEL marks the finest
+ * resident level so sampling never reaches one that isn't there. UI elements always want the full texture.
+ *
+ * Resident bytes are capped by a memory budget. Going over it drops the finest level of the texture that has
+ * been off screen the longest (respecified as 0x0), repeated until the upload fits. Dropped levels stream back
+ * in when the texture is seen again. The smallest levels are never dropped.
+ *
+ * Uncompressed textures (no .ktx, wasm & macOS) are uploaded whole by the loader and not tracked here.
+ * Handles are the GL texture names, like the texture cache. Main thread only.
+ */
+
+#define TEXSTREAM_INITIAL_CAPACITY 64                       // power of 2, grows
+#define TEXSTREAM_MAX_LOAD 0.7f
+#define TEXSTREAM_MIN_RESIDENT_SIZE 64                      // levels this wide or smaller are uploaded right away
+#define TEXSTREAM_MEMORY_BUDGET_BYTES (64 * 1024 * 1024)    // default, texstream_setBudget changes it
+#define TEXSTREAM_UPLOAD_BUDGET_BYTES (2 * 1024 * 1024)     // per frame
+#define TEXSTREAM_LEVEL_BIAS 1 // one level finer than the projected estimate, covers oblique surfaces & bounds error
+
+bool texstream_register(GLuint texture, CompressedTexture* compressed, TextureColorSpace colorSpace);
+void texstream_unregister(GLuint texture);
+void texstream_setBudget(size_t memoryBytes, size_t uploadBytes);
+void texstream_update();
+size_t texstream_residentBytes();
+void texstream_shutdown();
+
+#endif
@@ -3,6 +3,7 @@
 #include "utils.h"
 #include "globals.h"
 #include "api.h"
+#include "transform.h"
 
 ClosestLetter getCharacterByIndex(int index){
 
@@ -198,7 +199,7 @@ void selectAllText(int width, int height){
     // Set cursor to be a new width & position
     globals.entities[globals.cursorEntityId].transformComponent->position[0] = rectangleStartPos;
     globals.entities[globals.cursorEntityId].transformComponent->scale[0] = lastLetterUIpos.x;
-    globals.entities[globals.cursorEntityId].transformComponent->modelNeedsUpdate = 1;
+    transform_markDirty(globals.entities[globals.cursorEntityId].transformComponent);
     
 }
 
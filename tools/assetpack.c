@@ -0,0 +1,135 @@
+/**
+ * Asset pack builder, writes the single file the engine maps at startup (see pack.h).
+ * Directories are walked recursively, files are stored under their path as given (canonical form), so build
+ * from the repo root with the same relative paths the engine loads, e.g. "Assets" & "shaders".
+ * Mesh caches and other packs are left out, the engine only reads those as loose files.
+ * Compressed textures (.ktx) written by an earlier run are packed like any file & used as they are.
+ *
+ * Build from the repo root, with every engine file except main.c:
+ *   gcc -std=c18 -Wall -pedantic tools/assetpack.c $(ls *.c | grep -v main.c) -I/usr/include/freetype2 -lfreetype -lSDL2 -lGLESv2 -lEGL -lm -o assetpack.out
+ * Run from the repo root:
+ *   ./assetpack.out assets.fhpack Assets shaders
+ */
+#include <stdio.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <SDL2/SDL.h>
+#include "../opengl_types.h"
+#include "../types.h"
+#include "../globals.h"
+#include "../utils.h"
+#include "../pack.h"
+#include "../meshcache.h"
+
+// Stb, normally compiled in main.c
+#define STB_IMAGE_IMPLEMENTATION
+#include "../stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../stb_image_write.h"
+
+#define ASSETPACK_MAX_PATH 512
+
+struct Globals globals = {0}; // the engine files link against it, nothing here uses it
+
+static const char* skippedExtensions[] = { MESHCACHE_EXTENSION, PACK_EXTENSION };
+
+typedef struct PathList {
+    char** paths;
+    int count;
+    int capacity;
+} PathList;
+
+static void printUsage(){
+    printf("Usage: assetpack.out <output" PACK_EXTENSION "> <file or directory>...\n");
+}
+
+static bool isSkipped(const char* path){
+    size_t length = strlen(path);
+    for(size_t i = 0; i < sizeof(skippedExtensions) / sizeof(skippedExtensions[0]); i++){
+        size_t extensionLength = strlen(skippedExtensions[i]);
+        if(length >= extensionLength && strcmp(path + length - extensionLength, skippedExtensions[i]) == 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+static void addPath(PathList* list, const char* path){
+    if(list->count == list->capacity){
+        list->capacity = list->capacity == 0 ? 256 : list->capacity * 2;
+        list->paths = (char**)realloc(list->paths, list->capacity * sizeof(char*));
+        if(list->paths == NULL){
+            printf(TEXT_COLOR_ERROR "Failed to allocate path list\n" TEXT_COLOR_RESET);
+            exit(1);
+        }
+    }
+    list->paths[list->count] = (char*)malloc(strlen(path) + 1);
+    if(list->paths[list->count] == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate path list\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    strcpy(list->paths[list->count++], path);
+}
+
+/**
+ * @brief Add a file, or every file under a directory. Hidden entries are skipped.
+ */
+static bool collect(PathList* list, const char* path){
+    struct stat pathStat;
+    if(stat(path, &pathStat) != 0){
+        printf(TEXT_COLOR_ERROR "No such file or directory: %s\n" TEXT_COLOR_RESET, path);
+        return false;
+    }
+    if(!S_ISDIR(pathStat.st_mode)){
+        if(!isSkipped(path)){
+            addPath(list, path);
+        }
+        return true;
+    }
+    DIR* dir = opendir(path);
+    if(dir == NULL){
+        printf(TEXT_COLOR_ERROR "Could not open directory %s\n" TEXT_COLOR_RESET, path);
+        return false;
+    }
+    bool success = true;
+    struct dirent* entry;
+    while(success && (entry = readdir(dir)) != NULL){
+        if(entry->d_name[0] == '.'){
+            continue;
+        }
+        char child[ASSETPACK_MAX_PATH];
+        if(snprintf(child, sizeof(child), "%s/%s", path, entry->d_name) >= (int)sizeof(child)){
+            printf(TEXT_COLOR_ERROR "Path too long: %s/%s\n" TEXT_COLOR_RESET, path, entry->d_name);
+            success = false;
+            break;
+        }
+        success = collect(list, child);
+    }
+    closedir(dir);
+    return success;
+}
+
+static int comparePaths(const void* a, const void* b){
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+int main(int argc, char** argv){
+    if(argc < 3){
+        printUsage();
+        return 1;
+    }
+    PathList list = {0};
+    for(int i = 2; i < argc; i++){
+        if(!collect(&list, argv[i])){
+            return 1;
+        }
+    }
+    // Same input, same pack, whatever order readdir returns.
+    qsort(list.paths, list.count, sizeof(char*), comparePaths);
+    bool success = pack_build(argv[1], (const char* const*)list.paths, list.count);
+    for(int i = 0; i < list.count; i++){
+        free(list.paths[i]);
+    }
+    free(list.paths);
+    return success ? 0 : 1;
+}
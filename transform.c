@@ -0,0 +1,413 @@
+#include "transform.h"
+#include "globals.h"
+#include "utils.h"
+#include "jobs.h"
+#include "ecs.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define TRANSFORM_SSE 1
+#endif
+
+typedef struct TransformSubscriber {
+    TransformChangedCallback callback;
+    void* userData;
+} TransformSubscriber;
+
+static TransformSubscriber subscribers[TRANSFORM_MAX_SUBSCRIBERS];
+static int subscriberCount = 0;
+
+/**
+ * @brief Allocate the SoA streams. Matrices start as identity, rotations as identity quaternions.
+ */
+void transform_initStorage(TransformStorage* storage, int capacity){
+    storage->positions = calloc(capacity, sizeof(vec3));
+    storage->rotations = calloc(capacity, sizeof(quat));
+    storage->scales = calloc(capacity, sizeof(vec3));
+    storage->matrices = calloc(capacity, sizeof(mat4x4));
+    storage->localMatrices = calloc(capacity, sizeof(mat4x4));
+    storage->dirtyIds = calloc(capacity, sizeof(int)); // can't overflow, every id is queued at most once
+    storage->dirtyCount = 0;
+    storage->changedIds = calloc(capacity, sizeof(int));
+    storage->changedCount = 0;
+    storage->hierarchyIndex = calloc(capacity, sizeof(int));
+    storage->hierarchyOrder = calloc(capacity, sizeof(int));
+    storage->hierarchyParent = calloc(capacity, sizeof(int));
+    storage->hierarchySubtreeSize = calloc(capacity, sizeof(int));
+    storage->hierarchyWorldDirty = calloc(capacity, sizeof(bool));
+    storage->hierarchyCount = 0;
+    storage->hierarchyNeedsRebuild = false;
+    if(storage->positions == NULL || storage->rotations == NULL || storage->scales == NULL || storage->matrices == NULL 
+    || storage->localMatrices == NULL || storage->dirtyIds == NULL || storage->changedIds == NULL || storage->hierarchyIndex == NULL 
+    || storage->hierarchyOrder == NULL || storage->hierarchyParent == NULL || storage->hierarchySubtreeSize == NULL || storage->hierarchyWorldDirty == NULL){
+        printf("Failed to allocate memory for transform storage\n");
+        exit(1);
+    }
+    for(int i = 0; i < capacity; i++){
+        quat_identity(storage->rotations[i]);
+        mat4x4_identity(storage->matrices[i]);
+        mat4x4_identity(storage->localMatrices[i]);
+        storage->hierarchyIndex[i] = -1;
+    }
+}
+
+void transform_bindComponent(TransformComponent* transformComponent, TransformStorage* storage, int index){
+    transformComponent->position = storage->positions[index];
+    transformComponent->rotation = storage->rotations[index];
+    transformComponent->scale = storage->scales[index];
+    transformComponent->transform = storage->matrices[index];
+}
+
+static void transform_unlinkChild(int childId){
+    GroupComponent* child = globals.entities[childId].groupComponent;
+    if(child->parent == -1){
+        return;
+    }
+    GroupComponent* parent = globals.entities[child->parent].groupComponent;
+    if(parent->firstChild == childId){
+        parent->firstChild = child->nextSibling;
+    }else {
+        int sibling = parent->firstChild;
+        while(sibling != -1 && globals.entities[sibling].groupComponent->nextSibling != childId){
+            sibling = globals.entities[sibling].groupComponent->nextSibling;
+        }
+        if(sibling != -1){
+            globals.entities[sibling].groupComponent->nextSibling = child->nextSibling;
+        }
+    }
+    parent->childCount--;
+    child->parent = -1;
+    child->nextSibling = -1;
+}
+
+/**
+ * @brief Attach child to parent, child's position/rotation/scale become relative to the parent.
+ * @param parent NULL detaches the child and makes it a root again.
+ */
+void transform_setParent(Entity* child, Entity* parent){
+    ASSERT(parent != child, "Entity can't be its own parent");
+    // Parenting to one of its own descendants would make a loop the flattening never leaves.
+    for(Entity* ancestor = parent; ancestor != NULL; ancestor = ancestor->groupComponent->parent != -1 ? &globals.entities[ancestor->groupComponent->parent] : NULL){
+        if(ancestor == child){
+            printf(TEXT_COLOR_WARNING "Entity %d can't be parented to its descendant %d\n" TEXT_COLOR_RESET, child->id, parent->id);
+            return;
+        }
+    }
+    transform_unlinkChild(child->id);
+    child->groupComponent->active = 1;
+    if(parent != NULL){
+        parent->groupComponent->active = 1;
+        child->groupComponent->parent = parent->id;
+        child->groupComponent->nextSibling = parent->groupComponent->firstChild;
+        parent->groupComponent->firstChild = child->id;
+        parent->groupComponent->childCount++;
+    }
+    globals.transforms.hierarchyNeedsRebuild = true;
+    transform_markDirty(child->transformComponent);
+}
+
+/**
+ * @brief Take entity out of the hierarchy, its children become roots.
+ */
+void transform_removeFromHierarchy(Entity* entity){
+    if(!entity->groupComponent->active){
+        return;
+    }
+    transform_unlinkChild(entity->id);
+    int child = entity->groupComponent->firstChild;
+    while(child != -1){
+        int next = globals.entities[child].groupComponent->nextSibling;
+        globals.entities[child].groupComponent->parent = -1;
+        globals.entities[child].groupComponent->nextSibling = -1;
+        transform_markDirty(globals.entities[child].transformComponent);
+        child = next;
+    }
+    entity->groupComponent->firstChild = -1;
+    entity->groupComponent->childCount = 0;
+    entity->groupComponent->active = 0;
+    globals.transforms.hierarchyNeedsRebuild = true;
+}
+
+/**
+ * @brief Flatten the hierarchy into depth-first order. Only runs after parent/child changes.
+ */
+static void transform_rebuildHierarchy(TransformStorage* storage){
+    for(int i = 0; i < storage->hierarchyCount; i++){
+        storage->hierarchyIndex[storage->hierarchyOrder[i]] = -1;
+    }
+    storage->hierarchyCount = 0;
+
+    // Roots are entities without parent but with children. Walk each tree with an explicit stack,
+    // changedIds is free to use as stack space here since it is filled after the rebuild.
+    int* stack = storage->changedIds;
+    for(int root = 0; root < MAX_ENTITIES; root++){
+        GroupComponent* group = globals.entities[root].groupComponent;
+        if(!globals.entities[root].alive || !group->active || group->parent != -1 || group->childCount == 0){
+            continue;
+        }
+        int stackCount = 0;
+        stack[stackCount++] = root;
+        while(stackCount > 0){
+            int id = stack[--stackCount];
+            int position = storage->hierarchyCount++;
+            int parentId = globals.entities[id].groupComponent->parent;
+            storage->hierarchyIndex[id] = position;
+            storage->hierarchyOrder[position] = id;
+            storage->hierarchyParent[position] = parentId == -1 ? -1 : storage->hierarchyIndex[parentId];
+            storage->hierarchySubtreeSize[position] = 1;
+            storage->hierarchyWorldDirty[position] = false;
+            for(int child = globals.entities[id].groupComponent->firstChild; child != -1; child = globals.entities[child].groupComponent->nextSibling){
+                stack[stackCount++] = child;
+            }
+        }
+    }
+
+    // Children come after their parent, so one backwards pass accumulates subtree sizes.
+    for(int i = storage->hierarchyCount - 1; i >= 0; i--){
+        if(storage->hierarchyParent[i] != -1){
+            storage->hierarchySubtreeSize[storage->hierarchyParent[i]] += storage->hierarchySubtreeSize[i];
+        }
+    }
+    storage->hierarchyNeedsRebuild = false;
+}
+
+/**
+ * @brief Set rotation from euler angles in radians.
+ * Same order as the old euler path (rotate X, then Y, then Z), so q = qx * qy * qz.
+ */
+void transform_setEulerRotation(TransformComponent* transformComponent, float x, float y, float z){
+    quat qx, qy, qz, qxy;
+    quat_rotate(qx, x, (vec3){1.0f, 0.0f, 0.0f});
+    quat_rotate(qy, y, (vec3){0.0f, 1.0f, 0.0f});
+    quat_rotate(qz, z, (vec3){0.0f, 0.0f, 1.0f});
+    quat_mul(qxy, qx, qy);
+    quat_mul(transformComponent->rotation, qxy, qz);
+    transform_markDirty(transformComponent);
+}
+
+/**
+ * @brief Rotate around a local axis, angle in radians.
+ */
+void transform_rotateLocal(TransformComponent* transformComponent, float angle, vec3 axis){
+    quat delta, result;
+    quat_rotate(delta, angle, axis);
+    quat_mul(result, transformComponent->rotation, delta);
+    quat_norm(transformComponent->rotation, result);
+    transform_markDirty(transformComponent);
+}
+
+static void transform_composeScalar(TransformStorage* storage, int index){
+    const float* q = storage->rotations[index];
+    const float* p = storage->positions[index];
+    const float* s = storage->scales[index];
+    float (*m)[4] = storage->localMatrices[index];
+
+    float x2 = q[0] + q[0], y2 = q[1] + q[1], z2 = q[2] + q[2];
+    float xx = q[0] * x2, yy = q[1] * y2, zz = q[2] * z2;
+    float xy = q[0] * y2, xz = q[0] * z2, yz = q[1] * z2;
+    float wx = q[3] * x2, wy = q[3] * y2, wz = q[3] * z2;
+
+    // Column major, scale applies to rows since model = T * S * R.
+    m[0][0] = s[0] * (1.0f - (yy + zz));
+    m[0][1] = s[1] * (xy + wz);
+    m[0][2] = s[2] * (xz - wy);
+    m[0][3] = 0.0f;
+
+    m[1][0] = s[0] * (xy - wz);
+    m[1][1] = s[1] * (1.0f - (xx + zz));
+    m[1][2] = s[2] * (yz + wx);
+    m[1][3] = 0.0f;
+
+    m[2][0] = s[0] * (xz + wy);
+    m[2][1] = s[1] * (yz - wx);
+    m[2][2] = s[2] * (1.0f - (xx + yy));
+    m[2][3] = 0.0f;
+
+    m[3][0] = p[0];
+    m[3][1] = p[1];
+    m[3][2] = p[2];
+    m[3][3] = 1.0f;
+}
+
+#ifdef TRANSFORM_SSE
+/**
+ * @brief Compose 4 transforms at once. Lanes hold one transform each,
+ * results are transposed back into the per-entity column major matrices.
+ */
+static void transform_composeSSE4(TransformStorage* storage, const int* indices){
+    const int i0 = indices[0], i1 = indices[1], i2 = indices[2], i3 = indices[3];
+
+    __m128 qx = _mm_loadu_ps(storage->rotations[i0]);
+    __m128 qy = _mm_loadu_ps(storage->rotations[i1]);
+    __m128 qz = _mm_loadu_ps(storage->rotations[i2]);
+    __m128 qw = _mm_loadu_ps(storage->rotations[i3]);
+    _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+    const float* p0 = storage->positions[i0]; const float* p1 = storage->positions[i1];
+    const float* p2 = storage->positions[i2]; const float* p3 = storage->positions[i3];
+    const float* s0 = storage->scales[i0]; const float* s1 = storage->scales[i1];
+    const float* s2 = storage->scales[i2]; const float* s3 = storage->scales[i3];
+    __m128 sx = _mm_setr_ps(s0[0], s1[0], s2[0], s3[0]);
+    __m128 sy = _mm_setr_ps(s0[1], s1[1], s2[1], s3[1]);
+    __m128 sz = _mm_setr_ps(s0[2], s1[2], s2[2], s3[2]);
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 x2 = _mm_add_ps(qx, qx), y2 = _mm_add_ps(qy, qy), z2 = _mm_add_ps(qz, qz);
+    __m128 xx = _mm_mul_ps(qx, x2), yy = _mm_mul_ps(qy, y2), zz = _mm_mul_ps(qz, z2);
+    __m128 xy = _mm_mul_ps(qx, y2), xz = _mm_mul_ps(qx, z2), yz = _mm_mul_ps(qy, z2);
+    __m128 wx = _mm_mul_ps(qw, x2), wy = _mm_mul_ps(qw, y2), wz = _mm_mul_ps(qw, z2);
+
+    // cRr = column c, row r for all 4 transforms
+    __m128 c0r0 = _mm_mul_ps(sx, _mm_sub_ps(one, _mm_add_ps(yy, zz)));
+    __m128 c0r1 = _mm_mul_ps(sy, _mm_add_ps(xy, wz));
+    __m128 c0r2 = _mm_mul_ps(sz, _mm_sub_ps(xz, wy));
+    __m128 c1r0 = _mm_mul_ps(sx, _mm_sub_ps(xy, wz));
+    __m128 c1r1 = _mm_mul_ps(sy, _mm_sub_ps(one, _mm_add_ps(xx, zz)));
+    __m128 c1r2 = _mm_mul_ps(sz, _mm_add_ps(yz, wx));
+    __m128 c2r0 = _mm_mul_ps(sx, _mm_add_ps(xz, wy));
+    __m128 c2r1 = _mm_mul_ps(sy, _mm_sub_ps(yz, wx));
+    __m128 c2r2 = _mm_mul_ps(sz, _mm_sub_ps(one, _mm_add_ps(xx, yy)));
+    __m128 zero = _mm_setzero_ps();
+
+    _MM_TRANSPOSE4_PS(c0r0, c0r1, c0r2, zero);
+    _mm_storeu_ps(storage->localMatrices[i0][0], c0r0);
+    _mm_storeu_ps(storage->localMatrices[i1][0], c0r1);
+    _mm_storeu_ps(storage->localMatrices[i2][0], c0r2);
+    _mm_storeu_ps(storage->localMatrices[i3][0], zero);
+
+    zero = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(c1r0, c1r1, c1r2, zero);
+    _mm_storeu_ps(storage->localMatrices[i0][1], c1r0);
+    _mm_storeu_ps(storage->localMatrices[i1][1], c1r1);
+    _mm_storeu_ps(storage->localMatrices[i2][1], c1r2);
+    _mm_storeu_ps(storage->localMatrices[i3][1], zero);
+
+    zero = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(c2r0, c2r1, c2r2, zero);
+    _mm_storeu_ps(storage->localMatrices[i0][2], c2r0);
+    _mm_storeu_ps(storage->localMatrices[i1][2], c2r1);
+    _mm_storeu_ps(storage->localMatrices[i2][2], c2r2);
+    _mm_storeu_ps(storage->localMatrices[i3][2], zero);
+
+    _mm_storeu_ps(storage->localMatrices[i0][3], _mm_setr_ps(p0[0], p0[1], p0[2], 1.0f));
+    _mm_storeu_ps(storage->localMatrices[i1][3], _mm_setr_ps(p1[0], p1[1], p1[2], 1.0f));
+    _mm_storeu_ps(storage->localMatrices[i2][3], _mm_setr_ps(p2[0], p2[1], p2[2], 1.0f));
+    _mm_storeu_ps(storage->localMatrices[i3][3], _mm_setr_ps(p3[0], p3[1], p3[2], 1.0f));
+}
+#endif
+
+/**
+ * @brief Rebuild the local matrices of the given entity indices from position, rotation & scale.
+ */
+void transform_composeBatch(TransformStorage* storage, const int* indices, int count){
+    int i = 0;
+    #ifdef TRANSFORM_SSE
+    for(; i + 4 <= count; i += 4){
+        transform_composeSSE4(storage, &indices[i]);
+    }
+    #endif
+    for(; i < count; i++){
+        transform_composeScalar(storage, indices[i]);
+    }
+}
+
+/**
+ * @brief Entity index of a component, components are bound 1:1 to the storage slots.
+ */
+int transform_indexOf(TransformComponent* transformComponent){
+    return (int)((vec3*)transformComponent->position - globals.transforms.positions);
+}
+
+/**
+ * @brief Queue transform for matrix rebuild. Cheap to call several times per frame, the id is only queued once.
+ */
+void transform_markDirty(TransformComponent* transformComponent){
+    if(transformComponent->modelNeedsUpdate){
+        return;
+    }
+    transformComponent->modelNeedsUpdate = 1;
+    globals.transforms.dirtyIds[globals.transforms.dirtyCount++] = transform_indexOf(transformComponent);
+}
+
+void transform_subscribe(TransformChangedCallback callback, void* userData){
+    if(subscriberCount >= TRANSFORM_MAX_SUBSCRIBERS){
+        printf(TEXT_COLOR_ERROR "Too many transform subscribers, increase TRANSFORM_MAX_SUBSCRIBERS\n" TEXT_COLOR_RESET);
+        exit(1);
+    }
+    subscribers[subscriberCount].callback = callback;
+    subscribers[subscriberCount].userData = userData;
+    subscriberCount++;
+}
+
+static void transform_composeRange(void* data, int start, int end){
+    TransformStorage* storage = (TransformStorage*)data;
+    transform_composeBatch(storage, &storage->dirtyIds[start], end - start);
+}
+
+/**
+ * @brief Rebuild matrices of all queued transforms, propagate world matrices down dirty subtrees,
+ * notify subscribers & clear the queue.
+ * @return number of world matrices that changed.
+ */
+int transform_flushDirty(TransformStorage* storage){
+    int count = storage->dirtyCount;
+    storage->changedCount = 0;
+    if(count == 0 && !storage->hierarchyNeedsRebuild){
+        return 0;
+    }
+    if(storage->hierarchyNeedsRebuild){
+        transform_rebuildHierarchy(storage);
+    }
+
+    // Small batches aren't worth waking the workers for.
+    jobs_parallelFor(count, 256, transform_composeRange, storage);
+
+    // Entities outside a hierarchy: world = local. Inside: flag the whole subtree,
+    // if the first entry is already flagged an ancestor already flagged all of it.
+    int sweepStart = storage->hierarchyCount;
+    int sweepEnd = 0;
+    for(int i = 0; i < count; i++){
+        int id = storage->dirtyIds[i];
+        int position = storage->hierarchyIndex[id];
+        if(position == -1){
+            memcpy(storage->matrices[id], storage->localMatrices[id], sizeof(mat4x4));
+            storage->changedIds[storage->changedCount++] = id;
+            continue;
+        }
+        if(storage->hierarchyWorldDirty[position]){
+            continue;
+        }
+        int end = position + storage->hierarchySubtreeSize[position];
+        for(int j = position; j < end; j++){
+            storage->hierarchyWorldDirty[j] = true;
+        }
+        sweepStart = position < sweepStart ? position : sweepStart;
+        sweepEnd = end > sweepEnd ? end : sweepEnd;
+    }
+
+    // Single linear pass, parents are always before their children.
+    for(int i = sweepStart; i < sweepEnd; i++){
+        if(!storage->hierarchyWorldDirty[i]){
+            continue;
+        }
+        int id = storage->hierarchyOrder[i];
+        int parent = storage->hierarchyParent[i];
+        if(parent == -1){
+            memcpy(storage->matrices[id], storage->localMatrices[id], sizeof(mat4x4));
+        }else {
+            mat4x4_mul(storage->matrices[id], (const float (*)[4])storage->matrices[storage->hierarchyOrder[parent]], (const float (*)[4])storage->localMatrices[id]);
+        }
+        storage->hierarchyWorldDirty[i] = false;
+        storage->changedIds[storage->changedCount++] = id;
+    }
+
+    for(int i = 0; i < subscriberCount; i++){
+        subscribers[i].callback(storage->changedIds, storage->changedCount, subscribers[i].userData);
+    }
+
+    for(int i = 0; i < count; i++){
+        globals.entities[storage->dirtyIds[i]].transformComponent->modelNeedsUpdate = 0;
+    }
+    storage->dirtyCount = 0;
+    return storage->changedCount;
+}
@@ -0,0 +1,36 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "types.h"
+
+/**
+ * Transform storage & batch TRS -> matrix composition.
+ * Transforms are stored as structure of arrays (positions, quaternion rotations, scales, matrices)
+ * so the compose kernel can stream through them 4 at a time with SSE, scalar fallback elsewhere.
+ * Matrix layout is the same as before: model = T * S * R.
+ *
+ * Writes to a transform should be followed by transform_markDirty, which queues the entity id once.
+ * modelSystem flushes the queue and subscribers (culling, bounds, shadow caches..) get the list of changed ids.
+ *
+ * Hierarchy: transform_setParent links entities through their GroupComponent. The tree is flattened in
+ * depth-first order, so a dirty parent only costs a linear sweep over its contiguous subtree.
+ * Main thread only.
+ */
+
+#define TRANSFORM_MAX_SUBSCRIBERS 8
+
+typedef void (*TransformChangedCallback)(const int* entityIds, int count, void* userData);
+
+void transform_initStorage(TransformStorage* storage, int capacity);
+void transform_bindComponent(TransformComponent* transformComponent, TransformStorage* storage, int index);
+void transform_setEulerRotation(TransformComponent* transformComponent, float x, float y, float z);
+void transform_rotateLocal(TransformComponent* transformComponent, float angle, vec3 axis);
+void transform_composeBatch(TransformStorage* storage, const int* indices, int count);
+int transform_indexOf(TransformComponent* transformComponent);
+void transform_markDirty(TransformComponent* transformComponent);
+void transform_subscribe(TransformChangedCallback callback, void* userData);
+int transform_flushDirty(TransformStorage* storage);
+void transform_setParent(Entity* child, Entity* parent);
+void transform_removeFromHierarchy(Entity* entity);
+
+#endif
@@ -18,12 +18,40 @@ typedef struct Color {
     GLfloat  a;
 } Color;
 
+// Extra block of a growable arena, data follows the header.
+typedef struct ArenaBlock {
+    struct ArenaBlock* previous;
+    size_t size;
+    size_t used;
+} ArenaBlock;
+
 typedef struct Arena {
     size_t size;  // Total size of the memory block
     size_t used;  // Amount of memory already used
     void* base;   // Pointer to the base of the memory block
+    bool growable;        // chain more blocks instead of running out, see arena_initScratch
+    ArenaBlock* overflow; // newest chained block, NULL while everything fits in base
 } Arena;
 
+// Position in an arena to rewind to, see arena_mark.
+typedef struct ArenaMark {
+    ArenaBlock* overflow;
+    size_t used;
+} ArenaMark;
+
+// Whole file in memory, mapped where the platform allows it (see mapFile).
+typedef struct MappedFile {
+    void* data;
+    size_t size;
+} MappedFile;
+
+// What a cache file was built from, stored in it & compared on load (see sourceStampMatches).
+typedef struct SourceStamp {
+    uint64_t size;
+    int64_t modified;
+    uint64_t hash;      // FNV-1a 64 of the whole file
+} SourceStamp;
+
 typedef enum {
     SPLIT_DEFAULT = 0,
     SPLIT_HORIZONTAL = 1,
@@ -116,6 +144,49 @@ typedef struct Vertex {
     vec3 normal;
 } Vertex;
 
+// How a mesh's vertices are stored on the gpu. Meshes are always built as Vertex arrays,
+// setupMesh packs them into the layout. All zero is the plain float layout (44 bytes).
+typedef enum VertexPositionFormat {
+    VERTEX_POSITION_FLOAT = 0,
+    VERTEX_POSITION_UNORM16 = 1 // relative to the mesh bounds, positionScale/positionOffset undo it in the shader
+} VertexPositionFormat;
+
+typedef enum VertexUvFormat {
+    VERTEX_UV_FLOAT = 0,
+    VERTEX_UV_HALF = 1,
+    VERTEX_UV_UNORM16 = 2 // only for uvs in [0,1], meshes that wrap fall back to half
+} VertexUvFormat;
+
+typedef enum VertexNormalFormat {
+    VERTEX_NORMAL_FLOAT = 0,
+    VERTEX_NORMAL_OCT16 = 1,         // octahedral mapping into 2 snorm16, decoded in the shader
+    VERTEX_NORMAL_INT_2_10_10_10 = 2 // 10 bits per axis, no shader change needed
+} VertexNormalFormat;
+
+typedef struct VertexLayout {
+    VertexPositionFormat position;
+    bool dropColor; // no shader reads vertex color for lit meshes, the attribute is fed a constant white
+    VertexUvFormat uv;
+    VertexNormalFormat normal;
+} VertexLayout;
+
+#define VERTEX_LAYOUT_FULL ((VertexLayout){VERTEX_POSITION_FLOAT, false, VERTEX_UV_FLOAT, VERTEX_NORMAL_FLOAT})
+// 8 + 4 + 4 = 16 bytes per vertex instead of 44
+#define VERTEX_LAYOUT_COMPACT ((VertexLayout){VERTEX_POSITION_UNORM16, true, VERTEX_UV_HALF, VERTEX_NORMAL_OCT16})
+
+// Vertices & indices already in gpu format, see packMesh/setupPackedMesh.
+typedef struct PackedMesh {
+    VertexLayout layout;
+    vec3 positionScale;
+    vec3 positionOffset;
+    GLsizei stride;
+    int vertexCount;
+    const void* vertices;
+    int indexCount;
+    GLenum indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    const void* indices;
+} PackedMesh;
+
 typedef struct Line {
     vec3 position;
 } Line;
@@ -132,6 +203,22 @@ typedef struct Texture {
     char* type;
 } Texture;
 
+typedef enum TextureColorSpace {
+    TEXTURE_COLORSPACE_SRGB,   // colors (diffuse, ambient), stored as sRGB when globals.gamma is on
+    TEXTURE_COLORSPACE_LINEAR  // data (specular, shininess, alpha), never converted
+} TextureColorSpace;
+
+// How a texture is sampled & stored. Part of the texture cache key, the same image can be loaded with different params.
+typedef struct TextureParams {
+    GLint wrap;      // s & t
+    GLint minFilter;
+    GLint magFilter;
+    TextureColorSpace colorSpace;
+} TextureParams;
+
+#define TEXTURE_PARAMS_COLOR ((TextureParams){GL_REPEAT, GL_LINEAR_MIPMAP_NEAREST, GL_LINEAR, TEXTURE_COLORSPACE_SRGB})
+#define TEXTURE_PARAMS_DATA  ((TextureParams){GL_REPEAT, GL_LINEAR_MIPMAP_NEAREST, GL_LINEAR, TEXTURE_COLORSPACE_LINEAR})
+
 #define MATERIAL_DIFFUSEMAP_ENABLED   (1 << 0) // 0b00000001
 #define MATERIAL_SPECULARMAP_ENABLED  (1 << 1) // 0b00000010
 #define MATERIAL_AMBIENTMAP_ENABLED   (1 << 2) // 0b00000100
@@ -146,6 +233,16 @@ typedef enum {
     BLINN_ENABLED =        1 << 4,
 } Material_flags;
 
+// Texture maps a material can load from file, indexes Material.mapPaths.
+typedef enum {
+    MATERIAL_MAP_DIFFUSE = 0,
+    MATERIAL_MAP_SPECULAR = 1,
+    MATERIAL_MAP_SHININESS = 2,
+    MATERIAL_MAP_AMBIENT = 3,
+    MATERIAL_MAP_ALPHA = 4,
+    MATERIAL_MAP_COUNT = 5
+} MaterialMap;
+
 typedef struct Material {
     bool active;
     char* name;
@@ -165,6 +262,7 @@ typedef struct Material {
     float ior;
     GLuint alpha;
     bool isPostProcessMaterial;
+    char* mapPaths[MATERIAL_MAP_COUNT]; // image file behind each map, NULL if not loaded from file. Used by scene snapshots.
 } Material;
 
 typedef struct GpuData {
@@ -175,17 +273,27 @@ typedef struct GpuData {
     GLuint RBO;
     GLuint shaderProgram;
     GLuint numIndicies;
+    GLenum indexType; // GL_UNSIGNED_SHORT when every index fits, otherwise GL_UNSIGNED_INT
     GLuint vertexCount;
     GLenum drawMode;
+    VertexLayout vertexLayout; // set before setupMesh, see VertexLayout
+    vec3 positionScale;        // dequantizes VERTEX_POSITION_UNORM16, 1 and 0 for float positions
+    vec3 positionOffset;
 } GpuData;
 
 // Data we get from obj-loader/parser.
 // Child struct in ObjGroup.
 typedef struct ObjData {
     char* name;
+    const char* materialName; // usemtl name, NULL if none. obj_bindMaterials turns it into materialIndex
     int materialIndex; // index in globals.materials
-    Vertex* vertexData;
+    Vertex* vertexData; // unique vertices, NULL when loaded from the mesh cache
     int num_of_vertices;
+    GLuint* indices;    // 3 per triangle into vertexData
+    int num_of_indices;
+    BoundingBox bounds;
+    PackedMesh packed;  // set instead of vertexData & indices by the mesh cache, points into its mapping.
+                        // Async loads pack on the job thread too, then both are set.
 } ObjData;
 
 // Data we get from obj-loader/parser. 
@@ -194,6 +302,7 @@ typedef struct ObjGroup {
     const char* name;
     int objectCount;
     ObjData* objData;
+    bool hasMtllib;
 } ObjGroup;
 
 // Not used atm, but will be when we implement .obj group(g) support. 
@@ -276,19 +385,60 @@ typedef struct Vector2{
     float y;
 } Vector2;
 
+// Position, rotation, scale & transform point into the TransformStorage streams (SoA) at the entity's index.
 typedef struct TransformComponent {
     bool active;
-    bool modelNeedsUpdate;
-    vec3 position;
-    vec3 rotation;
-    vec3 scale;
-    mat4x4 transform;
+    bool modelNeedsUpdate;   // true while queued in TransformStorage.dirtyIds, set through transform_markDirty.
+    float* position;         // vec3
+    float* rotation;         // quat (x,y,z,w), use transform_setEulerRotation to set from angles.
+    float* scale;            // vec3
+    float (*transform)[4];   // mat4x4
 } TransformComponent;
 
+// Structure of arrays backing every TransformComponent, indexed by entity id.
+typedef struct TransformStorage {
+    vec3* positions;
+    quat* rotations;
+    vec3* scales;
+    mat4x4* matrices;
+    mat4x4* localMatrices;
+    int* dirtyIds;     // deduplicated by TransformComponent.modelNeedsUpdate
+    int dirtyCount;
+    int* changedIds;   // ids whose world matrix changed in the last flush
+    int changedCount;
+
+    // Hierarchy flattened in depth-first order, a subtree is the contiguous range [index, index + subtreeSize).
+    int* hierarchyIndex;      // entity id -> position in hierarchyOrder, -1 when not part of a hierarchy
+    int* hierarchyOrder;      // position -> entity id
+    int* hierarchyParent;     // position -> position of parent, -1 for roots
+    int* hierarchySubtreeSize;// position -> number of entries in subtree including itself
+    bool* hierarchyWorldDirty;// position -> needs world matrix rebuild
+    int hierarchyCount;
+    bool hierarchyNeedsRebuild;
+} TransformStorage;
+
+// Entity ids drawn by one render pass, rebuilt every frame by renderListSystem.
+typedef struct RenderList {
+    int* ids;
+    int count;
+} RenderList;
+
+typedef struct RenderLists {
+    RenderList shadow;
+    RenderList main;
+    RenderList linesAndPoints;
+    RenderList ui;
+    RenderList uiText;
+} RenderLists;
+
+// Scene hierarchy links, entity ids (-1 = none). Set through transform_setParent.
+// The world matrix of a child ends up in its TransformComponent.transform, position/rotation/scale are local to the parent.
 typedef struct GroupComponent {
     bool active;
-    mat4x4 transform;
-    //Entity* children
+    int parent;
+    int firstChild;
+    int nextSibling;
+    int childCount;
 } GroupComponent;
 
 typedef struct MeshComponent {
@@ -298,7 +448,10 @@ typedef struct MeshComponent {
     size_t vertexCount;
     unsigned int* indices;
     size_t indexCount;
+    const PackedMesh* packedMesh; // uploaded as is instead of vertices/indices, from the mesh cache
     GpuData* gpuData;
+    BoundingBox bounds;     // local space, set by uploadMesh
+    float texcoordExtent;   // widest texcoord range, times a texture repeats across the mesh
 } MeshComponent;
 
 // This is a line segment component atm. 
@@ -376,17 +529,10 @@ typedef struct LightComponent {
 
 typedef struct MaterialComponent {
     bool active;
-    int materialIndex; // index in globals.materials
-    Color ambient;
+    int materialIndex; // handle from addMaterial, the material itself is shared by every entity using it
+    // Per entity tint, starts as the material's. Ui highlights change it.
     Color diffuse;
-    Color specular;
-    float shininess;
-    GLuint diffuseMap;
     GLfloat diffuseMapOpacity;
-    GLuint specularMap;
-    unsigned int material_flags;
-    bool isPostProcessMaterial;
-  //  Texture* normalMap;
 } MaterialComponent;
 
 typedef struct BoundingBoxComponent {
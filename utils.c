@@ -1,7 +1,25 @@
 #include "utils.h"
 #include "globals.h"
 #include <ctype.h>
+#include <limits.h>
 #include "stb_image_write.h"
+#include "profiler.h"
+#include "capture.h"
+#include "meshopt.h"
+#include "jobs.h"
+#include "meshcache.h"
+#include "texcache.h"
+#include "pack.h"
+#include <sys/stat.h>
+
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+    #define UTILS_USE_MMAP 0
+#else
+    #define UTILS_USE_MMAP 1
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
 
 
 /**
@@ -51,8 +69,16 @@ Color hexToColor(const char *hex)
     return color;
 }
 
-char *readFile(const char *filename)
+/**
+ * @brief Whole file as a 0 terminated string. Files in the asset pack come straight from its mapping,
+ * others are read into a malloc'd copy. Either way hand the result to freeFile.
+ */
+const char* readFile(const char *filename)
 {
+    PackView view;
+    if(pack_find(filename, &view)){
+        return (const char*)view.data; // the pack puts a 0 after every file
+    }
 
     FILE *fp;
 
@@ -91,6 +117,224 @@ char *readFile(const char *filename)
     return buffer;
 }
 
+void freeFile(const char* data){
+    if(data != NULL && !pack_contains(data)){
+        free((void*)data);
+    }
+}
+
+/**
+ * @brief Map a whole file into memory, one sequential read on platforms without mmap.
+ * The mapping is private & writable, edits get copy on write pages and never reach the file.
+ * Empty or missing files return false.
+ */
+bool mapFile(const char* path, MappedFile* file){
+    #if UTILS_USE_MMAP
+    int fd = open(path, O_RDONLY);
+    if(fd == -1){
+        return false;
+    }
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) == -1 || fileStat.st_size <= 0){
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(NULL, (size_t)fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED){
+        return false;
+    }
+    file->data = mapped;
+    file->size = (size_t)fileStat.st_size;
+    return true;
+    #else
+    FILE* fp = fopen(path, "rb");
+    if(fp == NULL){
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    long fileSize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if(fileSize <= 0){
+        fclose(fp);
+        return false;
+    }
+    void* buffer = malloc((size_t)fileSize);
+    if(buffer == NULL || fread(buffer, 1, (size_t)fileSize, fp) != (size_t)fileSize){
+        free(buffer);
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+    file->data = buffer;
+    file->size = (size_t)fileSize;
+    return true;
+    #endif
+}
+
+/**
+ * @brief Lexical canonical form of a path: '\' becomes '/', repeated separators and "." segments go away and
+ * ".." removes the segment before it. The file system is not touched, symlinks aren't resolved.
+ */
+void canonicalPath(const char* path, char* out, size_t outSize){
+    size_t length = 0;
+    size_t root = 0; // out[0..root) is never folded away, "/" or leading ".."s
+    if(path[0] == '/' || path[0] == '\\'){
+        out[length++] = '/';
+        root = 1;
+    }
+    const char* segment = path;
+    while(*segment != '\0'){
+        while(*segment == '/' || *segment == '\\'){
+            segment++;
+        }
+        const char* end = segment;
+        while(*end != '\0' && *end != '/' && *end != '\\'){
+            end++;
+        }
+        size_t segmentLength = (size_t)(end - segment);
+        if(segmentLength == 0 || (segmentLength == 1 && segment[0] == '.')){
+            segment = end;
+            continue;
+        }
+        if(segmentLength == 2 && segment[0] == '.' && segment[1] == '.' && length > root){
+            // Drop the last segment & its separator
+            while(length > root && out[length - 1] != '/'){
+                length--;
+            }
+            if(length > root){
+                length--;
+            }
+            segment = end;
+            continue;
+        }
+        if(length > 0 && out[length - 1] != '/'){
+            out[length++] = '/';
+        }
+        if(length + segmentLength + 1 > outSize){
+            break;
+        }
+        memcpy(out + length, segment, segmentLength);
+        length += segmentLength;
+        if(segmentLength == 2 && segment[0] == '.' && segment[1] == '.'){
+            root = length; // nothing above to fold into
+        }
+        segment = end;
+    }
+    out[length] = '\0';
+}
+
+/**
+ * @brief Size & modification time (seconds) of a file, false if it doesn't exist.
+ */
+bool getFileInfo(const char* path, uint64_t* size, int64_t* modified){
+    struct stat fileStat;
+    if(stat(path, &fileStat) != 0){
+        return false;
+    }
+    *size = (uint64_t)fileStat.st_size;
+    *modified = (int64_t)fileStat.st_mtime;
+    return true;
+}
+
+/**
+ * @brief FNV-1a 64 bit. Pass HASH_SEED, or the result of an earlier call to hash several pieces as one.
+ */
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size){
+    const unsigned char* bytes = (const unsigned char*)data;
+    for(size_t i = 0; i < size; i++){
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool hashFile(const char* path, uint64_t* hash){
+    MappedFile file;
+    if(!mapFile(path, &file)){
+        return false;
+    }
+    *hash = hashBytes(HASH_SEED, file.data, file.size);
+    unmapFile(&file);
+    return true;
+}
+
+/**
+ * @brief Size, time & content hash of a file, to store in a cache built from it.
+ */
+bool getSourceStamp(const char* path, SourceStamp* stamp){
+    return getFileInfo(path, &stamp->size, &stamp->modified) && hashFile(path, &stamp->hash);
+}
+
+/**
+ * @brief Is a cache still from this source. Size & time first, the content hash only when the time changed.
+ * @param stampOffset where stamp is in the cache file, the new time is written there when only the time changed.
+ */
+bool sourceStampMatches(const char* sourcePath, const SourceStamp* stamp, const char* cachePath, long stampOffset){
+    uint64_t size;
+    int64_t modified;
+    if(!getFileInfo(sourcePath, &size, &modified) || stamp->size != size){
+        return false;
+    }
+    if(stamp->modified == modified){
+        return true;
+    }
+    uint64_t hash;
+    if(!hashFile(sourcePath, &hash) || hash != stamp->hash){
+        return false;
+    }
+    // Same content, store the new time so the next load skips hashing.
+    FILE* fp = fopen(cachePath, "r+b");
+    if(fp != NULL){
+        fseek(fp, stampOffset + (long)offsetof(SourceStamp, modified), SEEK_SET);
+        fwrite(&modified, sizeof(modified), 1, fp);
+        fclose(fp);
+    }
+    return true;
+}
+
+/**
+ * @brief Open a uniquely named file next to path for writing a new version of it, closeReplacingFile renames it
+ * over path. Readers that mapped the old file keep its pages and nobody sees a half written one. Safe from jobs.
+ */
+FILE* openReplacingFile(const char* path, char* tempPath, size_t tempPathSize){
+    static SDL_atomic_t counter;
+    snprintf(tempPath, tempPathSize, "%s.%d.tmp", path, SDL_AtomicAdd(&counter, 1));
+    return fopen(tempPath, "wb");
+}
+
+/**
+ * @brief Close a file from openReplacingFile & move it over path.
+ * @param written false when a write already failed, the temp file is removed then.
+ * @return true if path now holds the new file.
+ */
+bool closeReplacingFile(FILE* fp, const char* tempPath, const char* path, bool written){
+    bool success = ferror(fp) == 0 && written;
+    success = fclose(fp) == 0 && success;
+    #ifdef _WIN32
+    if(success){
+        remove(path); // rename doesn't replace there, files are read into memory (no mmap) so nothing holds the old one
+    }
+    #endif
+    if(success && rename(tempPath, path) != 0){
+        success = false;
+    }
+    if(!success){
+        remove(tempPath);
+    }
+    return success;
+}
+
+void unmapFile(MappedFile* file){
+    #if UTILS_USE_MMAP
+    munmap(file->data, file->size);
+    #else
+    free(file->data);
+    #endif
+    file->data = NULL;
+    file->size = 0;
+}
+
 // Get a random number from 0 to 255
 int randInt(int rmin, int rmax) {
     return rand() % rmax + rmin;
@@ -100,8 +344,14 @@ float randFloat(float rmin, float rmax) {
 }
 
 unsigned char* loadImage(const char* filename, int* width, int* height, int* nrChannels){
-    stbi_set_flip_vertically_on_load(1); 
-    unsigned char* result = stbi_load(filename, width, height, nrChannels, 0);
+    stbi_set_flip_vertically_on_load_thread(1); // per thread, images decode on the job threads too
+    PackView view;
+    unsigned char* result;
+    if(pack_find(filename, &view)){
+        result = stbi_load_from_memory((const stbi_uc*)view.data, (int)view.size, width, height, nrChannels, 0);
+    }else {
+        result = stbi_load(filename, width, height, nrChannels, 0);
+    }
     if(result == NULL) {
         
         printf(TEXT_COLOR_ERROR "Error loading image %s" TEXT_COLOR_RESET "\n", filename);
@@ -115,184 +365,201 @@ float deg2rad(float degrees) {
 }
 
 
-/**
- * Parses faceline in loadObj.
- * example: "f 1/2/3 4/5/6 7/8/9";
- * If the line is a quad, it will be split into two triangles and add one additional faceLineCount.
- */
-void obj_handleFaceLine(char* line, int* vf, int* tf, int* vn, int* vfCount, int* tfCount, int* vnCount, int* faceLineCount) {
-   
-   int num_slashes = 0;
-   int spaceCount = 0;
-  
-   bool isSlash = false;
-   bool hasTextureData = true;
-   char tempNumber[10];
-   int tempNumberIndex = 0;
-   int tokenIndex = 0;
-   int tokensArr[12] = {0};
-   char* linePtr = (line+2); // skip f and space
-   while(*linePtr != '\0'){
-
-       //printf("linePtr--------: %c\n", *linePtr);
-       //printf("tknIndex-------: %d\n", tokenIndex);
-    
-       if(*linePtr == ' '){
-           spaceCount++;
-           tempNumber[tempNumberIndex] = '\0'; // Null-terminate the string
-           int num = atoi(tempNumber);
-           tokensArr[tokenIndex] = num;
-           tokenIndex++;
-           //printf("space num: %d\n", num);
-           tempNumberIndex = 0;
-           isSlash = false;
-       }
-       else if(*linePtr == '/'){
-         num_slashes++;
-         if(isSlash){
-            //printf("this is a double slash\n");
-            hasTextureData = false;
-         }
-         if(tempNumberIndex > 0){
-            tempNumber[tempNumberIndex] = '\0'; // Null-terminate the string
-            int num = atoi(tempNumber);
-            tokensArr[tokenIndex] = num;
-            tokenIndex++;
-            tempNumberIndex = 0;
-           // printf("slash num: %d\n", num);
-         }
-         isSlash = true;
-       }
-       else{
-        tempNumber[tempNumberIndex] = *linePtr;
-        tempNumberIndex++;
-        isSlash = false;
-       }
-       linePtr++;
-   }
-   // Pick up the last number
-   if(tempNumberIndex > 0){
-         tempNumber[tempNumberIndex] = '\0'; // Null-terminate the string
-         int num = atoi(tempNumber);
-         tokensArr[tokenIndex] = num;
-        // printf("last num: %d\n", num);
-   }
+//----------------------------------------------------------------------------------------------//
+// OBJ tokenizer. Reads straight from the mapped file, nothing is copied per line.
+// Every parse function stops at the end it's given (the end of the line) and returns where it stopped.
+//----------------------------------------------------------------------------------------------//
 
+static const double obj_powersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
 
-     // if has texture and is triangle,the token count should be 9
-    // tokenIndex 0 , 3 , 6 is v
-    // tokenIndex 1 , 4 , 7 is vt
-    // tokenIndex 2 , 5 , 8 is vn
-   // if has texture and is quad, the token count should be 12
-    // tokenIndex 0 , 3 , 6 , 9 is v
-    // tokenIndex 1 , 4 , 7 , 10 is vt
-    // tokenIndex 2 , 5 , 8 , 11 is vn
-   // if has no texture and is triangle, the token count should be 6
-    // tokenIndex 0 , 2 , 4 is v
-    // tokenIndex 1 , 3 , 5 is vn
-   // if has no texture and is quad, the token count should be 8
-    // tokenIndex 0 , 2 , 4 , 6 is v
-    // tokenIndex 1 , 3 , 5 , 7 is vn
-    if(hasTextureData){
-            vf[*vfCount] = tokensArr[0];
-            (*vfCount)++;
-            tf[*tfCount] = tokensArr[1];
-            (*tfCount)++;
-            vn[*vnCount] = tokensArr[2];
-            (*vnCount)++;
-            vf[*vfCount] = tokensArr[3];
-            (*vfCount)++;
-            tf[*tfCount] = tokensArr[4];
-            (*tfCount)++;
-            vn[*vnCount] = tokensArr[5];
-            (*vnCount)++;
-            vf[*vfCount] = tokensArr[6];
-            (*vfCount)++;
-            tf[*tfCount] = tokensArr[7];
-            (*tfCount)++;
-            vn[*vnCount] = tokensArr[8];
-            (*vnCount)++;
-        if(spaceCount > 2){
-
-           // printf("Quad with texture(uv) data\n");
-            
-            //First triangle: v1/vt1/vn1 v2/vt2/vn2 v3/vt3/vn3
-            //Second triangle: v1/vt1/vn1 v3/vt3/vn3 v4/vt4/vn4
-
-            // First vertex
-            vf[*vfCount] = tokensArr[0];
-            (*vfCount)++;
-            tf[*tfCount] = tokensArr[1];
-            (*tfCount)++;
-            vn[*vnCount] = tokensArr[2];
-            (*vnCount)++;
-
-            // Second vertex
-            vf[*vfCount] = tokensArr[6];
-            (*vfCount)++;
-            tf[*tfCount] = tokensArr[7];
-            (*tfCount)++;
-            vn[*vnCount] = tokensArr[8];
-            (*vnCount)++;
-
-            // Third vertex
-            vf[*vfCount] = tokensArr[9];
-            (*vfCount)++;
-            tf[*tfCount] = tokensArr[10];
-            (*tfCount)++;
-            vn[*vnCount] = tokensArr[11];
-            (*vnCount)++;
-
-            // We create additional triangle so we need to increment faceLineCount
-            (*faceLineCount)++;
+static bool obj_isDigit(char c){
+    return (unsigned)(c - '0') < 10;
+}
+
+static const char* obj_skipSpaces(const char* p, const char* end){
+    while(p < end && (*p == ' ' || *p == '\t')){
+        p++;
+    }
+    return p;
+}
 
+/**
+ * Locale independent float parser for obj numbers: [sign] digits [. digits] [e [sign] digits].
+ * Keeps 19 significant digits, more than a float can hold, and scales once by a power of 10.
+ * @returns position after the number, p if there is no number (out is set to 0).
+ */
+static const char* obj_parseFloat(const char* p, const char* end, float* out){
+    const char* start = p;
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        p++;
+    }
+    uint64_t mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    while(p < end && obj_isDigit(*p)){
+        if(significantDigits < 19){
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            significantDigits += mantissa != 0;
         }else {
-          //  printf("Triangle with texture(uv) data\n");
+            exponent++;
         }
-    }else {
-        vf[*vfCount] = tokensArr[0];
-        (*vfCount)++;
-        vn[*vnCount] = tokensArr[1];
-        (*vnCount)++;
-        vf[*vfCount] = tokensArr[2];
-        (*vfCount)++;
-        vn[*vnCount] = tokensArr[3];
-        (*vnCount)++;
-        vf[*vfCount] = tokensArr[4];
-        (*vfCount)++;
-        vn[*vnCount] = tokensArr[5];
-        (*vnCount)++;
-        if(spaceCount > 2){
-        
-            //First triangle: v1//vn1 v2//vn2 v3//vn3
-            //Second triangle: v1//vn1 v3//vn3 v4//vn4
-
-            // First vertex
-            vf[*vfCount] = tokensArr[0];
-            (*vfCount)++;
-            vn[*vnCount] = tokensArr[1];
-            (*vnCount)++;
-            // Second vertex
-            vf[*vfCount] = tokensArr[4];
-            (*vfCount)++;
-            vn[*vnCount] = tokensArr[5];
-            (*vnCount)++;
-            // Third vertex
-            vf[*vfCount] = tokensArr[6];
-            (*vfCount)++;
-            vn[*vnCount] = tokensArr[7];
-            (*vnCount)++;
-
-            // We create additional triangle so we need to increment faceLineCount
-            (*faceLineCount)++;
-            //printf("Quad without texture(uv) data\n");
+        anyDigit = true;
+        p++;
+    }
+    if(p < end && *p == '.'){
+        p++;
+        while(p < end && obj_isDigit(*p)){
+            if(significantDigits < 19){
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                significantDigits += mantissa != 0;
+                exponent--;
+            }
+            anyDigit = true;
+            p++;
+        }
+    }
+    if(!anyDigit){
+        *out = 0.0f;
+        return start;
+    }
+    if(p < end && (*p == 'e' || *p == 'E')){
+        const char* e = p + 1;
+        bool negativeExponent = false;
+        if(e < end && (*e == '-' || *e == '+')){
+            negativeExponent = *e == '-';
+            e++;
+        }
+        if(e < end && obj_isDigit(*e)){
+            int value = 0;
+            while(e < end && obj_isDigit(*e)){
+                if(value < 10000){
+                    value = value * 10 + (*e - '0');
+                }
+                e++;
+            }
+            exponent += negativeExponent ? -value : value;
+            p = e;
+        }
+    }
+    double value = (double)mantissa;
+    while(exponent > 22){
+        value *= 1e22;
+        exponent -= 22;
+    }
+    while(exponent < -22){
+        value /= 1e22;
+        exponent += 22;
+    }
+    value = exponent < 0 ? value / obj_powersOf10[-exponent] : value * obj_powersOf10[exponent];
+    *out = (float)(negative ? -value : value);
+    return p;
+}
 
-        }else {
-           // printf("Triangle without texture(uv) data\n");
+/**
+ * @returns position after the integer, p if there is none.
+ */
+static const char* obj_parseInt(const char* p, const char* end, int* out){
+    const char* start = p;
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        p++;
+    }
+    const char* digits = p;
+    int value = 0;
+    while(p < end && obj_isDigit(*p)){
+        if(value < 100000000){
+            value = value * 10 + (*p - '0');
         }
+        p++;
+    }
+    if(p == digits){
+        return start;
     }
+    *out = negative ? -value : value;
+    return p;
+}
 
-    (*faceLineCount)++;
+/**
+ * Parse n floats separated by spaces into out, missing ones become 0.
+ */
+static const char* obj_parseFloats(const char* p, const char* end, float* out, int n){
+    for(int i = 0; i < n; i++){
+        p = obj_parseFloat(obj_skipSpaces(p, end), end, &out[i]);
+    }
+    return p;
+}
+
+/**
+ * Parse one face corner: v, v/vt, v//vn or v/vt/vn into corner (position, uv, normal).
+ * Missing indices are 0. Negative indices count back from the last element read so far (counts).
+ * @returns position after the corner, p if there is none.
+ */
+static const char* obj_parseFaceCorner(const char* p, const char* end, const int counts[3], int corner[3]){
+    corner[0] = corner[1] = corner[2] = 0;
+    const char* next = obj_parseInt(p, end, &corner[0]);
+    if(next == p){
+        return p;
+    }
+    p = next;
+    if(p < end && *p == '/'){
+        p = obj_parseInt(p + 1, end, &corner[1]);
+        if(p < end && *p == '/'){
+            p = obj_parseInt(p + 1, end, &corner[2]);
+        }
+    }
+    for(int i = 0; i < 3; i++){
+        if(corner[i] < 0){
+            corner[i] += counts[i] + 1;
+        }
+    }
+    return p;
+}
+
+/**
+ * Parses a face line in obj_importFile, p points past the "f".
+ * example: "f 1/2/3 4/5/6 7/8/9", "f 7//7 8//8 9//9" or "f 1 2 3 4"
+ * Quads & other polygons are split into a triangle fan (v1 v2 v3, v1 v3 v4, ..), each triangle adds one to faceLineCount.
+ * vf/tf/vn get one entry per triangle corner, so they always line up.
+ * @returns false if the corners don't fit in capacity.
+ */
+static bool obj_parseFaceLine(const char* p, const char* end, const int counts[3], int* vf, int* tf, int* vn, int* cornerCount, int capacity, int* faceLineCount){
+    int first[3];
+    int previous[3];
+    int corner[3];
+    int polygonCorners = 0;
+    while(true){
+        p = obj_skipSpaces(p, end);
+        const char* next = obj_parseFaceCorner(p, end, counts, corner);
+        if(next == p){
+            break;
+        }
+        p = next;
+        if(polygonCorners == 0){
+            memcpy(first, corner, sizeof(first));
+        }else if(polygonCorners >= 2){
+            if(*cornerCount + 3 > capacity){
+                return false;
+            }
+            const int* triangle[3] = {first, previous, corner};
+            for(int i = 0; i < 3; i++){
+                vf[*cornerCount] = triangle[i][0];
+                tf[*cornerCount] = triangle[i][1];
+                vn[*cornerCount] = triangle[i][2];
+                (*cornerCount)++;
+            }
+            (*faceLineCount)++;
+        }
+        memcpy(previous, corner, sizeof(previous));
+        polygonCorners++;
+    }
+    return true;
 }
 
 /**
@@ -301,27 +568,37 @@ void obj_handleFaceLine(char* line, int* vf, int* tf, int* vn, int* vfCount, int
  */
 void obj_runTests()
 {
-   char line[] =  "f 1/2/3 4/5/6 7/8/9"; // 9
-   char line2[] = "f 7//7 8//8 9//9"; // 6
-   char line3[] = "f 7//7 8//8 9//9 10//10"; // 8
-   char line4[] = "f 7555555//55555557 83333333//833333333 222222229//222222229"; // 6
-   char line5[] = "f 1/2/3 4/5/6 7/8/9 3/3/3"; // 12
-
-   int vf[300000] = {0}; 
-   int tf[300000] = {0}; 
-   int vn[300000] = {0};
-  
+   const char* lines[] = {
+       "f 1/2/3 4/5/6 7/8/9",          // 1 triangle
+       "f 7//7 8//8 9//9",             // 1 triangle, no uvs
+       "f 7//7 8//8 9//9 10//10",      // quad, 2 triangles
+       "f 7555555//55555557 83333333//833333333 222222229//222222229",
+       "f 1/2/3 4/5/6 7/8/9 3/3/3",    // quad, 2 triangles
+       "f -3/-3/-3 -2/-2/-2 -1/-1/-1", // relative, 8/8/8 9/9/9 10/10/10
+       "f 1 2 3 4 5",                  // pentagon, 3 triangles
+   };
+   const char* floats = "v -1.5 2e3 .25 1E-2 -0.000001 123456789.123"; // -1.5 2000 0.25 0.01 -1e-06 1.23457e+08
+
+   int vf[64] = {0}; 
+   int tf[64] = {0}; 
+   int vn[64] = {0};
+   int counts[3] = {10, 10, 10};
+   int cornerCount = 0;
    int faceLineCount = 0;
-   
-   int vfCount = 0;
-   int tfCount = 0;
-   int vnCount = 0; 
 
-   obj_handleFaceLine(line,  vf, tf, vn, &vfCount, &tfCount, &vnCount, &faceLineCount);
-   obj_handleFaceLine(line2, vf, tf, vn, &vfCount, &tfCount, &vnCount, &faceLineCount);
-   obj_handleFaceLine(line3, vf, tf, vn, &vfCount, &tfCount, &vnCount, &faceLineCount);
-   obj_handleFaceLine(line4, vf, tf, vn, &vfCount, &tfCount, &vnCount, &faceLineCount);
-   obj_handleFaceLine(line5, vf, tf, vn, &vfCount, &tfCount, &vnCount, &faceLineCount);
+   for(int i = 0; i < (int)(sizeof(lines) / sizeof(lines[0])); i++){
+       obj_parseFaceLine(lines[i] + 1, lines[i] + strlen(lines[i]), counts, vf, tf, vn, &cornerCount, 64, &faceLineCount);
+   }
+   printf("%d triangles\n", faceLineCount);
+   for(int i = 0; i < cornerCount; i++){
+       printf("%d/%d/%d%s", vf[i], tf[i], vn[i], i % 3 == 2 ? "\n" : " ");
+   }
+   float values[6];
+   obj_parseFloats(floats + 1, floats + strlen(floats), values, 6);
+   for(int i = 0; i < 6; i++){
+       printf("%g ", values[i]);
+   }
+   printf("\n");
 
    // Exit program after tests
    exit(0);
@@ -341,8 +618,22 @@ void arena_initMemory(Arena* arena, size_t size) {
         exit(1);  // Exit or handle the error as appropriate
     }
     arena->used = 0;
+    arena->growable = false;
+    arena->overflow = NULL;
+}
+
+/**
+ * Arena for temporary memory. Never runs out, when the base block is full it chains blocks of at least
+ * the same size. Take an arena_mark before allocating and arena_rewind to it when done.
+ */
+void arena_initScratch(Arena* arena, size_t size) {
+    arena_initMemory(arena, size);
+    arena->growable = true;
 }
 
+#define ARENA_ALIGNMENT 16
+#define ARENA_BLOCK_HEADER (((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT) * ARENA_ALIGNMENT)
+
 void* arena_Alloc(Arena* arena, size_t size) {
     // Debug output
     /* printf("size i want to allocate: %zu \n",size);
@@ -350,21 +641,64 @@ void* arena_Alloc(Arena* arena, size_t size) {
     printf("arena size: %zu \n",arena->size);
     printf("arena left: %zu \n",arena->size-arena->used); */
    
-    if (arena->used + size > arena->size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (arena->overflow == NULL && arena->used + size <= arena->size) {
+        void* ptr = (char*)arena->base + arena->used;
+        arena->used += size;
+        return ptr;
+    }
+    if (!arena->growable) {
         fprintf(stderr, "Arena out of memory\n");
         exit(1);
     }
-    void* ptr = (char*)arena->base + arena->used;
-    arena->used += size;
-    
+    ArenaBlock* block = arena->overflow;
+    if (block == NULL || block->used + size > block->size) {
+        size_t blockSize = size > arena->size ? size : arena->size;
+        block = (ArenaBlock*)malloc(ARENA_BLOCK_HEADER + blockSize);
+        if (block == NULL) {
+            fprintf(stderr, "Arena out of memory\n");
+            exit(1);
+        }
+        block->previous = arena->overflow;
+        block->size = blockSize;
+        block->used = 0;
+        arena->overflow = block;
+    }
+    void* ptr = (char*)block + ARENA_BLOCK_HEADER + block->used;
+    block->used += size;
     return ptr;
 }
+
+ArenaMark arena_mark(Arena* arena) {
+    ArenaMark mark;
+    mark.overflow = arena->overflow;
+    mark.used = arena->overflow != NULL ? arena->overflow->used : arena->used;
+    return mark;
+}
+
+/**
+ * Free everything allocated after mark. Chained blocks newer than the mark go back to the system.
+ */
+void arena_rewind(Arena* arena, ArenaMark mark) {
+    while (arena->overflow != mark.overflow) {
+        ArenaBlock* previous = arena->overflow->previous;
+        free(arena->overflow);
+        arena->overflow = previous;
+    }
+    if (arena->overflow != NULL) {
+        arena->overflow->used = mark.used;
+    } else {
+        arena->used = mark.used;
+    }
+}
+
 // Not evaluated yet, do this before using
 void arena_reset(Arena* arena) {
-    arena->used = 0;
+    arena_rewind(arena, (ArenaMark){NULL, 0});
 }
 // Not evaluated yet, do this before using 
 void arena_free(Arena* arena) {
+    arena_reset(arena);
     free(arena->base);
     arena->base = NULL;
     arena->used = 0;
@@ -433,7 +767,7 @@ char* obj_handleFilePath(const char* filepath){
     return newPath;
 }
 
-bool obj_processTextureMap(char* mtlLine,const char* mapType,GLuint* map){
+bool obj_processTextureMap(char* mtlLine,const char* mapType,MaterialMap mapKind,GLuint* map,char** path){
     
     if(strncmp(mtlLine, mapType, strlen(mapType)) == 0){
             char* token = strtok(mtlLine, " ");
@@ -446,9 +780,12 @@ bool obj_processTextureMap(char* mtlLine,const char* mapType,GLuint* map){
             } */
 
             char* filepath = obj_handleFilePath(token);
-            TextureData texture = loadTexture(filepath);
-            
-            *map = setupTexture(texture);
+            // Shared with every material using the same file, placeholder until the image has decoded.
+            // A material naming the map twice keeps the last one, the reference to the first is dropped.
+            GLuint previous = *map;
+            *map = texcache_acquire(filepath, texcache_mapParams(mapKind));
+            texcache_release(previous);
+            *path = filepath; // arena allocated, lives as long as the material
             //printf("mapType %s ID: %d \n",mapType,map);
             return true;
     }
@@ -456,6 +793,25 @@ bool obj_processTextureMap(char* mtlLine,const char* mapType,GLuint* map){
     return false;  
 }
 
+/**
+ * @brief fgets over a file in memory: the next line with its '\n', split when longer than lineSize - 1.
+ */
+static bool obj_readLine(const char** cursor, const char* end, char* line, size_t lineSize){
+    if(*cursor >= end){
+        return false;
+    }
+    size_t length = 0;
+    while(*cursor < end && length + 1 < lineSize){
+        char c = *(*cursor)++;
+        line[length++] = c;
+        if(c == '\n'){
+            break;
+        }
+    }
+    line[length] = '\0';
+    return true;
+}
+
 /**
  * Parse .mtl file.
  * spec: https://en.wikipedia.org/wiki/Wavefront_.obj_file
@@ -471,20 +827,28 @@ void obj_parseMaterial(const char *filepath){
     dest = strcat(dot, dest);
     dest = strcat(dest, ".mtl"); 
     
-    // Open .mtl file
-    FILE* mtlfp;
-    char mtlLine[1024];
-
-    mtlfp = fopen(dest, "r");
-    if(mtlfp == NULL) {
-        printf(TEXT_COLOR_ERROR "Error opening file %s" TEXT_COLOR_RESET "\n", dest);
-        exit(1);
+    // Open .mtl file, from the asset pack or mapped
+    MappedFile mtlFile = {0};
+    PackView view;
+    if(pack_find(dest, &view)){
+        mtlFile.data = (void*)view.data;
+        mtlFile.size = view.size;
+    }else if(!mapFile(dest, &mtlFile)){
+        uint64_t size;
+        int64_t modified;
+        if(!getFileInfo(dest, &size, &modified) || size != 0){ // empty files don't map, nothing to parse
+            printf(TEXT_COLOR_ERROR "Error opening file %s" TEXT_COLOR_RESET "\n", dest);
+            exit(1);
+        }
     }
+    const char* mtlCursor = (const char*)mtlFile.data;
+    const char* mtlEnd = mtlCursor + mtlFile.size;
+    char mtlLine[1024];
 
     int materialParsedLineCount = 0;
 
     // Parse .mtl file
-    while (fgets(mtlLine, sizeof mtlLine, mtlfp) != NULL){
+    while (obj_readLine(&mtlCursor, mtlEnd, mtlLine, sizeof mtlLine)){
         materialParsedLineCount++;
      //   printf("materialParsedLineCount: %d \n",materialParsedLineCount);
         //printf("parsing material line: %s \n",mtlLine);
@@ -500,15 +864,13 @@ void obj_parseMaterial(const char *filepath){
         if(strncmp(mtlLine, "newmtl", 6) == 0){
            char* token = strtok(mtlLine, " ");
            token = strtok(NULL, " ");
-           token[strlen(token)] = '\0';
-           // TODO: Does this clash with addMaterial-fn ?
-           globals.materials[globals.materialsCount].active = true;
-           globals.materials[globals.materialsCount].name = (char*)arena_Alloc(&globals.assetArena, (strlen(token) + 1) * sizeof(char));
-           strcpy(globals.materials[globals.materialsCount].name, token);
-           globals.materialsCount++;
-          // printf("new globals.materialsCount %d \n",globals.materialsCount);
-        
-           ASSERT(globals.materialsCount < globals.materialsCapacity, "Material count exceeds capacity");
+           token[strcspn(token, "\r\n")] = '\0';
+           // The lines below fill in the last added material.
+           addMaterial((Material){
+               .active = true,
+               .name = token,
+               .shininess = 32.0f, // for .mtl files without Ns
+           });
            //printf("new material %s \n",globals.materials[globals.materialsCount-1].name);
            continue;
         }
@@ -545,8 +907,8 @@ void obj_parseMaterial(const char *filepath){
             continue;
         } 
         if((strncmp(mtlLine, "Ns", 2) == 0)){
-            sscanf(mtlLine, "Ns %f", &globals.materials[globals.materialsCount-1].transparency);
-            //printf("transparency %f \n",globals.materials[globals.materialsCount-1].transparency);
+            sscanf(mtlLine, "Ns %f", &globals.materials[globals.materialsCount-1].shininess);
+            //printf("shininess %f \n",globals.materials[globals.materialsCount-1].shininess);
             continue;
         } 
         
@@ -594,28 +956,28 @@ void obj_parseMaterial(const char *filepath){
         //  The options and their arguments are inserted between the 
         //  keyword and the "filename". 
         //  map_Ka -options args filename
-        if(obj_processTextureMap(mtlLine,"map_Ka", &globals.materials[globals.materialsCount-1].ambientMap)){
+        if(obj_processTextureMap(mtlLine,"map_Ka", MATERIAL_MAP_AMBIENT, &globals.materials[globals.materialsCount-1].ambientMap, &globals.materials[globals.materialsCount-1].mapPaths[MATERIAL_MAP_AMBIENT])){
             globals.materials[globals.materialsCount-1].material_flags |= MATERIAL_AMBIENTMAP_ENABLED;
             continue;
         }
         //map_Kd   lemur.tga
-        if(obj_processTextureMap(mtlLine,"map_Kd", &globals.materials[globals.materialsCount-1].diffuseMap)){
+        if(obj_processTextureMap(mtlLine,"map_Kd", MATERIAL_MAP_DIFFUSE, &globals.materials[globals.materialsCount-1].diffuseMap, &globals.materials[globals.materialsCount-1].mapPaths[MATERIAL_MAP_DIFFUSE])){
             globals.materials[globals.materialsCount-1].diffuseMapOpacity = 1.0;
             globals.materials[globals.materialsCount-1].material_flags |= MATERIAL_DIFFUSEMAP_ENABLED;
             continue;
         }
         //map_Ks   lemur.tga   specular color map
-        if(obj_processTextureMap(mtlLine,"map_Ks", &globals.materials[globals.materialsCount-1].specularMap)){
+        if(obj_processTextureMap(mtlLine,"map_Ks", MATERIAL_MAP_SPECULAR, &globals.materials[globals.materialsCount-1].specularMap, &globals.materials[globals.materialsCount-1].mapPaths[MATERIAL_MAP_SPECULAR])){
             globals.materials[globals.materialsCount-1].material_flags |= MATERIAL_SPECULARMAP_ENABLED;
             continue;
         }
         //map_Ns   lemur_spec.tga specular intensity map
-        if(obj_processTextureMap(mtlLine,"map_Ns", &globals.materials[globals.materialsCount-1].shininessMap)){
+        if(obj_processTextureMap(mtlLine,"map_Ns", MATERIAL_MAP_SHININESS, &globals.materials[globals.materialsCount-1].shininessMap, &globals.materials[globals.materialsCount-1].mapPaths[MATERIAL_MAP_SHININESS])){
             globals.materials[globals.materialsCount-1].material_flags |= MATERIAL_SHININESSMAP_ENABLED;
             continue;
         }
         //map_d    lemur_alpha.tga (alpha)
-        if(obj_processTextureMap(mtlLine,"map_d", &globals.materials[globals.materialsCount-1].alpha)){
+        if(obj_processTextureMap(mtlLine,"map_d", MATERIAL_MAP_ALPHA, &globals.materials[globals.materialsCount-1].alpha, &globals.materials[globals.materialsCount-1].mapPaths[MATERIAL_MAP_ALPHA])){
             continue;
         } 
        
@@ -649,331 +1011,627 @@ void obj_parseMaterial(const char *filepath){
         //map_RMA
         //map_ORM
     }
-    fclose(mtlfp);
+    if(mtlFile.data != NULL && !pack_contains(mtlFile.data)){
+        unmapFile(&mtlFile);
+    }
     
     printf("------------------------------------\n");
     printf("Material parsing done\n");
     printf("------------------------------------\n");
 }
 
+typedef struct ObjVertexSlot {
+    int v, t, n; // obj position, uv & normal index of a face corner
+    int index;   // into the unique vertices, -1 = empty slot
+} ObjVertexSlot;
+
+/**
+ * Turn face corners [start, end) of the vf/tf/vn lists into unique vertices + an index buffer.
+ * Corners with the same position, uv & normal index share a vertex, found through an open addressing hash table.
+ * Vertices & indices are malloc'd so this can run on job threads, obj_importFile moves them into its arena.
+ * uv & normal indices past uvCount/normalCount count as missing, some exporters write those.
+ * Triangles with a position index outside [1, positionCount] are dropped, there is no vertex to read for them.
+ */
+static void obj_buildIndexedMesh(ObjData* obj, int start, int end, int* vf, int* tf, int* vn, float* vArr, float* tArr, float* nArr, int positionCount, int uvCount, int normalCount){
+    int cornerCount = end - start;
+    obj->indices = (GLuint*)malloc((cornerCount > 0 ? cornerCount : 1) * sizeof(GLuint));
+
+    // Power of 2, at most half full
+    int tableSize = 16;
+    while(tableSize < cornerCount * 2){
+        tableSize <<= 1;
+    }
+    ObjVertexSlot* table = (ObjVertexSlot*)malloc(tableSize * sizeof(ObjVertexSlot));
+    Vertex* unique = (Vertex*)malloc((cornerCount > 0 ? cornerCount : 1) * sizeof(Vertex));
+    if(table == NULL || unique == NULL || obj->indices == NULL){
+        printf(TEXT_COLOR_ERROR "Failed to allocate memory for vertex deduplication" TEXT_COLOR_RESET "\n");
+        exit(1);
+    }
+    for(int i = 0; i < tableSize; i++){
+        table[i].index = -1;
+    }
+
+    int uniqueCount = 0;
+    int indexCount = 0;
+    for(int corner = start; corner < end; corner++){
+        if((corner - start) % 3 == 0){
+            bool valid = true;
+            for(int i = corner; i < corner + 3 && i < end; i++){
+                valid = valid && vf[i] >= 1 && vf[i] <= positionCount;
+            }
+            if(!valid){
+                corner += 2; // the loop skips the third
+                continue;
+            }
+        }
+        int v = vf[corner];
+        int t = tf[corner] <= uvCount ? tf[corner] : 0;
+        int n = vn[corner] <= normalCount ? vn[corner] : 0;
+        uint32_t hash = (uint32_t)v * 73856093u ^ (uint32_t)t * 19349663u ^ (uint32_t)n * 83492791u;
+        uint32_t slot = hash & (tableSize - 1);
+        while(table[slot].index != -1 && (table[slot].v != v || table[slot].t != t || table[slot].n != n)){
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if(table[slot].index == -1){
+            table[slot].v = v;
+            table[slot].t = t;
+            table[slot].n = n;
+            table[slot].index = uniqueCount;
+
+            Vertex* vertex = &unique[uniqueCount++];
+            vertex->position[0] = vArr[(v-1)*3];
+            vertex->position[1] = vArr[(v-1)*3+1];
+            vertex->position[2] = vArr[(v-1)*3+2];
+            // color, default to white atm
+            vertex->color[0] = 1.0;
+            vertex->color[1] = 1.0;
+            vertex->color[2] = 1.0;
+            if(t > 0){
+                vertex->texcoord[0] = tArr[(t-1)*2];
+                vertex->texcoord[1] = tArr[(t-1)*2+1];
+            }else {
+                vertex->texcoord[0] = 0.0;
+                vertex->texcoord[1] = 0.0;
+            }
+            if(n > 0){
+                vertex->normal[0] = nArr[(n-1)*3];
+                vertex->normal[1] = nArr[(n-1)*3+1];
+                vertex->normal[2] = nArr[(n-1)*3+2];
+            }else {
+                vertex->normal[0] = 0.0;
+                vertex->normal[1] = 0.0;
+                vertex->normal[2] = 0.0;
+            }
+        }
+        obj->indices[indexCount++] = table[slot].index;
+    }
+    if(indexCount < cornerCount){
+        printf(TEXT_COLOR_WARNING "Dropped %d triangles of %s with a missing vertex position\n" TEXT_COLOR_RESET, (cornerCount - indexCount) / 3, obj->name != NULL ? obj->name : "an object");
+    }
+
+    obj->num_of_indices = indexCount;
+    obj->num_of_vertices = uniqueCount;
+    obj->vertexData = unique;
+    free(table);
+
+    for(int i = 0; i < uniqueCount; i++){
+        for(int axis = 0; axis < 3; axis++){
+            float p = unique[i].position[axis];
+            if(i == 0 || p < obj->bounds.min[axis]) obj->bounds.min[axis] = p;
+            if(i == 0 || p > obj->bounds.max[axis]) obj->bounds.max[axis] = p;
+        }
+    }
+}
+
+// Overdraw sorting costs up to MESHOPT_OVERDRAW_THRESHOLD in vertex cache efficiency, 0 keeps the pure vertex cache order.
+#define OBJ_OPTIMIZE_OVERDRAW 1
+
 /**
- * String search in globals.materials on provided name.
- * @param name name to search for.
- * @returns materialIndex in globals.materials or -1 if no hits
+ * Reorder an imported mesh for the gpu (see meshopt.h), with vertex cache stats before and after.
  */
-int getMaterialByName(const char* name){
-    //printf("getMaterialByName %s\n",name);
-    //printf("globals.materialsCount %d\n",globals.materialsCount);
-    for(int i = 0; i < globals.materialsCount; i++){
-      //  printf("globals.materials[i].name %s\n",globals.materials[i].name);
-        if(strncmp(globals.materials[i].name,name,strlen(name)-1) == 0){
-           // printf("found material %s at index %d\n",name,i);
-            return i;
-        } 
+static void obj_optimizeMesh(ObjData* obj, MeshCacheStats* before, MeshCacheStats* after){
+    *before = meshopt_analyzeVertexCache(obj->indices, obj->num_of_indices, obj->num_of_vertices);
+    meshopt_optimizeVertexCache(obj->indices, obj->num_of_indices, obj->num_of_vertices);
+    if(OBJ_OPTIMIZE_OVERDRAW){
+        meshopt_optimizeOverdraw(obj->indices, obj->num_of_indices, obj->vertexData, obj->num_of_vertices, MESHOPT_OVERDRAW_THRESHOLD);
+    }
+    meshopt_optimizeVertexFetch(obj->vertexData, obj->indices, obj->num_of_indices, obj->num_of_vertices);
+    *after = meshopt_analyzeVertexCache(obj->indices, obj->num_of_indices, obj->num_of_vertices);
+}
+
+// OBJ files are parsed in chunks of at least this size, split at line ends.
+#define OBJ_CHUNK_MIN_SIZE (256 * 1024)
+#define OBJ_MAX_CHUNKS 256
+
+typedef enum ObjLineType {
+    OBJ_LINE_OTHER,
+    OBJ_LINE_POSITION, // v
+    OBJ_LINE_UV,       // vt
+    OBJ_LINE_NORMAL,   // vn
+    OBJ_LINE_FACE,     // f
+    OBJ_LINE_MTLLIB,
+    OBJ_LINE_OBJECT,   // o
+    OBJ_LINE_GROUP,    // g
+    OBJ_LINE_USEMTL
+} ObjLineType;
+
+// Lines that change object/material state, replayed in file order on the main thread after parsing.
+typedef struct ObjEvent {
+    ObjLineType type;
+    const char* line;  // into the mapped file
+    size_t lineLength;
+    int faceLineCount; // triangles before this line, whole file
+} ObjEvent;
+
+typedef struct ObjChunk {
+    const char* start;
+    const char* end;
+    // Counted in the first pass, prefix summed into the bases the second pass writes at.
+    int positionCount;
+    int uvCount;
+    int normalCount;
+    int cornerCount;
+    int positionBase;
+    int uvBase;
+    int normalBase;
+    int cornerBase;
+    ObjEvent* events;
+    int eventCount;
+    int eventCapacity;
+} ObjChunk;
+
+typedef struct ObjParseJob {
+    ObjChunk* chunks;
+    float* vArr;
+    float* tArr;
+    float* nArr;
+    int* vf;
+    int* tf;
+    int* vn;
+} ObjParseJob;
+
+typedef struct ObjBuildJob {
+    ObjGroup* objGroup;
+    int* faceLineCountStart;
+    int* faceLineCountEnd;
+    ObjParseJob* parse;
+    int positionCount;
+    int uvCount;
+    int normalCount;
+    MeshCacheStats* before;
+    MeshCacheStats* after;
+} ObjBuildJob;
+
+/**
+ * Next line in [*p, end) without its line break & leading spaces. Advances *p to the line after.
+ */
+static const char* obj_nextLine(const char** p, const char* end, const char** lineEnd){
+    const char* newline = memchr(*p, '\n', end - *p);
+    const char* next = newline != NULL ? newline + 1 : end;
+    const char* last = newline != NULL ? newline : end;
+    if(last > *p && last[-1] == '\r'){
+        last--;
+    }
+    const char* line = obj_skipSpaces(*p, last);
+    *lineEnd = last;
+    *p = next;
+    return line;
+}
+
+static ObjLineType obj_lineType(const char* line, const char* lineEnd){
+    size_t lineLength = lineEnd - line;
+    if(lineLength == 0 || line[0] == '#'){
+        return OBJ_LINE_OTHER;
+    }
+    if(line[0] == 'v' && lineLength > 1){
+        if(line[1] == ' ' || line[1] == '\t') return OBJ_LINE_POSITION;
+        if(line[1] == 't') return OBJ_LINE_UV;
+        if(line[1] == 'n') return OBJ_LINE_NORMAL;
+        return OBJ_LINE_OTHER;
+    }
+    if(line[0] == 'f') return OBJ_LINE_FACE;
+    if(line[0] == 'o') return OBJ_LINE_OBJECT;
+    if(line[0] == 'g') return OBJ_LINE_GROUP;
+    if(lineLength >= 6 && strncmp(line, "mtllib", 6) == 0) return OBJ_LINE_MTLLIB;
+    if(lineLength >= 6 && strncmp(line, "usemtl", 6) == 0) return OBJ_LINE_USEMTL;
+    return OBJ_LINE_OTHER;
+}
+
+/**
+ * Triangle corners obj_parseFaceLine will write for this face line.
+ */
+static int obj_countFaceCorners(const char* p, const char* end){
+    const int counts[3] = {0, 0, 0};
+    int corner[3];
+    int polygonCorners = 0;
+    while(true){
+        p = obj_skipSpaces(p, end);
+        const char* next = obj_parseFaceCorner(p, end, counts, corner);
+        if(next == p){
+            break;
+        }
+        p = next;
+        polygonCorners++;
+    }
+    return polygonCorners >= 3 ? (polygonCorners - 2) * 3 : 0;
+}
+
+/**
+ * First pass: count the elements of each chunk so every chunk knows where its output goes.
+ */
+static void obj_countChunks(void* data, int start, int end){
+    ObjParseJob* job = (ObjParseJob*)data;
+    for(int i = start; i < end; i++){
+        ObjChunk* chunk = &job->chunks[i];
+        const char* p = chunk->start;
+        while(p < chunk->end){
+            const char* lineEnd;
+            const char* line = obj_nextLine(&p, chunk->end, &lineEnd);
+            switch(obj_lineType(line, lineEnd)){
+                case OBJ_LINE_POSITION: chunk->positionCount++; break;
+                case OBJ_LINE_UV:       chunk->uvCount++; break;
+                case OBJ_LINE_NORMAL:   chunk->normalCount++; break;
+                case OBJ_LINE_FACE:     chunk->cornerCount += obj_countFaceCorners(line + 1, lineEnd); break;
+                default: break;
+            }
+        }
+    }
+}
+
+static void obj_addEvent(ObjChunk* chunk, ObjLineType type, const char* line, const char* lineEnd, int faceLineCount){
+    if(chunk->eventCount == chunk->eventCapacity){
+        chunk->eventCapacity = chunk->eventCapacity > 0 ? chunk->eventCapacity * 2 : 16;
+        chunk->events = (ObjEvent*)realloc(chunk->events, chunk->eventCapacity * sizeof(ObjEvent));
+        if(chunk->events == NULL){
+            printf(TEXT_COLOR_ERROR "Failed to allocate memory for obj parsing" TEXT_COLOR_RESET "\n");
+            exit(1);
+        }
+    }
+    ObjEvent* event = &chunk->events[chunk->eventCount++];
+    event->type = type;
+    event->line = line;
+    event->lineLength = lineEnd - line;
+    event->faceLineCount = faceLineCount;
+}
+
+/**
+ * Second pass: parse each chunk straight into the shared arrays at its bases. Relative indices resolve
+ * against the bases too, so the result is the same as a sequential parse.
+ */
+static void obj_parseChunks(void* data, int start, int end){
+    ObjParseJob* job = (ObjParseJob*)data;
+    for(int i = start; i < end; i++){
+        ObjChunk* chunk = &job->chunks[i];
+        int counts[3] = {chunk->positionBase, chunk->uvBase, chunk->normalBase}; // v, vt & vn read so far
+        int cornerCount = chunk->cornerBase;
+        int faceLineCount = chunk->cornerBase / 3;
+        const char* p = chunk->start;
+        while(p < chunk->end){
+            const char* lineEnd;
+            const char* line = obj_nextLine(&p, chunk->end, &lineEnd);
+            ObjLineType type = obj_lineType(line, lineEnd);
+            switch(type){
+                case OBJ_LINE_POSITION:
+                    obj_parseFloats(line + 1, lineEnd, &job->vArr[counts[0]++ * 3], 3);
+                    break;
+                case OBJ_LINE_UV:
+                    obj_parseFloats(line + 2, lineEnd, &job->tArr[counts[1]++ * 2], 2);
+                    break;
+                case OBJ_LINE_NORMAL:
+                    obj_parseFloats(line + 2, lineEnd, &job->nArr[counts[2]++ * 3], 3);
+                    break;
+                // f: face indicies, 
+                // Can be : f 1/1/1 2/2/2 3/3/3
+                // or       f 1//1 2//2 3//3
+                // or       f 1//1 2//2 3//3 4//4  <- quad
+                case OBJ_LINE_FACE:
+                    obj_parseFaceLine(line + 1, lineEnd, counts, job->vf, job->tf, job->vn, &cornerCount, chunk->cornerBase + chunk->cornerCount, &faceLineCount);
+                    break;
+                case OBJ_LINE_MTLLIB:
+                case OBJ_LINE_OBJECT:
+                case OBJ_LINE_GROUP:
+                case OBJ_LINE_USEMTL:
+                    obj_addEvent(chunk, type, line, lineEnd, faceLineCount);
+                    break;
+                default:
+                    break;
+            }
+        }
+        ASSERT(cornerCount == chunk->cornerBase + chunk->cornerCount, "obj chunk parsed a different number of corners than counted");
+    }
+}
+
+/**
+ * Start a new object in objGroup at faceLineCount, closing the previous one.
+ * The name is the whole "o ..." / "usemtl ..." line. objData is sized by obj_countObjects.
+ */
+static void obj_beginObject(ObjGroup* objGroup, Arena* arena, const char* line, size_t lineLength, int faceLineCount, int* faceLineCountStart, int* faceLineCountEnd){
+    ObjData* objData = &objGroup->objData[objGroup->objectCount];
+    objData->name = (char*)arena_Alloc(arena, (lineLength + 1) * sizeof(char));
+    memcpy(objData->name, line, lineLength);
+    objData->name[lineLength] = '\0';
+    printf(TEXT_COLOR_BLUE "new object: %s" TEXT_COLOR_RESET "\n", objData->name);
+
+    faceLineCountStart[objGroup->objectCount] = faceLineCount;
+    if(objGroup->objectCount > 0){
+        faceLineCountEnd[objGroup->objectCount - 1] = faceLineCount;
+    }
+    objGroup->objectCount++;
+}
+
+/**
+ * Objects the events will create, same rules as the replay in obj_importFile.
+ */
+static int obj_countObjects(ObjChunk* chunks, int chunkCount){
+    int objectCount = 0;
+    bool grouping = false;
+    for(int i = 0; i < chunkCount; i++){
+        for(int j = 0; j < chunks[i].eventCount; j++){
+            ObjLineType type = chunks[i].events[j].type;
+            if(type == OBJ_LINE_GROUP){
+                grouping = true;
+            }
+            if(type == OBJ_LINE_OBJECT || (type == OBJ_LINE_USEMTL && grouping)){
+                objectCount++;
+            }
+        }
+    }
+    return objectCount;
+}
+
+/**
+ * Dedupe & optimize objects [start, end), runs on job threads.
+ */
+static void obj_buildObjects(void* data, int start, int end){
+    ObjBuildJob* job = (ObjBuildJob*)data;
+    ObjParseJob* parse = job->parse;
+    for(int i = start; i < end; i++){
+        ObjData* objData = &job->objGroup->objData[i];
+        obj_buildIndexedMesh(objData, job->faceLineCountStart[i] * 3, job->faceLineCountEnd[i] * 3, parse->vf, parse->tf, parse->vn, parse->vArr, parse->tArr, parse->nArr, job->positionCount, job->uvCount, job->normalCount);
+        obj_optimizeMesh(objData, &job->before[i], &job->after[i]);
     }
-    return -1;
 }
 
-// Limit set to 100 o objects !. No indicies created.
 // Collects vertices position(vArr),uv/texcoords(tArr) , vertex indices(vf) ,texture indices(tf), normal indices(vn) ,material and object.
-// Then uses these and creates a new vertex data 
+// Then uses these and creates deduplicated vertex data + indices per object (obj_buildIndexedMesh)
 // final attribute looking like this: x, y ,z, u ,v, nx, ny, nz
-// We convert quad to two triangles (handleLineFace) and add one to faceLineCount.
+// The file is mapped and tokenized in place (obj_parseFloat etc), polygons become triangle fans (obj_parseFaceLine).
+// Parsing runs on the job system in chunks split at line ends:
+// 1. count v/vt/vn/triangle corners per chunk, prefix sum into where each chunk writes
+// 2. parse every chunk into the shared arrays, o/g/usemtl/mtllib lines are kept as events
+// 3. replay the events in file order, usemtl only records the material name
+// 4. build & optimize the objects in parallel
+// No fixed limits, everything up to the final meshes lives in the scratch arena and is rewound at the end.
+// Only the objGroup, object names, vertices & indices go to the given arena.
+// The result is cached in <file>.meshcache (meshcache.h), an up to date cache skips all of the above.
+// Import touches no GL & no globals, so it runs on a job thread for async loads (loader.h).
+// obj_bindMaterials then parses the .mtl & resolves the material names on the main thread.
 // Support to handle facelines with and without texture data. Example: f 1/2/3 4/5/6 7/8/9 or f 7//7 8//8 9//9
 // obj specification: https://paulbourke.net/dataformats/obj/ 
 // mtl specification: https://paulbourke.net/dataformats/mtl/
 // & https://en.wikipedia.org/wiki/Wavefront_.obj_file
-ObjGroup* obj_loadFile(const char *filepath)
+ObjGroup* obj_importFile(const char* filepath, Arena* arena, Arena* scratch)
 {
-    // How many vertices can we store in the obj file
-    #define OBJDATA_MAX 300001
+    PROFILE_BEGIN("obj_importFile");
+    ObjGroup* cached = meshcache_load(filepath, arena);
+    if(cached != NULL){
+        PROFILE_END();
+        return cached;
+    }
+    ArenaMark scratchMark = arena_mark(scratch);
     
-    // Allocate memory for the vertex data parsing
-    // TODO: Setup some tempArena to store this memory, since it's only used during parsing.
-    int* vf = (int*)arena_Alloc(&globals.assetArena, OBJDATA_MAX * sizeof(int));
-    int* tf = (int*)arena_Alloc(&globals.assetArena, OBJDATA_MAX * sizeof(int));
-    int* vn = (int*)arena_Alloc(&globals.assetArena, OBJDATA_MAX * sizeof(int));
-    float* vArr = (float*)arena_Alloc(&globals.assetArena, OBJDATA_MAX * sizeof(float));
-    float* tArr = (float*)arena_Alloc(&globals.assetArena, OBJDATA_MAX * sizeof(float));
-    float* nArr = (float*)arena_Alloc(&globals.assetArena, OBJDATA_MAX * sizeof(float));
+    // Straight from the asset pack when it has the file, otherwise mapped.
+    MappedFile file = {0};
+    PackView view;
+    if(pack_find(filepath, &view)){
+        file.data = (void*)view.data;
+        file.size = view.size;
+    }else if(!mapFile(filepath, &file)){
+        printf(TEXT_COLOR_ERROR "Error opening file %s" TEXT_COLOR_RESET "\n", filepath);
+        exit(1);
+    }
+    const char* fileStart = (const char*)file.data;
+    const char* fileEnd = fileStart + file.size;
+
+    // A few chunks per thread so stealing evens out uneven chunks, small files stay in one.
+    int chunkCount = (int)(file.size / OBJ_CHUNK_MIN_SIZE);
+    int maxChunks = (jobs_workerCount() + 1) * 4;
+    if(chunkCount > maxChunks) chunkCount = maxChunks;
+    if(chunkCount > OBJ_MAX_CHUNKS) chunkCount = OBJ_MAX_CHUNKS;
+    if(chunkCount < 1) chunkCount = 1;
+    ObjChunk chunks[OBJ_MAX_CHUNKS];
+    memset(chunks, 0, chunkCount * sizeof(ObjChunk));
+    const char* chunkStart = fileStart;
+    for(int i = 0; i < chunkCount; i++){
+        const char* chunkEnd = fileEnd;
+        if(i < chunkCount - 1){
+            chunkEnd = fileStart + file.size / chunkCount * (i + 1);
+            if(chunkEnd < chunkStart){
+                chunkEnd = chunkStart;
+            }
+            const char* newline = memchr(chunkEnd, '\n', fileEnd - chunkEnd);
+            chunkEnd = newline != NULL ? newline + 1 : fileEnd;
+        }
+        chunks[i].start = chunkStart;
+        chunks[i].end = chunkEnd;
+        chunkStart = chunkEnd;
+    }
+    ObjParseJob parse;
+    parse.chunks = chunks;
+
+    PROFILE_BEGIN("obj_countChunks");
+    jobs_parallelFor(chunkCount, 1, obj_countChunks, &parse);
+    PROFILE_END();
+
+    int64_t positionCount = 0;
+    int64_t uvCount = 0;
+    int64_t normalCount = 0;
+    int64_t cornerCount = 0;
+    for(int i = 0; i < chunkCount; i++){
+        chunks[i].positionBase = (int)positionCount;
+        chunks[i].uvBase = (int)uvCount;
+        chunks[i].normalBase = (int)normalCount;
+        chunks[i].cornerBase = (int)cornerCount;
+        positionCount += chunks[i].positionCount;
+        uvCount += chunks[i].uvCount;
+        normalCount += chunks[i].normalCount;
+        cornerCount += chunks[i].cornerCount;
+    }
+    if(positionCount > INT_MAX / 3 || uvCount > INT_MAX / 3 || normalCount > INT_MAX / 3 || cornerCount > INT_MAX){
+        printf(TEXT_COLOR_ERROR "Error: %s has more elements than an int can index" TEXT_COLOR_RESET "\n", filepath);
+        exit(1);
+    }
+
+    // Parse stage memory, exact sizes from the count pass
+    parse.vArr = (float*)arena_Alloc(scratch, positionCount * 3 * sizeof(float));
+    parse.tArr = (float*)arena_Alloc(scratch, uvCount * 2 * sizeof(float));
+    parse.nArr = (float*)arena_Alloc(scratch, normalCount * 3 * sizeof(float));
+    parse.vf = (int*)arena_Alloc(scratch, cornerCount * sizeof(int));
+    parse.tf = (int*)arena_Alloc(scratch, cornerCount * sizeof(int));
+    parse.vn = (int*)arena_Alloc(scratch, cornerCount * sizeof(int));
+
+    PROFILE_BEGIN("obj_parseChunks");
+    jobs_parallelFor(chunkCount, 1, obj_parseChunks, &parse);
+    PROFILE_END();
+    int faceLineCount = (int)(cornerCount / 3);
 
     // An obj can have multiple objects. Every object gets placed in objData. All objData gets placed in a objGroup.
     // This objGroup is what is returned.
-    ObjGroup* objGroup = (ObjGroup*)arena_Alloc(&globals.assetArena, sizeof(ObjGroup));
-    objGroup->name = (char*)arena_Alloc(&globals.assetArena, 100 * sizeof(char)); // TODO: unneccessary?
+    int objectCapacity = obj_countObjects(chunks, chunkCount);
+    if(objectCapacity == 0){
+        objectCapacity = 1;
+    }
+    ObjGroup* objGroup = (ObjGroup*)arena_Alloc(arena, sizeof(ObjGroup));
     objGroup->name = filepath;
-    objGroup->objData = (ObjData*)arena_Alloc(&globals.assetArena, globals.objDataCapacity * sizeof(ObjData));
+    objGroup->objData = (ObjData*)arena_Alloc(arena, objectCapacity * sizeof(ObjData));
+    memset(objGroup->objData, 0, objectCapacity * sizeof(ObjData));
     objGroup->objectCount = 0;
-   
-    int vIndex = 0;
-    int uvCount = 0;
-    int normalCount = 0;
-    int vfCount = 0;
-    int tfCount = 0;
-    int vnCount = 0;
-
-    int faceLineCount = 0;
+    objGroup->hasMtllib = false;
 
     // Keeps track of where objects faceLineCount.
-    int faceLineCountStart[10000];// = {0};// 100 is max num of object
-    int faceLineCountEnd[10000];// = {0};   // 100 is max num of object
-    //char group[100]; // Not used/implemented
-    bool grouping = false;
-    
-    FILE* fp;
-    char line[1024];
+    int* faceLineCountStart = (int*)arena_Alloc(scratch, objectCapacity * sizeof(int));
+    int* faceLineCountEnd = (int*)arena_Alloc(scratch, objectCapacity * sizeof(int));
 
-    fp = fopen(filepath, "r");
-    if(fp == NULL) {
-        printf(TEXT_COLOR_ERROR "Error opening file %s" TEXT_COLOR_RESET "\n", filepath);
-        exit(1);
-    }
-    
-    while (fgets(line, sizeof line, fp) != NULL){
-   //  printf(TEXT_COLOR_ERROR "line %s" TEXT_COLOR_RESET "\n", line);
-        
-        // comment
-        if((int)line[0] == 35){
-            continue;
-        }
-        // newline
-        if((int)line[0] == 10){
-            continue;
-        }
-        // m, check for mtllib
-        if((int)line[0] == 109){
-            if(strncmp(line, "mtllib", 6) == 0){
-               // NOTE: We don't actually use mtllib name yet. We just use filepath and change to .mtl.
-                obj_parseMaterial(filepath);
-            }
-            continue;
-        }
-        // o, object
-        if((int)line[0] == 111){
-            printf(TEXT_COLOR_BLUE "new object: %s" TEXT_COLOR_RESET , line);
-            size_t lineLength = strlen(line);
-            if(lineLength >= 100){
-                printf("Error: Object name too long. Exiting..");
-                exit(1);
-            }
-          //  printf("--------------------\n");
-            printf("objGroup->objectCount %d\n",objGroup->objectCount);
-            // Object name
-            objGroup->objData[objGroup->objectCount].name = (char*)arena_Alloc(&globals.assetArena, lineLength * sizeof(char));
-            for(int i = 0; i < lineLength; i++){
-                objGroup->objData[objGroup->objectCount].name[i] = line[i];
-            }  
-            objGroup->objData[objGroup->objectCount].name[lineLength-1] = '\0'; // Null terminate the string
-         //   printf("new o object: %s\n", objGroup->objData[objGroup->objectCount].name);
-            
-            faceLineCountStart[objGroup->objectCount] = faceLineCount; 
-            if(objGroup->objectCount > 0){
-                ASSERT(faceLineCount > 0, "Error: faceLineCount is 0 or less");
-                ASSERT(faceLineCount < 100000, "Error: faceLineCount is too large");
-                int pi = (int)(objGroup->objectCount-1);
-                faceLineCountEnd[pi] = faceLineCount; 
-                int num_faceLineCountCurrentObject = (int)faceLineCountEnd[pi] - (int)faceLineCountStart[pi];
-                objGroup->objData[pi].num_of_vertices =  (num_faceLineCountCurrentObject * 3);  
-            }
-            objGroup->objectCount++;
-            if(objGroup->objectCount > globals.objDataCapacity){
-                printf("Error: Too many objects ,adjust globals.objDataCapacity. Exiting..");
-                exit(1);
-            }
-        }
-        // g, grouping, read in the groups
-        if((int)line[0] == 103){
-            // printf(TEXT_COLOR_MAGENTA "new group: %s" TEXT_COLOR_RESET , line);
-             grouping = true;
-           /*  size_t lineLength = strlen(line);
-            if(lineLength >= 100){
-                printf("Error: Object name too long. Exiting..");
-                exit(1);
-            }
-            printf("objGroup->objectCount %d\n",objGroup->objectCount);
-            objGroup->objData[objGroup->objectCount].name = (char*)arena_Alloc(&globals.assetArena, lineLength * sizeof(char));
-            for(int i = 0; i < lineLength; i++){
-                objGroup->objData[objGroup->objectCount].name[i] = line[i];
-            }  
-            objGroup->objData[objGroup->objectCount].name[lineLength-1] = '\0'; // Null terminate the string
-             faceLineCountStart[objGroup->objectCount] = faceLineCount; 
-            if(objGroup->objectCount > 0){
-                ASSERT(faceLineCount > 0, "Error: faceLineCount is 0 or less");
-                ASSERT(faceLineCount < 100000, "Error: faceLineCount is too large");
-                int pi = (int)(objGroup->objectCount-1);
-                faceLineCountEnd[pi] = faceLineCount; 
-                int num_faceLineCountCurrentObject = (int)faceLineCountEnd[pi] - (int)faceLineCountStart[pi];
-                objGroup->objData[pi].num_of_vertices =  (num_faceLineCountCurrentObject * 3);  
-            }
-            objGroup->objectCount++;
-            if(objGroup->objectCount > globals.objDataCapacity){
-                printf("Error: Too many objects ,adjust globals.objDataCapacity. Exiting..");
-                exit(1);
-            } */
-         /*    for(int i = 2; i < strlen(line); i++){
-                group[i-2] = line[i];
-            } */
-            continue;
-        }
-        // u, check for usemtl
-        if((int)line[0] == 117){
-            if(strncmp(line, "usemtl", 6) == 0){
-
-                if(grouping){
-                     size_t lineLength = strlen(line);
-                    if(lineLength >= 100){
-                        printf("Error: Object name too long. Exiting..");
-                        exit(1);
-                    }
-                    printf("usemtl objGroup->objectCount %d\n",objGroup->objectCount);
-                    objGroup->objData[objGroup->objectCount].name = (char*)arena_Alloc(&globals.assetArena, lineLength * sizeof(char));
-                    for(int i = 0; i < lineLength; i++){
-                        objGroup->objData[objGroup->objectCount].name[i] = line[i];
-                    }  
-                    objGroup->objData[objGroup->objectCount].name[lineLength-1] = '\0'; // Null terminate the string
-                    faceLineCountStart[objGroup->objectCount] = faceLineCount; 
-                    if(objGroup->objectCount > 0){
-                        ASSERT(faceLineCount > 0, "Error: faceLineCount is 0 or less");
-                        ASSERT(faceLineCount < 100000, "Error: faceLineCount is too large");
-                        int pi = (int)(objGroup->objectCount-1);
-                        faceLineCountEnd[pi] = faceLineCount; 
-                        int num_faceLineCountCurrentObject = (int)faceLineCountEnd[pi] - (int)faceLineCountStart[pi];
-                        objGroup->objData[pi].num_of_vertices =  (num_faceLineCountCurrentObject * 3);  
+    // Objects & materials in file order
+    bool grouping = false;
+    for(int i = 0; i < chunkCount; i++){
+        for(int j = 0; j < chunks[i].eventCount; j++){
+            ObjEvent* event = &chunks[i].events[j];
+            switch(event->type){
+                case OBJ_LINE_MTLLIB:
+                    // NOTE: We don't actually use mtllib name yet. obj_bindMaterials just uses filepath and changes it to .mtl.
+                    objGroup->hasMtllib = true;
+                    break;
+                case OBJ_LINE_OBJECT:
+                    obj_beginObject(objGroup, arena, event->line, event->lineLength, event->faceLineCount, faceLineCountStart, faceLineCountEnd);
+                    break;
+                // g, grouping. Groups aren't objects of their own, but with groups every usemtl starts a new object.
+                case OBJ_LINE_GROUP:
+                    grouping = true;
+                    break;
+                case OBJ_LINE_USEMTL: {
+                    if(grouping){
+                        obj_beginObject(objGroup, arena, event->line, event->lineLength, event->faceLineCount, faceLineCountStart, faceLineCountEnd);
                     }
-                    objGroup->objectCount++;
-               
-                 
-                    if(objGroup->objectCount > globals.objDataCapacity){
-                        printf("Error: Too many objects ,adjust globals.objDataCapacity. Exiting..");
-                        exit(1);
+                    const char* lineEnd = event->line + event->lineLength;
+                    const char* nameStart = obj_skipSpaces(event->line + 6, lineEnd);
+                    const char* nameEnd = nameStart;
+                    while(nameEnd < lineEnd && *nameEnd != ' ' && *nameEnd != '\t'){
+                        nameEnd++;
                     }
+                    ASSERT(objGroup->objectCount-1 >= 0, "Error: No object to assign material to");
+                    size_t nameLength = nameEnd - nameStart;
+                    char* materialName = (char*)arena_Alloc(arena, nameLength + 1);
+                    memcpy(materialName, nameStart, nameLength);
+                    materialName[nameLength] = '\0';
+                    objGroup->objData[objGroup->objectCount-1].materialName = materialName;
+                    break;
                 }
-
-               // size_t lineLength = strlen(line);
-                char *token = strtok(line, " ");
-                token = strtok(NULL, " ");
-                token[strlen(token)] = '\0';
-                int matIndex = getMaterialByName(token);
-                ASSERT(objGroup->objectCount-1 >= 0, "Error: No object to assign material to");
-           //     printf("object tp assign mtl: %s\n", objGroup->objData[objGroup->objectCount-1].name);
-         //       printf("usemtl:::: %s %d\n", token, matIndex);
-                ASSERT(matIndex >= 0, "Missing material");
-                objGroup->objData[objGroup->objectCount-1].materialIndex = matIndex;
+                default:
+                    break;
             }
-            continue;
-        }
-        // v: v & space(32), read vertices
-        if((int)line[0] == 118 && (int)line[1] == 32){
-          //  printf(TEXT_COLOR_ERROR "v %s" TEXT_COLOR_RESET "\n", line);
-          sscanf(line, "v %f %f %f", &vArr[vIndex], &vArr[vIndex+1], &vArr[vIndex+2]);
-          vIndex+=3;
-          continue;
         }
-        // vt: v & t, read texcoords(uv)
-        if((int)line[0] == 118 && (int)line[1] == 116){
-            char *token = strtok(line, " ");
-            token = strtok(NULL, " ");
-            tArr[uvCount] = strtof(token, NULL);
-            token = strtok(NULL, " ");
-            tArr[uvCount+1] = strtof(token, NULL);
-            uvCount+=2;
-            continue;
-        }
-        // vn: v & n, read normals
-        if((int)line[0] == 118 && (int)line[1] == 110){
-            char *token = strtok(line, " ");
-            token = strtok(NULL, " ");
-            nArr[normalCount] = strtof(token, NULL);
-            token = strtok(NULL, " ");
-            nArr[normalCount+1] = strtof(token, NULL);
-            token = strtok(NULL, " ");
-            nArr[normalCount+2] = strtof(token, NULL);
-            normalCount+=3;
-            continue;
-        }
-        // f: face indicies, 
-        // Can be : f 1/1/1 2/2/2 3/3/3
-        // or       f 1//1 2//2 3//3
-        // or       f 1//1 2//2 3//3 4//4  <- quad
-        if((int)line[0] == 102){
-           obj_handleFaceLine(line, vf, tf, vn, &vfCount, &tfCount, &vnCount, &faceLineCount);
-           if(vfCount >= OBJDATA_MAX || tfCount >= OBJDATA_MAX){
-                printf("Error: Too many vertices in obj file. OBJDATA_MAX exceeded. Exiting..");
-                printf("vfCount: %d\n", vfCount);
-                printf("tfCount: %d\n", tfCount);
-                exit(1);
-           }
-        }
-  
+        free(chunks[i].events);
+    }
+    if(!pack_contains(file.data)){
+        unmapFile(&file);
     }
-    fclose(fp);
 
-    if(objGroup->objectCount > 0){
-        // Input Last object
-        faceLineCountEnd[objGroup->objectCount-1] = faceLineCount;
-        objGroup->objData[objGroup->objectCount-1].num_of_vertices = (faceLineCountEnd[objGroup->objectCount-1] - faceLineCountStart[objGroup->objectCount-1]) * 3;
-      
-    }else {
-        // If file contain o object, this was specified there. But if not, we need to create a default object here.
-        objGroup->objData[0].num_of_vertices = (faceLineCount * 3);
-        objGroup->objData[0].vertexData = (Vertex*)arena_Alloc(&globals.assetArena, objGroup->objData[0].num_of_vertices * sizeof(Vertex));
+    // If file contain o object, objects were specified there. But if not, we need to create a default object here.
+    if(objGroup->objectCount == 0){
+        objGroup->objData[0].name = (char*)arena_Alloc(arena, strlen(filepath) + 1);
+        strcpy(objGroup->objData[0].name, filepath);
+        faceLineCountStart[0] = 0;
+        objGroup->objectCount = 1;
     }
-    
-    // Allocate memory for the vertex data in objData
-    if(objGroup->objectCount > 0){
-        for(int i = 0; i < objGroup->objectCount; i++){
-            objGroup->objData[i].vertexData = (Vertex*)arena_Alloc(&globals.assetArena, objGroup->objData[i].num_of_vertices * sizeof(Vertex));
-        }
+    // Input Last object
+    faceLineCountEnd[objGroup->objectCount-1] = faceLineCount;
+
+    ObjBuildJob build;
+    build.objGroup = objGroup;
+    build.faceLineCountStart = faceLineCountStart;
+    build.faceLineCountEnd = faceLineCountEnd;
+    build.parse = &parse;
+    build.positionCount = (int)positionCount;
+    build.uvCount = (int)uvCount;
+    build.normalCount = (int)normalCount;
+    build.before = (MeshCacheStats*)arena_Alloc(scratch, objGroup->objectCount * sizeof(MeshCacheStats));
+    build.after = (MeshCacheStats*)arena_Alloc(scratch, objGroup->objectCount * sizeof(MeshCacheStats));
+    PROFILE_BEGIN("obj_buildObjects");
+    jobs_parallelFor(objGroup->objectCount, 1, obj_buildObjects, &build);
+    PROFILE_END();
+
+    // Finished meshes go to the arena, the job threads can't allocate from it.
+    for(int i = 0; i < objGroup->objectCount; i++){
+        ObjData* objData = &objGroup->objData[i];
+        Vertex* vertexData = (Vertex*)arena_Alloc(arena, objData->num_of_vertices * sizeof(Vertex));
+        GLuint* indices = (GLuint*)arena_Alloc(arena, objData->num_of_indices * sizeof(GLuint));
+        memcpy(vertexData, objData->vertexData, objData->num_of_vertices * sizeof(Vertex));
+        memcpy(indices, objData->indices, objData->num_of_indices * sizeof(GLuint));
+        free(objData->vertexData);
+        free(objData->indices);
+        objData->vertexData = vertexData;
+        objData->indices = indices;
+        printf("%s: %d triangles, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", objData->name, objData->num_of_indices / 3, build.before[i].acmr, build.after[i].acmr, build.before[i].atvr, build.after[i].atvr);
     }
+    arena_rewind(scratch, scratchMark);
+    meshcache_save(filepath, objGroup);
 
-    // TODO: use this structure instead for filling vertex data?. The problem is that it is not working.
-    //for (int i = 0; i < objGroup->objectCount; i++) {                                    <---  loop over objects
-    //    for (int j = faceLineCountStart[i]; j < faceLineCountEnd[i]; j++) {              <---  loop over faces
-    //  for(int k = 0; k < 3; k++){                                                        <---  loop over vertices 
-    // NOTE: Atm we fill vertexData in only objData[0] in objGroup. Somehow this works and we can access and use objData[1], objData[2] etc. 
-    // when creatObject is called. I presume this is because of the arena_Alloc and the memory is allocated in the same memory block,so it is accessible.
-    // But why can't we directly fill objData[1], objData[2] etc. with vertexData?. This is a unsolved mystery.
-        
-    // Fill vertex data
-    int vertexIndex = 0;
-    for(int j = 0; j < faceLineCount; j+=1){ 
-
-        for(int i = 0; i < 3; i++){
-        
-            // x y z
-            objGroup->objData[0].vertexData[vertexIndex].position[0] = vArr[(vf[vertexIndex]-1)*3];
-            objGroup->objData[0].vertexData[vertexIndex].position[1] = vArr[(vf[vertexIndex]-1)*3+1];
-            objGroup->objData[0].vertexData[vertexIndex].position[2] = vArr[(vf[vertexIndex]-1)*3+2];
-           
-            // color, default to black atm
-            objGroup->objData[0].vertexData[vertexIndex].color[0] = 1.0; 
-            objGroup->objData[0].vertexData[vertexIndex].color[1] = 1.0;
-            objGroup->objData[0].vertexData[vertexIndex].color[2] = 1.0;
-           
-            // uv
-            if(uvCount == 0){
-                objGroup->objData[0].vertexData[vertexIndex].texcoord[0] = 0.0;
-                objGroup->objData[0].vertexData[vertexIndex].texcoord[1] = 0.0;
-            }else {
-                objGroup->objData[0].vertexData[vertexIndex].texcoord[0] = tArr[(tf[vertexIndex]-1)*2];
-                objGroup->objData[0].vertexData[vertexIndex].texcoord[1] = tArr[(tf[vertexIndex]-1)*2+1];
-            }
+  PROFILE_END();
+  return objGroup;
+}
 
-            // normals
-            if(vnCount == 0){
-                objGroup->objData[0].vertexData[vertexIndex].normal[0] = 0.0;
-                objGroup->objData[0].vertexData[vertexIndex].normal[1] = 0.0;
-                objGroup->objData[0].vertexData[vertexIndex].normal[2] = 0.0;
-            }else {
-                objGroup->objData[0].vertexData[vertexIndex].normal[0] = nArr[(vn[vertexIndex]-1)*3];
-                objGroup->objData[0].vertexData[vertexIndex].normal[1] = nArr[(vn[vertexIndex]-1)*3+1];
-                objGroup->objData[0].vertexData[vertexIndex].normal[2] = nArr[(vn[vertexIndex]-1)*3+2]; 
-            }
-            vertexIndex++;
+/**
+ * Parse the .mtl of an imported obj & point its objects at the materials. Main thread, textures are GL objects.
+ * Objects whose material isn't in the .mtl get material 0.
+ */
+void obj_bindMaterials(ObjGroup* objGroup){
+    if(objGroup->hasMtllib){
+        obj_parseMaterial(objGroup->name);
+    }
+    for(int i = 0; i < objGroup->objectCount; i++){
+        ObjData* objData = &objGroup->objData[i];
+        if(objData->materialName == NULL){
+            continue;
+        }
+        objData->materialIndex = getMaterialByName(objData->materialName);
+        if(objData->materialIndex < 0){
+            printf(TEXT_COLOR_WARNING "%s: missing material %s\n" TEXT_COLOR_RESET, objGroup->name, objData->materialName);
+            objData->materialIndex = 0;
         }
     }
+}
 
-  return objGroup;
+/**
+ * Import an obj file into the asset arena & bind its materials, blocks until done. loader_loadModel is the async version.
+ */
+ObjGroup* obj_loadFile(const char *filepath)
+{
+    PROFILE_BEGIN("obj_loadFile");
+    ObjGroup* objGroup = obj_importFile(filepath, &globals.assetArena, &globals.scratchArena);
+    obj_bindMaterials(objGroup);
+    PROFILE_END();
+    return objGroup;
 }
 
 // Function to convert an integer to a string and append ".png"
@@ -987,11 +1645,22 @@ void intToPngFilename(int number, char* buffer, size_t bufferSize) {
 
 // Function to change the cursor
 void changeCursor(SDL_SystemCursor cursorType) {
-    SDL_Cursor* cursor = SDL_CreateSystemCursor(cursorType);
-    if (cursor != NULL) {
-        SDL_SetCursor(cursor);
-    } else {
-        fprintf(stderr, "Failed to create cursor: %s\n", SDL_GetError());
+    // Created once per type, called every frame.
+    static SDL_Cursor* cursors[SDL_NUM_SYSTEM_CURSORS] = {0};
+    static SDL_Cursor* current = NULL;
+    if (SDL_WasInit(SDL_INIT_VIDEO) == 0) {
+        return; // headless, no cursor to change
+    }
+    if (cursors[cursorType] == NULL) {
+        cursors[cursorType] = SDL_CreateSystemCursor(cursorType);
+        if (cursors[cursorType] == NULL) {
+            fprintf(stderr, "Failed to create cursor: %s\n", SDL_GetError());
+            return;
+        }
+    }
+    if (cursors[cursorType] != current) {
+        SDL_SetCursor(cursors[cursorType]);
+        current = cursors[cursorType];
     }
 }
 
@@ -1061,20 +1730,8 @@ void captureDrawCalls(int width, int height, int drawCallsCounter) {
     char filename[20];
     intToPngFilename(drawCallsCounter, filename, sizeof(filename));
 
-    GLubyte* pixels = (GLubyte*)malloc(3 * width * height);
-    if (!pixels) {
-        fprintf(stderr, "Failed to allocate memory for pixels\n");
-        return;
-    }
-    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
-
-    // Flip y
-    stbi_flip_vertically_on_write(1);
-
-    // Save the pixels to an image file (e.g., using stb_image_write)
-    stbi_write_png(filename, width, height, 3, pixels, width * 3);
-
-    free(pixels);
+    // Read back & png encoding happen off the render thread.
+    capture_readPixels(width, height, filename, CAPTURE_FORMAT_PNG);
 }
 
 /**
@@ -1092,16 +1749,6 @@ TextureData loadTexture(char* path) {
     return textureData;
 }
 
-int addMaterial(Material material){
-    globals.materials[globals.materialsCount] = material;
-    globals.materialsCount++;
-    return globals.materialsCount-1;
-}
-Material* getMaterial(int index){
-    ASSERT(index < globals.materialsCount && index >= 0, "Material index out of bounds or not assigned");
-    return &globals.materials[index];
-}
-
 void vec3_subtract(vec3 a, vec3 b, vec3* result){
     (*result)[0] = a[0] - b[0];
     (*result)[1] = a[1] - b[1];
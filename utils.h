@@ -6,6 +6,7 @@
 #include "stb_image.h"
 #include <string.h>
 #include "types.h"
+#include "materials.h"
 #include <SDL2/SDL.h>
 
 // Text output colors
@@ -13,6 +14,8 @@
 #define TEXT_COLOR_WARNING   "\x1b[33m"
 #define TEXT_COLOR_RESET     "\x1b[0m"
 
+#define HASH_SEED 14695981039346656037ull // FNV-1a 64 offset basis, start value for hashBytes
+
 #define TEXT_COLOR_YELLOW "\033[1;33m"
 #define TEXT_COLOR_BLUE "\033[1;34m"
 #define TEXT_COLOR_GREEN "\033[1;32m"
@@ -32,7 +35,18 @@ SDLVector2 convertUIToSDL(UIVector2 v,int screenWidth,int screenHeight);
 UIVector2 convertSDLToUI(SDLVector2 v, int screenWidth, int screenHeight);
 float absValue(float value);
 Color hexToColor(const char* hex);
-char* readFile(const char *filename);
+const char* readFile(const char *filename);
+void freeFile(const char* data);
+bool mapFile(const char* path, MappedFile* file);
+void unmapFile(MappedFile* file);
+bool getFileInfo(const char* path, uint64_t* size, int64_t* modified);
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size);
+bool hashFile(const char* path, uint64_t* hash);
+bool getSourceStamp(const char* path, SourceStamp* stamp);
+bool sourceStampMatches(const char* sourcePath, const SourceStamp* stamp, const char* cachePath, long stampOffset);
+FILE* openReplacingFile(const char* path, char* tempPath, size_t tempPathSize);
+bool closeReplacingFile(FILE* fp, const char* tempPath, const char* path, bool written);
+void canonicalPath(const char* path, char* out, size_t outSize);
 unsigned char* loadImage(const char* filename, int* width, int* height, int* nrChannels);
 TextureData loadTexture(char* path);
 int randInt(int rmin, int rmax);
@@ -43,12 +57,15 @@ Rectangle convertViewRectangleToSDLCoordinates(View view,int windowHeight);
 void convertUIcoordinateToWindowcoordinates(View view, TransformComponent* transformComponent, int windowHeight,int windowWidth,vec2 convertedPoint);
 void captureDrawCalls(int width, int height, int drawCallsCounter);
 float deg2rad(float degrees);
-GLuint setupTexture(TextureData textureData);
+GLuint setupTexture(TextureData textureData, TextureParams params);
 void changeCursor(SDL_SystemCursor cursorType); 
 
 // Memory
 void arena_initMemory(Arena* arena, size_t size);
+void arena_initScratch(Arena* arena, size_t size);
 void* arena_Alloc(Arena* arena, size_t size);
+ArenaMark arena_mark(Arena* arena);
+void arena_rewind(Arena* arena, ArenaMark mark);
 void arena_reset(Arena* arena); // Not evaluated/used yet, do this before using.
 void arena_free(Arena* arena);  // Not evaluated/used yet, do this before using.
 
@@ -66,18 +83,15 @@ void arena_free(Arena* arena);  // Not evaluated/used yet, do this before using.
 #endif
 #define DEG_TO_RAD(degrees) ((degrees) * (M_PI / 180.0f))
 
-// Materials
-int getMaterialByName(const char* name);
-int addMaterial(Material material);
-Material* getMaterial(int index);
 
 // Parse obj files
 void obj_runTests();
-void obj_handleFaceLine(char* line, int* vf, int* tf, int* vn, int* vfCount, int* tfCount, int* vnCount, int* faceLineCount);
 char* obj_handleFilePath(const char* filepath);
 ObjGroup* obj_loadFile(const char* filepath);
+ObjGroup* obj_importFile(const char* filepath, Arena* arena, Arena* scratch);
+void obj_bindMaterials(ObjGroup* objGroup);
 void obj_parseMaterial(const char* filepath);
-bool obj_processTextureMap(char* mtlLine,const char* mapType,GLuint* map);
+bool obj_processTextureMap(char* mtlLine,const char* mapType,MaterialMap mapKind,GLuint* map,char** path);
 
 // Math
 void vec3_subtract(vec3 a, vec3 b, vec3* result);